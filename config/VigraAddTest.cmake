@@ -7,6 +7,7 @@
 #
 # The function VIGRA_ADD_TEST
 # * creates a new executable for 'target', using the given sources and libraries
+#   (and the thread library found by FIND_PACKAGE(Threads), if any)
 # * makes the global target 'test' depend on the new 'target' (target 'test' must already exist)
 # * installs a post-build event that runs the test automatically after linking
 #
@@ -58,6 +59,10 @@ FUNCTION(VIGRA_ADD_TEST target)
     if(DEFINED LIBRARIES)
         TARGET_LINK_LIBRARIES(${target} ${LIBRARIES})
     endif()
+    # the parallel algorithms (threadpool.hxx) may require the thread library
+    if(CMAKE_THREAD_LIBS_INIT)
+        TARGET_LINK_LIBRARIES(${target} ${CMAKE_THREAD_LIBS_INIT})
+    endif()
     
     # find the test executable
     GET_TARGET_PROPERTY(${target}_executable ${target} LOCATION)
@@ -41,6 +41,8 @@
 #include "error.hxx"
 #include "array_vector.hxx"
 #include <queue>
+#include <functional>
+#include <algorithm>
 
 namespace vigra {
 
@@ -399,6 +401,180 @@ class PriorityQueue<ValueType, unsigned short, Ascending>
     {}
 };
 
+/** \brief Indexed heap with changeable priorities.
+
+    This priority queue holds items identified by integer indices in the
+    range <tt>[0, ..., max_size-1]</tt>. In contrast to \ref vigra::PriorityQueue,
+    the priority of an item can be changed (in both directions) and arbitrary
+    items can be removed in <tt>O(log n)</tt> time, because the queue keeps
+    track of each item's position in the heap. Like the other queues in this
+    file, <tt>ChangeablePriorityQueue\<PriorityType\></tt> returns the item with
+    the largest priority first, and <tt>ChangeablePriorityQueue\<PriorityType, true\></tt>
+    the item with the smallest priority.
+
+    <b>\#include</b> \<vigra/bucket_queue.hxx\><br>
+    Namespace: vigra
+*/
+template <class PriorityType,
+          bool Ascending = false>  // std::priority_queue is descending
+class ChangeablePriorityQueue
+{
+    typename IfBool<Ascending, std::less<PriorityType>,
+                               std::greater<PriorityType> >::type cmp_;
+    ArrayVector<std::ptrdiff_t> heap_;      // heap of item indices
+    ArrayVector<std::ptrdiff_t> positions_; // position of each item in heap_, or -1
+    ArrayVector<PriorityType> priorities_;
+
+  public:
+
+    typedef std::ptrdiff_t value_type;
+    typedef std::size_t size_type;
+    typedef PriorityType priority_type;
+
+        /** \brief Create an empty queue for items <tt>0 ... max_size-1</tt>.
+        */
+    ChangeablePriorityQueue(size_type max_size = 0)
+    : positions_(max_size, -1),
+      priorities_(max_size)
+    {}
+
+        /** \brief Number of elements in this queue.
+        */
+    size_type size() const
+    {
+        return heap_.size();
+    }
+
+        /** \brief Queue contains no elements.
+             Equivalent to <tt>size() == 0</tt>.
+        */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+        /** \brief Item \arg i is currently in the queue.
+        */
+    bool contains(value_type i) const
+    {
+        return positions_[i] >= 0;
+    }
+
+        /** \brief Current priority of item \arg i (which must be in the queue).
+        */
+    priority_type priority(value_type i) const
+    {
+        return priorities_[i];
+    }
+
+        /** \brief Index of the current top element.
+        */
+    value_type top() const
+    {
+        return heap_[0];
+    }
+
+        /** \brief Priority of the current top element.
+        */
+    priority_type topPriority() const
+    {
+        return priorities_[heap_[0]];
+    }
+
+        /** \brief Remove the current top element.
+        */
+    void pop()
+    {
+        remove(heap_[0]);
+    }
+
+        /** \brief Insert item \arg i with given \arg priority, or change
+            its priority if it is already in the queue.
+        */
+    void push(value_type i, priority_type priority)
+    {
+        if(contains(i))
+        {
+            changePriority(i, priority);
+            return;
+        }
+        priorities_[i] = priority;
+        positions_[i] = (std::ptrdiff_t)heap_.size();
+        heap_.push_back(i);
+        moveUp(positions_[i]);
+    }
+
+        /** \brief Set the priority of item \arg i (which must be in the queue)
+            to \arg priority.
+        */
+    void changePriority(value_type i, priority_type priority)
+    {
+        vigra_precondition(contains(i),
+            "ChangeablePriorityQueue::changePriority(): item is not in the queue.");
+        priorities_[i] = priority;
+        moveUp(positions_[i]);
+        moveDown(positions_[i]);
+    }
+
+        /** \brief Remove item \arg i from the queue (if it is contained).
+        */
+    void remove(value_type i)
+    {
+        if(!contains(i))
+            return;
+        std::ptrdiff_t pos = positions_[i],
+                       last = (std::ptrdiff_t)heap_.size() - 1;
+        swapItems(pos, last);
+        heap_.pop_back();
+        positions_[i] = -1;
+        if(pos < last)
+        {
+            moveUp(pos);
+            moveDown(pos);
+        }
+    }
+
+  private:
+    bool before(std::ptrdiff_t a, std::ptrdiff_t b) const
+    {
+        // true if the item at heap position a must be above the one at b
+        return cmp_(priorities_[heap_[a]], priorities_[heap_[b]]);
+    }
+
+    void swapItems(std::ptrdiff_t a, std::ptrdiff_t b)
+    {
+        std::swap(heap_[a], heap_[b]);
+        positions_[heap_[a]] = a;
+        positions_[heap_[b]] = b;
+    }
+
+    void moveUp(std::ptrdiff_t pos)
+    {
+        while(pos > 0 && before(pos, (pos-1) / 2))
+        {
+            swapItems(pos, (pos-1) / 2);
+            pos = (pos-1) / 2;
+        }
+    }
+
+    void moveDown(std::ptrdiff_t pos)
+    {
+        std::ptrdiff_t size = (std::ptrdiff_t)heap_.size();
+        for(;;)
+        {
+            std::ptrdiff_t child = 2*pos + 1;
+            if(child >= size)
+                break;
+            if(child + 1 < size && before(child + 1, child))
+                ++child;
+            if(!before(child, pos))
+                break;
+            swapItems(pos, child);
+            pos = child;
+        }
+    }
+};
+
 } // namespace vigra
 
 #endif // VIGRA_BUCKET_QUEUE_HXX
@@ -111,6 +111,10 @@
         #define VIGRA_HAS_UNIQUE_PTR
     #endif
     
+    #if _MSC_VER >= 1700
+        #define VIGRA_HAS_STD_THREADS
+    #endif
+    
     #define VIGRA_NEED_BIN_STREAMS
     
     #define VIGRA_NO_THREADSAFE_STATIC_INIT  // at least up to _MSC_VER <= 1600, probably higher
@@ -164,6 +168,7 @@
     
     #if defined(__GXX_EXPERIMENTAL_CXX0X__) || __cplusplus >= 201103L
         #define VIGRA_HAS_UNIQUE_PTR
+        #define VIGRA_HAS_STD_THREADS
     #endif
 
 #endif  // __GNUC__
@@ -242,6 +247,10 @@
     #define VIGRA_EXPORT
 #endif
 
+#if defined(VIGRA_NO_STD_THREADS) && defined(VIGRA_HAS_STD_THREADS)
+#  undef VIGRA_HAS_STD_THREADS
+#endif
+
 #ifdef VIGRA_HAS_UNIQUE_PTR
 #  define VIGRA_UNIQUE_PTR  std::unique_ptr
 #else
@@ -40,6 +40,7 @@
 #include <cmath>
 #include "stdimage.hxx"
 #include "multi_shape.hxx"
+#include "multi_distance.hxx"
 
 namespace vigra {
 
@@ -301,6 +302,11 @@ internalDistanceTransform(SrcImageIterator src_upperleft,
     
     If you use the L2 norm, the destination pixels must be real valued to give
     correct results.
+
+    All norms are computed exactly in linear time by the separable algorithms 
+    \ref separableMultiDistance(), \ref separableMultiDistanceL1() and 
+    \ref separableMultiDistanceLInf(), which also work for arrays of arbitrary
+    dimension.
     
     <b> Declarations:</b>
     
@@ -404,29 +410,38 @@ doxygen_overloaded_function(template <...> void distanceTransform)
 template <class SrcImageIterator, class SrcAccessor,
                    class DestImageIterator, class DestAccessor,
                    class ValueType>
-inline void
+void
 distanceTransform(SrcImageIterator src_upperleft, 
                 SrcImageIterator src_lowerright, SrcAccessor sa,
                 DestImageIterator dest_upperleft, DestAccessor da,
                 ValueType background, int norm)
 {
-    if(norm == 1)
+    int w = src_lowerright.x - src_upperleft.x;  
+    int h = src_lowerright.y - src_upperleft.y;  
+
+    // mark the objects and compute their distance with the
+    // separable algorithms of multi_distance.hxx
+    MultiArray<2, UInt8> objects(Shape2(w, h));
+    for(int y=0; y<h; ++y, ++src_upperleft.y)
     {
-        internalDistanceTransform(src_upperleft, src_lowerright, sa,
-                                  dest_upperleft, da, background,
-                                  InternalDistanceTransformL1NormFunctor());
+        SrcImageIterator sx = src_upperleft;
+        for(int x=0; x<w; ++x, ++sx.x)
+            objects(x, y) = sa(sx) != background ? 1 : 0;
     }
+
+    MultiArray<2, double> dist(Shape2(w, h));
+    if(norm == 1)
+        separableMultiDistanceL1(objects, dist, true);
     else if(norm == 2)
-    {
-        internalDistanceTransform(src_upperleft, src_lowerright, sa,
-                                  dest_upperleft, da, background,
-                                  InternalDistanceTransformL2NormFunctor());
-    }
+        separableMultiDistance(objects, dist, true);
     else
+        separableMultiDistanceLInf(objects, dist, true);
+
+    for(int y=0; y<h; ++y, ++dest_upperleft.y)
     {
-        internalDistanceTransform(src_upperleft, src_lowerright, sa,
-                                  dest_upperleft, da, background,
-                                  InternalDistanceTransformLInifinityNormFunctor());
+        DestImageIterator dx = dest_upperleft;
+        for(int x=0; x<w; ++x, ++dx.x)
+            da.set(dist(x, y), dx);
     }
 }
 
@@ -149,6 +149,8 @@ namespace vigra {
     (rank >= 0.0) && (rank <= 1.0)
     radius >= 0
     \endcode
+
+    \see multiRankOrderFilter() for 16-bit data, box windows and N-D arrays
 */
 doxygen_overloaded_function(template <...> void discRankOrderFilter)
 
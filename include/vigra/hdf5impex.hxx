@@ -887,6 +887,32 @@ class HDF5File
         return shape;
     }
 
+        /** \brief Get the chunk shape of a dataset.
+
+            Returns an empty vector when the dataset is not chunked. As in
+            \ref getDatasetShape(), the axis order is reversed relative to the
+            file contents.
+        */
+    ArrayVector<hsize_t> getChunkShape(std::string datasetName)
+    {
+        // make datasetName clean
+        datasetName = get_absolute_path(datasetName);
+
+        std::string errorMessage = "HDF5File::getChunkShape(): Unable to open dataset '" + datasetName + "'.";
+        HDF5Handle datasetHandle = HDF5Handle(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+
+        HDF5Handle properties(H5Dget_create_plist(datasetHandle),
+                              &H5Pclose, "HDF5File::getChunkShape(): failed to get property list");
+        ArrayVector<hsize_t> chunks;
+        if(H5D_CHUNKED == H5Pget_layout(properties))
+        {
+            chunks.resize(getDatasetDimensions(datasetName));
+            H5Pget_chunk(properties, chunks.size(), chunks.data());
+            std::reverse(chunks.begin(), chunks.end());
+        }
+        return chunks;
+    }
+
         /** Query the pixel type of the dataset.
 
             Possible values are:
@@ -0,0 +1,289 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_HIERARCHICAL_CLUSTERING_HXX
+#define VIGRA_HIERARCHICAL_CLUSTERING_HXX
+
+#include <map>
+#include "multi_array.hxx"
+#include "union_find.hxx"
+#include "bucket_queue.hxx"
+#include "region_adjacency_graph.hxx"
+
+namespace vigra {
+
+/** \addtogroup Labeling
+*/
+//@{
+
+/** \brief Hierarchical agglomerative clustering of a region adjacency graph.
+
+    Starting from a \ref RegionAdjacencyGraph, this class repeatedly merges
+    the two clusters connected by the cheapest edge. The weight of an edge is
+    computed from its accumulator chain by the functor <tt>EdgeWeight</tt>
+    (which must return a value convertible to <tt>double</tt>). When two
+    clusters are merged, edges that now connect the same pair of clusters are
+    combined by merging their accumulator chains (see the <tt>merge()</tt>
+    support in \ref FeatureAccumulators), and only the weights of these edges
+    are recomputed. Therefore, all statistics in the chain must support
+    merging (e.g. <tt>Count</tt>, <tt>Mean</tt>, <tt>Minimum</tt>,
+    <tt>Maximum</tt>).
+
+    Clusters are represented by a <tt>UnionFindArray</tt> over the graph nodes,
+    and the edges are kept in an indexed heap (\ref ChangeablePriorityQueue),
+    so that edge weights can be changed and obsolete edges deleted in
+    logarithmic time.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/hierarchical_clustering.hxx\><br>
+    Namespace: vigra
+
+    \code
+    using namespace vigra::acc;
+    typedef AccumulatorChain<double, Select<Count, Mean> > EdgeFeatures;
+
+    struct MeanWeight
+    {
+        double operator()(EdgeFeatures const & a) const
+        {
+            return get<Mean>(a);
+        }
+    };
+
+    MultiArray<3, float>  gradMag(shape);
+    MultiArray<3, UInt32> labels(shape);
+    ... // compute superpixels
+
+    RegionAdjacencyGraph<EdgeFeatures> rag(labels, gradMag);
+    HierarchicalClustering<EdgeFeatures, MeanWeight> clustering(rag);
+
+    // merge until the mean boundary strength of all remaining edges exceeds 0.3
+    clustering.cluster(0.3);
+    clustering.relabel(labels);
+    \endcode
+*/
+template <class EdgeFeatures, class EdgeWeight>
+class HierarchicalClustering
+{
+  public:
+    typedef MultiArrayIndex index_type;
+
+        /** A single merge step: clusters \a u and \a v were merged
+            across an edge of weight \a weight.
+        */
+    struct MergeStep
+    {
+        index_type u, v;
+        double weight;
+    };
+
+        /** Initialize the clustering with one cluster per node of \a rag.
+        */
+    HierarchicalClustering(RegionAdjacencyGraph<EdgeFeatures> const & rag,
+                           EdgeWeight const & weight = EdgeWeight())
+    : weight_(weight)
+    , regions_(rag.nodeCount())
+    , queue_(rag.edgeCount())
+    , features_(rag.edgeCount())
+    , edges_(rag.edgeCount())
+    , adjacency_(rag.nodeCount())
+    , slots_(rag.nodeCount())
+    , cluster_count_(rag.nodeCount())
+    {
+        for(index_type n=0; n<rag.nodeCount(); ++n)
+            slots_[n] = n;
+        for(index_type e=0; e<rag.edgeCount(); ++e)
+        {
+            features_[e] = rag.edgeFeatures(e);
+            edges_[e] = std::make_pair(rag.u(e), rag.v(e));
+            adjacency_[rag.u(e)][rag.v(e)] = e;
+            adjacency_[rag.v(e)][rag.u(e)] = e;
+            queue_.push(e, (double)weight_(features_[e]));
+        }
+    }
+
+        /** Merge clusters until the cheapest remaining edge is heavier than
+            \a threshold or only \a min_clusters clusters are left.
+        */
+    void cluster(double threshold, index_type min_clusters = 1)
+    {
+        while(!queue_.empty() && cluster_count_ > min_clusters &&
+              queue_.topPriority() <= threshold)
+        {
+            mergeEdge(queue_.top());
+        }
+    }
+
+        /** Merge the two clusters connected by edge \a e (which must
+            still be active).
+        */
+    void mergeEdge(index_type e)
+    {
+        vigra_precondition(queue_.contains(e),
+            "HierarchicalClustering::mergeEdge(): edge is no longer active.");
+
+        MergeStep step;
+        step.u = find(edges_[e].first);
+        step.v = find(edges_[e].second);
+        step.weight = queue_.priority(e);
+        merges_.push_back(step);
+        queue_.remove(e);
+        --cluster_count_;
+
+        // The merged cluster keeps the larger adjacency map, so that only the
+        // entries of the smaller one must be moved (this avoids quadratic cost
+        // when a big cluster absorbs many small ones). The union-find root is
+        // independent of this choice and refers to the map via 'slots_'.
+        index_type keep = slots_[step.u],
+                   drop = slots_[step.v];
+        if(adjacency_[keep].size() < adjacency_[drop].size())
+            std::swap(keep, drop);
+        slots_[regions_.makeUnion(step.u, step.v)] = keep;
+
+        Adjacency & keep_adjacency = adjacency_[keep];
+        Adjacency & drop_adjacency = adjacency_[drop];
+        keep_adjacency.erase(drop);
+
+        for(typename Adjacency::iterator i = drop_adjacency.begin(); i != drop_adjacency.end(); ++i)
+        {
+            index_type neighbor = i->first,
+                       edge = i->second;
+            if(neighbor == keep)
+                continue;
+            Adjacency & neighbor_adjacency = adjacency_[neighbor];
+            neighbor_adjacency.erase(drop);
+
+            typename Adjacency::iterator parallel = keep_adjacency.find(neighbor);
+            if(parallel == keep_adjacency.end())
+            {
+                // the edge now connects the merged cluster and 'neighbor'
+                keep_adjacency[neighbor] = edge;
+                neighbor_adjacency[keep] = edge;
+            }
+            else
+            {
+                // combine with the existing edge and update its weight
+                index_type target = parallel->second;
+                features_[target].merge(features_[edge]);
+                queue_.remove(edge);
+                queue_.changePriority(target, (double)weight_(features_[target]));
+            }
+        }
+        Adjacency().swap(drop_adjacency);
+    }
+
+        /** Current number of clusters (including nodes of the
+            graph that correspond to unused labels).
+        */
+    index_type clusterCount() const
+    {
+        return cluster_count_;
+    }
+
+        /** Representative node of the cluster containing \a node.
+        */
+    index_type find(index_type node) const
+    {
+        return regions_.find(node);
+    }
+
+        /** Number of edges between different clusters.
+        */
+    index_type activeEdgeCount() const
+    {
+        return (index_type)queue_.size();
+    }
+
+        /** Edge \a e still connects two different clusters.
+        */
+    bool isActive(index_type e) const
+    {
+        return queue_.contains(e);
+    }
+
+        /** Weight of the active edge \a e.
+        */
+    double edgeWeight(index_type e) const
+    {
+        return queue_.priority(e);
+    }
+
+        /** Merged accumulator chain of the active edge \a e.
+        */
+    EdgeFeatures const & edgeFeatures(index_type e) const
+    {
+        return features_[e];
+    }
+
+        /** The merges performed so far, in order.
+        */
+    ArrayVector<MergeStep> const & merges() const
+    {
+        return merges_;
+    }
+
+        /** Replace each label in \a labels with the representative
+            label of its cluster.
+        */
+    template <unsigned int N, class Label, class S>
+    void relabel(MultiArrayView<N, Label, S> labels) const
+    {
+        typename MultiArrayView<N, Label, S>::iterator i = labels.begin(),
+                                                       end = labels.end();
+        for(; i != end; ++i)
+            *i = (Label)find((index_type)*i);
+    }
+
+  private:
+    typedef std::map<index_type, index_type> Adjacency;  // neighbor slot => edge
+
+    EdgeWeight weight_;
+    detail::UnionFindArray<index_type> regions_;
+    ChangeablePriorityQueue<double, true> queue_;
+    ArrayVector<EdgeFeatures> features_;
+    ArrayVector<std::pair<index_type, index_type> > edges_;
+    ArrayVector<Adjacency> adjacency_;     // indexed by slot
+    ArrayVector<index_type> slots_;        // cluster representative => slot
+    ArrayVector<MergeStep> merges_;
+    index_type cluster_count_;
+};
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_HIERARCHICAL_CLUSTERING_HXX
@@ -0,0 +1,585 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_INTEGRAL_IMAGE_HXX
+#define VIGRA_INTEGRAL_IMAGE_HXX
+
+#include <algorithm>
+#include "multi_array.hxx"
+#include "multi_pointoperators.hxx"
+#include "sized_int.hxx"
+
+namespace vigra {
+
+/********************************************************/
+/*                                                      */
+/*                 IntegralArrayTraits                  */
+/*                                                      */
+/********************************************************/
+
+/** \brief Accumulator types for integral arrays of scalar type <tt>T</tt>.
+
+    <b>\#include</b> \<vigra/integral_image.hxx\><br/>
+    Namespace: vigra
+
+    <tt>SumType</tt> is used for sums of values, <tt>SquaredSumType</tt>
+    for sums of squared values. The types are chosen such that the sums
+    cannot overflow for arrays of up to 2<sup>31</sup> elements:
+
+    <table>
+    <tr><th><tt>T</tt></th><th><tt>SumType</tt></th><th><tt>SquaredSumType</tt></th></tr>
+    <tr><td>8- and 16-bit integers</td><td><tt>Int64</tt></td><td><tt>Int64</tt></td></tr>
+    <tr><td>32-bit integers</td><td><tt>Int64</tt></td><td><tt>double</tt></td></tr>
+    <tr><td>64-bit integers</td><td><tt>double</tt></td><td><tt>double</tt></td></tr>
+    <tr><td><tt>float</tt>, <tt>double</tt></td><td><tt>double</tt></td><td><tt>double</tt></td></tr>
+    </table>
+
+    Integer sums are thus exact whenever possible.
+*/
+template <class T>
+struct IntegralArrayTraits
+{
+    typedef typename NumericTraits<T>::isIntegral isIntegral;
+
+    typedef typename IfBool<isIntegral::value,
+                typename IfBool<(sizeof(T) <= 4), Int64, double>::type,
+                typename PromoteTraits<T, double>::Promote>::type SumType;
+
+    typedef typename IfBool<isIntegral::value,
+                typename IfBool<(sizeof(T) <= 2), Int64, double>::type,
+                SumType>::type SquaredSumType;
+};
+
+namespace detail {
+
+template <class T>
+struct IntegralArrayShiftFunctor
+{
+    T shift_;
+
+    IntegralArrayShiftFunctor(T shift)
+    : shift_(shift)
+    {}
+
+    template <class U>
+    T operator()(U const & v) const
+    {
+        return T(v) - shift_;
+    }
+};
+
+template <class T>
+struct IntegralArraySquareFunctor
+{
+    T shift_;
+
+    IntegralArraySquareFunctor(T shift)
+    : shift_(shift)
+    {}
+
+    template <class U>
+    T operator()(U const & v) const
+    {
+        T t = T(v) - shift_;
+        return t*t;
+    }
+};
+
+struct IntegralArrayRunningSum
+{
+    template <class T>
+    void operator()(T * in, T * out, MultiArrayIndex n, int panelWidth, int pw) const
+    {
+        for(int p = 0; p < pw; ++p)
+            out[p] = in[p];
+        for(MultiArrayIndex k = 1; k < n; ++k)
+        {
+            T const * i = in + k*panelWidth;
+            T * o = out + k*panelWidth;
+            for(int p = 0; p < pw; ++p)
+                o[p] = o[p - panelWidth] + i[p];
+        }
+    }
+};
+
+    // Sums over the windows [x-radius, x+radius] (clipped at the line ends),
+    // computed as differences of the running sums.
+struct IntegralArrayBoxSum
+{
+    MultiArrayIndex radius_;
+
+    IntegralArrayBoxSum(MultiArrayIndex radius)
+    : radius_(radius)
+    {}
+
+    template <class T>
+    void operator()(T * in, T * out, MultiArrayIndex n, int panelWidth, int pw) const
+    {
+        for(MultiArrayIndex k = 1; k < n; ++k)
+        {
+            T * i = in + k*panelWidth;
+            for(int p = 0; p < pw; ++p)
+                i[p] += i[p - panelWidth];
+        }
+        for(MultiArrayIndex k = 0; k < n; ++k)
+        {
+            T const * upper = in + std::min(k + radius_, n - 1)*panelWidth;
+            T * o = out + k*panelWidth;
+            if(k > radius_)
+            {
+                T const * lower = in + (k - radius_ - 1)*panelWidth;
+                for(int p = 0; p < pw; ++p)
+                    o[p] = upper[p] - lower[p];
+            }
+            else
+            {
+                for(int p = 0; p < pw; ++p)
+                    o[p] = upper[p];
+            }
+        }
+    }
+};
+
+    // Replace the array by its running sums along all axes.
+template <unsigned int N, class T, class S>
+void
+integralMultiArrayInPlace(MultiArrayView<N, T, S> array)
+{
+    for(unsigned int d=0; d<N; ++d)
+        transformMultiArrayLines(array, array, d, IntegralArrayRunningSum());
+}
+
+    // Replace the array by the sums over the windows [x-radius, x+radius]
+    // (clipped at the array border). Since the differences of the integral array
+    // along one axis commute with the running sums along the other axes, the
+    // running sum and the difference are done in the same pass for each axis.
+template <unsigned int N, class T, class S>
+void
+boxSumsInPlace(MultiArrayView<N, T, S> array,
+               typename MultiArrayShape<N>::type const & radius)
+{
+    for(unsigned int d=0; d<N; ++d)
+        transformMultiArrayLines(array, array, d, IntegralArrayBoxSum(radius[d]));
+}
+
+    // Number of elements in the window [x-r, x+r] clipped to [0, n).
+inline MultiArrayIndex
+boxWindowSize(MultiArrayIndex n, MultiArrayIndex r, MultiArrayIndex x)
+{
+    return std::min(x + r, n - 1) - std::max<MultiArrayIndex>(x - r, 0) + 1;
+}
+
+    // Compute box mean and (optionally) variance from the box sums of the shifted
+    // values and their squares.
+template <unsigned int N, class T1, class S1, class T2, class S2,
+                          class T3, class S3, class T4, class S4>
+void
+boxMeanVarianceFromSums(MultiArrayView<N, T1, S1> const & sums,
+                        MultiArrayView<N, T2, S2> const & squaredSums,
+                        double shift,
+                        typename MultiArrayShape<N>::type const & radius,
+                        MultiArrayView<N, T3, S3> mean,
+                        MultiArrayView<N, T4, S4> variance)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    Shape shape(sums.shape()), rows(shape);
+    rows[0] = 1;
+    MultiArrayIndex rowCount = prod(rows);
+    bool useMean = mean.hasData(), useVariance = variance.hasData();
+
+    ArrayVector<double> count0(shape[0]);
+    for(MultiArrayIndex x=0; x<shape[0]; ++x)
+        count0[x] = (double)boxWindowSize(shape[0], radius[0], x);
+
+    for(MultiArrayIndex k=0; k<rowCount; ++k)
+    {
+        Shape row;
+        detail::ScanOrderToCoordinate<N>::exec(k, rows, row);
+
+        double count = 1.0;
+        for(unsigned int d=1; d<N; ++d)
+            count *= boxWindowSize(shape[d], radius[d], row[d]);
+
+        T1 const * s  = &sums[row];
+        T2 const * s2 = useVariance ? &squaredSums[row] : 0;
+        T3 * m = useMean ? &mean[row] : 0;
+        T4 * v = useVariance ? &variance[row] : 0;
+        for(MultiArrayIndex x=0; x<shape[0]; ++x)
+        {
+            double n = count * count0[x],
+                   mx = (double)s[x*sums.stride(0)] / n;
+            if(useMean)
+                m[x*mean.stride(0)] = detail::RequiresExplicitCast<T3>::cast(mx + shift);
+            if(useVariance)
+            {
+                double vx = (double)s2[x*squaredSums.stride(0)] / n - mx*mx;
+                v[x*variance.stride(0)] = detail::RequiresExplicitCast<T4>::cast(std::max(vx, 0.0));
+            }
+        }
+    }
+}
+
+template <unsigned int N, class T1, class S1, class T2, class S2, class T3, class S3>
+void
+boxMeanVarianceImpl(MultiArrayView<N, T1, S1> const & source,
+                    typename MultiArrayShape<N>::type const & radius,
+                    MultiArrayView<N, T2, S2> mean,
+                    MultiArrayView<N, T3, S3> variance,
+                    const char * function_name)
+{
+    typedef typename IntegralArrayTraits<T1>::SumType SumType;
+    typedef typename IntegralArrayTraits<T1>::SquaredSumType SquaredSumType;
+
+    vigra_precondition((!mean.hasData() || mean.shape() == source.shape()) &&
+                       (!variance.hasData() || variance.shape() == source.shape()),
+        std::string(function_name) + "(): shape mismatch between input and output.");
+    vigra_precondition(radius.minimum() >= 0,
+        std::string(function_name) + "(): radius must be non-negative.");
+    if(source.size() == 0)
+        return;
+
+    // Floating-point sums of squares suffer from cancellation when the mean
+    // is large compared to the standard deviation. The data are therefore
+    // shifted by their global mean before summation (integer sums are exact
+    // and need no shift).
+    double shift = 0.0;
+    if(variance.hasData() && !IntegralArrayTraits<T1>::isIntegral::value)
+    {
+        for(typename MultiArrayView<N, T1, S1>::const_iterator i = source.begin();
+            i != source.end(); ++i)
+            shift += (double)*i;
+        shift /= source.size();
+    }
+
+    MultiArray<N, SumType> sums(source.shape());
+    transformMultiArray(source, sums, IntegralArrayShiftFunctor<SumType>(SumType(shift)));
+    boxSumsInPlace(sums, radius);
+
+    MultiArray<N, SquaredSumType> squaredSums;
+    if(variance.hasData())
+    {
+        squaredSums.reshape(source.shape());
+        transformMultiArray(source, squaredSums,
+                            IntegralArraySquareFunctor<SquaredSumType>(SquaredSumType(shift)));
+        boxSumsInPlace(squaredSums, radius);
+    }
+
+    boxMeanVarianceFromSums(sums, squaredSums, shift, radius, mean, variance);
+}
+
+} // namespace detail
+
+/** \addtogroup MultiArrayConvolutionFilters
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                 integralMultiArray                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Compute the integral array (summed-area table) of a multi-dimensional array.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        // sums of values
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        integralMultiArray(MultiArrayView<N, T1, S1> const & source,
+                           MultiArrayView<N, T2, S2> dest);
+
+        // sums of squared values
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        integralMultiArraySquared(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> dest);
+    }
+    \endcode
+
+    Each element of <tt>dest</tt> receives the sum of all source elements whose
+    coordinates are less than or equal to its own coordinates in every dimension:
+
+    \code
+    dest[p] = sum_{q <= p} source[q]
+    \endcode
+
+    The sum over an arbitrary box can then be obtained in constant time from the
+    <tt>2<sup>N</sup></tt> corners of the box (by the inclusion-exclusion principle).
+    <tt>integralMultiArraySquared()</tt> sums the squared values instead.
+    All computations are done in the value type of <tt>dest</tt>, so that
+    <tt>dest</tt> must be able to hold the total sum without overflow.
+    \ref IntegralArrayTraits provides suitable types. The functions work
+    in-place when <tt>dest</tt> is identical to <tt>source</tt>.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/integral_image.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt8> volume(Shape3(200, 200, 100));
+    ...
+    MultiArray<3, IntegralArrayTraits<UInt8>::SumType> integral(volume.shape());
+    integralMultiArray(volume, integral);
+    \endcode
+
+    \see boxSumMultiArray(), boxMeanMultiArray(), boxVarianceMultiArray()
+*/
+doxygen_overloaded_function(template <...> void integralMultiArray)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+integralMultiArray(MultiArrayView<N, T1, S1> const & source,
+                   MultiArrayView<N, T2, S2> dest)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "integralMultiArray(): shape mismatch between input and output.");
+    if(source.size() == 0)
+        return;
+    transformMultiArray(source, dest, detail::IntegralArrayShiftFunctor<T2>(T2()));
+    detail::integralMultiArrayInPlace(dest);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+integralMultiArraySquared(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "integralMultiArraySquared(): shape mismatch between input and output.");
+    if(source.size() == 0)
+        return;
+    transformMultiArray(source, dest, detail::IntegralArraySquareFunctor<T2>(T2()));
+    detail::integralMultiArrayInPlace(dest);
+}
+
+/********************************************************/
+/*                                                      */
+/*                   boxSumMultiArray                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Box filters for multi-dimensional arrays, computed via the integral array.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        boxSumMultiArray(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        boxMeanMultiArray(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest,
+                          typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        boxVarianceMultiArray(MultiArrayView<N, T1, S1> const & source,
+                              MultiArrayView<N, T2, S2> dest,
+                              typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                                  class T3, class S3>
+        void
+        boxMeanVarianceMultiArray(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> mean,
+                                  MultiArrayView<N, T3, S3> variance,
+                                  typename MultiArrayShape<N>::type const & radius);
+    }
+    \endcode
+
+    These functions compute the sum, mean, and (population) variance of the
+    source values in the box <tt>[p - radius, p + radius]</tt> around each
+    element <tt>p</tt>. Each function is also available with a scalar
+    <tt>radius</tt>, which is then used for all dimensions. At the array
+    border, the box is clipped to the array, and mean and variance refer to
+    the elements inside the clipped box.
+
+    In contrast to \ref separableConvolveMultiArray() with an averaging kernel
+    (see \ref Kernel1D::initAveraging()), the cost per element is independent of
+    the radius: the box sums are differences of the integral array (see
+    \ref integralMultiArray()) along each axis, computed in the overflow-safe types
+    of \ref IntegralArrayTraits. Since the difference along one axis commutes with
+    the running sums along the other axes, the running sum and the difference are
+    done in a single pass per axis. Sums of integer data are thus exact.
+    For floating-point data, the variance is computed from values shifted by
+    their global mean to avoid cancellation.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/integral_image.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt16> volume(Shape3(200, 200, 100));
+    ...
+    // local normalization with a 31x31x31 window
+    MultiArray<3, float> mean(volume.shape()), variance(volume.shape());
+    boxMeanVarianceMultiArray(volume, mean, variance, 15);
+    \endcode
+
+    <b> Preconditions:</b>
+
+    The output arrays must have the same shape as the input, and
+    <tt>radius</tt> must be non-negative.
+*/
+doxygen_overloaded_function(template <...> void boxSumMultiArray)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+boxSumMultiArray(MultiArrayView<N, T1, S1> const & source,
+                 MultiArrayView<N, T2, S2> dest,
+                 typename MultiArrayShape<N>::type const & radius)
+{
+    typedef typename IntegralArrayTraits<T1>::SumType SumType;
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "boxSumMultiArray(): shape mismatch between input and output.");
+    vigra_precondition(radius.minimum() >= 0,
+        "boxSumMultiArray(): radius must be non-negative.");
+    if(source.size() == 0)
+        return;
+
+    MultiArray<N, SumType> sums(source);
+    detail::boxSumsInPlace(sums, radius);
+    transformMultiArray(sums, dest, detail::IntegralArrayShiftFunctor<T2>(T2()));
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+boxSumMultiArray(MultiArrayView<N, T1, S1> const & source,
+                 MultiArrayView<N, T2, S2> dest,
+                 MultiArrayIndex radius)
+{
+    boxSumMultiArray(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void boxMeanMultiArray)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+boxMeanMultiArray(MultiArrayView<N, T1, S1> const & source,
+                  MultiArrayView<N, T2, S2> dest,
+                  typename MultiArrayShape<N>::type const & radius)
+{
+    detail::boxMeanVarianceImpl(source, radius, dest, MultiArrayView<N, double>(),
+                                "boxMeanMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+boxMeanMultiArray(MultiArrayView<N, T1, S1> const & source,
+                  MultiArrayView<N, T2, S2> dest,
+                  MultiArrayIndex radius)
+{
+    boxMeanMultiArray(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void boxVarianceMultiArray)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+boxVarianceMultiArray(MultiArrayView<N, T1, S1> const & source,
+                      MultiArrayView<N, T2, S2> dest,
+                      typename MultiArrayShape<N>::type const & radius)
+{
+    detail::boxMeanVarianceImpl(source, radius, MultiArrayView<N, double>(), dest,
+                                "boxVarianceMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+boxVarianceMultiArray(MultiArrayView<N, T1, S1> const & source,
+                      MultiArrayView<N, T2, S2> dest,
+                      MultiArrayIndex radius)
+{
+    boxVarianceMultiArray(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void boxMeanVarianceMultiArray)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3>
+inline void
+boxMeanVarianceMultiArray(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> mean,
+                          MultiArrayView<N, T3, S3> variance,
+                          typename MultiArrayShape<N>::type const & radius)
+{
+    detail::boxMeanVarianceImpl(source, radius, mean, variance,
+                                "boxMeanVarianceMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3>
+inline void
+boxMeanVarianceMultiArray(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> mean,
+                          MultiArrayView<N, T3, S3> variance,
+                          MultiArrayIndex radius)
+{
+    boxMeanVarianceMultiArray(source, mean, variance, typename MultiArrayShape<N>::type(radius));
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_INTEGRAL_IMAGE_HXX
@@ -0,0 +1,1210 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2013 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_MULTI_ARRAY_CHUNKED_HXX
+#define VIGRA_MULTI_ARRAY_CHUNKED_HXX
+
+#include <list>
+#include <string>
+#include <cstdio>
+#include <memory>
+#include "multi_array.hxx"
+#include "mathutil.hxx"
+#include "memory.hxx"
+#include "error.hxx"
+
+#ifdef _WIN32
+# include "windows.h"
+#else
+# include <unistd.h>
+# include <sys/types.h>
+# include <sys/mman.h>
+#endif
+
+namespace vigra {
+
+template <unsigned int N, class T>
+class ChunkedArray;
+
+template <unsigned int N, class T>
+class ChunkIterator;
+
+namespace detail {
+
+    // default chunk shapes contain 2^18 elements (e.g. 512^2 and 64^3)
+template <unsigned int N>
+struct ChunkShape
+{
+    static TinyVector<MultiArrayIndex, N> defaultShape()
+    {
+        return TinyVector<MultiArrayIndex, N>(MultiArrayIndex(1) << (N < 18 ? 18 / N : 1));
+    }
+};
+
+template <int N>
+inline MultiArrayIndex
+offsetInChunk(TinyVector<MultiArrayIndex, N> const & point,
+              TinyVector<MultiArrayIndex, N> const & mask,
+              TinyVector<MultiArrayIndex, N> const & strides)
+{
+    MultiArrayIndex res = 0;
+    for(int k=0; k<N; ++k)
+        res += (point[k] & mask[k]) * strides[k];
+    return res;
+}
+
+template <int N>
+inline TinyVector<MultiArrayIndex, N>
+chunkIndexOf(TinyVector<MultiArrayIndex, N> const & point,
+             TinyVector<MultiArrayIndex, N> const & bits)
+{
+    TinyVector<MultiArrayIndex, N> res;
+    for(int k=0; k<N; ++k)
+        res[k] = point[k] >> bits[k];
+    return res;
+}
+
+#ifdef _WIN32
+inline std::size_t mmap_alignment()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+#else
+inline std::size_t mmap_alignment()
+{
+    return sysconf(_SC_PAGESIZE);
+}
+#endif
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                  ChunkedArrayOptions                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Option object for \ref ChunkedArray construction.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br/>
+    Namespace: vigra
+*/
+class ChunkedArrayOptions
+{
+  public:
+        /** \brief Initialize options with defaults.
+
+            The fill value is zero, and the cache size is chosen automatically
+            such that an entire 2D slice through the chunk grid fits into the cache.
+        */
+    ChunkedArrayOptions()
+    : fill_value(0.0)
+    , cache_max(-1)
+    {}
+
+        /** \brief Element value for chunks that have never been written to.
+
+            Default: 0
+        */
+    ChunkedArrayOptions & fillValue(double v)
+    {
+        fill_value = v;
+        return *this;
+    }
+
+        /** \brief Maximum number of chunks held in the cache.
+
+            A negative value selects an automatic cache size (the default).
+        */
+    ChunkedArrayOptions & cacheMax(int v)
+    {
+        cache_max = v;
+        return *this;
+    }
+
+    double fill_value;
+    int cache_max;
+};
+
+/********************************************************/
+/*                                                      */
+/*                       ChunkBase                      */
+/*                                                      */
+/********************************************************/
+
+    /* Base class of the chunk objects of the different backends.
+       'pointer_' refers to the chunk's data when the chunk is loaded,
+       and is zero otherwise.
+    */
+template <unsigned int N, class T>
+class ChunkBase
+{
+  public:
+    typedef typename MultiArrayShape<N>::type  shape_type;
+    typedef T *                                pointer;
+
+    ChunkBase()
+    : strides_()
+    , pointer_()
+    , dirty_(false)
+    {}
+
+    ChunkBase(shape_type const & strides, pointer p = 0)
+    : strides_(strides)
+    , pointer_(p)
+    , dirty_(false)
+    {}
+
+    virtual ~ChunkBase()
+    {}
+
+    shape_type strides_;
+    pointer pointer_;
+    bool dirty_;
+};
+
+    /* Book-keeping for a single chunk of a ChunkedArray.
+
+       'chunk_state_' is the number of active references when the chunk is
+       loaded, or one of the negative constants below otherwise.
+    */
+template <unsigned int N, class T>
+class SharedChunkHandle
+{
+  public:
+    typedef ChunkBase<N, T>                                   Chunk;
+    typedef typename std::list<SharedChunkHandle *>::iterator CachePosition;
+
+    enum ChunkState { chunk_asleep = -2, chunk_uninitialized = -3 };
+
+    SharedChunkHandle()
+    : pointer_(0)
+    , chunk_state_(chunk_uninitialized)
+    , in_cache_(false)
+    {}
+
+    SharedChunkHandle(SharedChunkHandle const & rhs)
+    : pointer_(rhs.pointer_)
+    , chunk_state_(rhs.chunk_state_)
+    , in_cache_(false)
+    {
+        vigra_precondition(!rhs.in_cache_,
+            "SharedChunkHandle: cannot copy a handle of a loaded chunk.");
+    }
+
+    Chunk * pointer_;
+    long chunk_state_;
+    bool in_cache_;
+    CachePosition cache_pos_;
+};
+
+/********************************************************/
+/*                                                      */
+/*                     ChunkedArray                     */
+/*                                                      */
+/********************************************************/
+
+/** \brief Interface and base class for chunked arrays.
+
+    A chunked array partitions its data into equal-sized chunks (only chunks
+    at the upper array border may be smaller). Chunks are loaded on demand
+    when their data are accessed, and at most <tt>cacheMaxSize()</tt> chunks are
+    held in memory at any time. When the cache is full, the least recently used
+    chunk that is not currently referenced by a \ref ChunkIterator is
+    written back to its storage and removed from memory. It is therefore
+    possible to work with arrays that are much larger than the available RAM.
+
+    The backends differ in where the data live while a chunk is not in the cache:
+
+    <ul>
+    <li> \ref vigra::ChunkedArrayLazy keeps all chunks in memory, but only allocates
+         chunks that were actually accessed.
+    <li> \ref vigra::ChunkedArrayTmpFile swaps chunks out to a memory-mapped
+         temporary file which is deleted upon destruction of the array.
+    <li> \ref vigra::ChunkedArrayHDF5 (in \<vigra/multi_array_chunked_hdf5.hxx\>)
+         stores the data in an HDF5 dataset.
+    </ul>
+
+    Chunk shapes must be powers of 2 along every axis, so that the chunk index
+    and the offset within a chunk can be computed by bit operations. Individual
+    elements can be accessed via <tt>getItem()</tt> and <tt>setItem()</tt>, but it is
+    far more efficient to copy entire regions into a \ref MultiArrayView by means of
+    <tt>checkoutSubarray()</tt>, and to write them back via <tt>commitSubarray()</tt>,
+    or to iterate over the chunks of a region with <tt>chunk_begin()</tt> and
+    <tt>chunk_end()</tt>. Dereferencing a chunk iterator returns a
+    \ref MultiArrayView to the part of the current chunk that lies inside the
+    region of interest. The chunk is locked in memory as long as the iterator
+    points to it.
+
+    ChunkedArray is not thread-safe: concurrent accesses must be synchronized
+    by the caller.
+
+    <b>Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    // a 3D array whose chunks are swapped out to a temporary file,
+    // keeping at most 100 chunks of 64x64x64 elements in memory
+    ChunkedArrayTmpFile<3, float> array(Shape3(2000, 2000, 2000), Shape3(64),
+                                        ChunkedArrayOptions().cacheMax(100));
+
+    // fill the array chunk by chunk
+    ChunkedArrayTmpFile<3, float>::chunk_iterator i   = array.chunk_begin(Shape3(0), array.shape()),
+                                                  end = array.chunk_end(Shape3(0), array.shape());
+    for(; i != end; ++i)
+        *i = 1.0f;
+
+    // copy a region into an ordinary array, process it, and write it back
+    MultiArray<3, float> block(Shape3(100, 100, 100));
+    array.checkoutSubarray(Shape3(500, 500, 500), block);
+    block *= 2.0f;
+    array.commitSubarray(Shape3(500, 500, 500), block);
+    \endcode
+*/
+template <unsigned int N, class T>
+class ChunkedArray
+{
+  public:
+    typedef ChunkedArray<N, T>                     self_type;
+    typedef T                                      value_type;
+    typedef value_type &                           reference;
+    typedef value_type const &                     const_reference;
+    typedef value_type *                           pointer;
+    typedef value_type const *                     const_pointer;
+    typedef typename MultiArrayShape<N>::type      shape_type;
+    typedef MultiArrayIndex                        difference_type_1;
+    typedef ChunkBase<N, T>                        Chunk;
+    typedef SharedChunkHandle<N, T>                Handle;
+    typedef MultiArrayView<N, T, StridedArrayTag>  view_type;
+    typedef ChunkIterator<N, T>                    chunk_iterator;
+
+    friend class ChunkIterator<N, T>;
+
+        /** Construct the array interface with given shape and chunk shape.
+            If \a chunk_shape is zero, a default chunk shape is used.
+        */
+    ChunkedArray(shape_type const & shape,
+                 shape_type const & chunk_shape = shape_type(),
+                 ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    : shape_(shape)
+    , chunk_shape_(prod(chunk_shape) > 0 ? chunk_shape : detail::ChunkShape<N>::defaultShape())
+    , bits_()
+    , mask_()
+    , cache_max_size_(options.cache_max)
+    , fill_value_(T(options.fill_value))
+    , handle_array_()
+    , cache_()
+    {
+        for(unsigned int k=0; k<N; ++k)
+        {
+            vigra_precondition(chunk_shape_[k] > 0 &&
+                               chunk_shape_[k] == MultiArrayIndex(ceilPower2(UInt32(chunk_shape_[k]))),
+                "ChunkedArray(): chunk_shape elements must be powers of 2.");
+            bits_[k] = log2i(UInt32(chunk_shape_[k]));
+            mask_[k] = chunk_shape_[k] - 1;
+        }
+        handle_array_.reshape(chunkArrayShape());
+    }
+
+    virtual ~ChunkedArray()
+    {}
+
+        /** The array's shape.
+        */
+    shape_type const & shape() const
+    {
+        return shape_;
+    }
+
+        /** The length of dimension \a d.
+        */
+    difference_type_1 shape(int d) const
+    {
+        return shape_[d];
+    }
+
+        /** Total number of array elements.
+        */
+    difference_type_1 size() const
+    {
+        return prod(shape_);
+    }
+
+        /** Shape of a full (i.e. non-border) chunk.
+        */
+    shape_type const & chunkShape() const
+    {
+        return chunk_shape_;
+    }
+
+        /** Number of chunks along each axis.
+        */
+    shape_type chunkArrayShape() const
+    {
+        return detail::chunkIndexOf(shape_ + chunk_shape_ - shape_type(1), bits_);
+    }
+
+        /** Shape of the chunk with the given index (border chunks may be smaller
+            than <tt>chunkShape()</tt>).
+        */
+    shape_type chunkShape(shape_type const & chunk_index) const
+    {
+        return min(chunk_shape_, shape_ - chunk_index*chunk_shape_);
+    }
+
+        /** Check if the given point is inside the array.
+        */
+    bool isInside(shape_type const & p) const
+    {
+        for(unsigned int k=0; k<N; ++k)
+            if(p[k] < 0 || p[k] >= shape_[k])
+                return false;
+        return true;
+    }
+
+        /** Name of the storage backend.
+        */
+    virtual std::string backend() const = 0;
+
+        /** Check if the array rejects write access.
+        */
+    virtual bool isReadOnly() const
+    {
+        return false;
+    }
+
+        /** Number of chunks currently in the cache.
+        */
+    std::size_t cacheSize() const
+    {
+        return cache_.size();
+    }
+
+        /** Maximum number of chunks in the cache. If no size was specified
+            explicitly, it is chosen such that any 2D slice through the chunk grid
+            fits into the cache.
+        */
+    std::size_t cacheMaxSize() const
+    {
+        if(cache_max_size_ < 0)
+        {
+            shape_type s = chunkArrayShape();
+            MultiArrayIndex m = max(s);
+            for(unsigned int j=0; j<N; ++j)
+                for(unsigned int k=j+1; k<N; ++k)
+                    m = std::max(m, s[j]*s[k]);
+            cache_max_size_ = (int)m + 1;
+        }
+        return cache_max_size_;
+    }
+
+        /** Change the maximum cache size. Superfluous chunks are immediately
+            removed from the cache.
+        */
+    void setCacheMaxSize(std::size_t c)
+    {
+        cache_max_size_ = (int)c;
+        cleanCache(cache_.size());
+    }
+
+        /** Read the element at position \a point.
+        */
+    value_type getItem(shape_type const & point) const
+    {
+        vigra_precondition(isInside(point),
+            "ChunkedArray::getItem(): index out of bounds.");
+        shape_type chunk_index(detail::chunkIndexOf(point, bits_));
+        Handle * handle = const_cast<Handle *>(&handle_array_[chunk_index]);
+        pointer p = getChunk(handle, true, chunk_index);
+        value_type res = p[detail::offsetInChunk(point, mask_, handle->pointer_->strides_)];
+        releaseChunk(handle);
+        return res;
+    }
+
+        /** Write \a v at position \a point.
+        */
+    void setItem(shape_type const & point, value_type const & v)
+    {
+        vigra_precondition(isInside(point),
+            "ChunkedArray::setItem(): index out of bounds.");
+        shape_type chunk_index(detail::chunkIndexOf(point, bits_));
+        Handle * handle = &handle_array_[chunk_index];
+        pointer p = getChunk(handle, false, chunk_index);
+        p[detail::offsetInChunk(point, mask_, handle->pointer_->strides_)] = v;
+        releaseChunk(handle);
+    }
+
+        /** Copy the region starting at \a start into \a subarray
+            (the region's shape is given by the shape of \a subarray).
+        */
+    template <class U, class Stride>
+    void checkoutSubarray(shape_type const & start,
+                          MultiArrayView<N, U, Stride> subarray) const
+    {
+        shape_type stop = start + subarray.shape();
+        checkSubarrayBounds(start, stop, "ChunkedArray::checkoutSubarray()");
+
+        chunk_iterator i = const_cast<self_type *>(this)->chunk_begin(start, stop, true),
+                       end = const_cast<self_type *>(this)->chunk_end(start, stop);
+        for(; i != end; ++i)
+            subarray.subarray(i.chunkStart()-start, i.chunkStop()-start).copy(*i);
+    }
+
+        /** Copy the data in \a subarray into the region starting at \a start.
+        */
+    template <class U, class Stride>
+    void commitSubarray(shape_type const & start,
+                        MultiArrayView<N, U, Stride> const & subarray)
+    {
+        shape_type stop = start + subarray.shape();
+        checkSubarrayBounds(start, stop, "ChunkedArray::commitSubarray()");
+
+        chunk_iterator i = chunk_begin(start, stop),
+                       end = chunk_end(start, stop);
+        for(; i != end; ++i)
+            i->copy(subarray.subarray(i.chunkStart()-start, i.chunkStop()-start));
+    }
+
+        /** Return a copy of the region <tt>[start, stop)</tt>.
+        */
+    MultiArray<N, T> subarray(shape_type const & start, shape_type const & stop) const
+    {
+        MultiArray<N, T> res(stop - start);
+        checkoutSubarray(start, res);
+        return res;
+    }
+
+        /** Create an iterator over all chunks intersecting the region
+            <tt>[start, stop)</tt>. The iterator dereferences to a view of
+            the intersection between the current chunk and the region.
+        */
+    chunk_iterator chunk_begin(shape_type const & start, shape_type const & stop)
+    {
+        return chunk_begin(start, stop, false);
+    }
+
+        /** Create the end iterator for <tt>chunk_begin(start, stop)</tt>.
+        */
+    chunk_iterator chunk_end(shape_type const & start, shape_type const & stop)
+    {
+        checkSubarrayBounds(start, stop, "ChunkedArray::chunk_end()");
+        shape_type chunk_start(detail::chunkIndexOf(start, bits_)),
+                   chunk_stop(detail::chunkIndexOf(stop - shape_type(1), bits_) + shape_type(1));
+        return chunk_iterator(this, start, stop, chunk_start, chunk_stop, chunk_stop[N-1], false);
+    }
+
+        /** Remove all chunks that lie completely inside the region
+            <tt>[start, stop)</tt> from memory (writing them back to their storage).
+            Chunks that are currently referenced by a chunk iterator are skipped.
+            If \a destroy is <tt>true</tt>, the chunks' data are discarded,
+            and subsequent reads return the fill value.
+        */
+    void releaseChunks(shape_type const & start, shape_type const & stop, bool destroy = false)
+    {
+        checkSubarrayBounds(start, stop, "ChunkedArray::releaseChunks()");
+        shape_type chunk_start(detail::chunkIndexOf(start + chunk_shape_ - shape_type(1), bits_)),
+                   chunk_stop(detail::chunkIndexOf(stop, bits_));
+        for(unsigned int k=0; k<N; ++k)
+            if(stop[k] == shape_[k])
+                chunk_stop[k] = handle_array_.shape(k);
+
+        MultiCoordinateIterator<N> i(chunk_start, chunk_stop),
+                                   end(i.getEndIterator());
+        for(; i != end; ++i)
+        {
+            Handle & handle = handle_array_[*i];
+            if(handle.chunk_state_ > 0)
+                continue;    // chunk is in use
+            if(handle.in_cache_)
+            {
+                cache_.erase(handle.cache_pos_);
+                handle.in_cache_ = false;
+            }
+            if(handle.pointer_ == 0)
+                continue;
+            if(handle.chunk_state_ == 0 || destroy)
+                unloadHandle(handle, destroy);
+        }
+    }
+
+  protected:
+        /* Load the chunk with the given index into memory and return a pointer
+           to its data. When '*chunk' is zero, the backend must create a new
+           chunk object, initialize it with the fill value, and store it in '*chunk'.
+        */
+    virtual pointer loadChunk(Chunk ** chunk, shape_type const & chunk_index) = 0;
+
+        /* Remove the chunk's data from memory (saving them to the backend's
+           storage unless 'destroy' is true). Return false if the backend
+           cannot release the chunk (e.g. because it has no secondary storage).
+        */
+    virtual bool unloadChunk(Chunk * chunk, bool destroy) = 0;
+
+        /* Backends must call this function in their destructor, because
+           unloadChunk() cannot be called from the base class destructor.
+        */
+    void deleteAllChunks(bool destroy)
+    {
+        cache_.clear();
+        typename MultiArray<N, Handle>::iterator i   = handle_array_.begin(),
+                                                 end = handle_array_.end();
+        for(; i != end; ++i)
+        {
+            if(i->pointer_ == 0)
+                continue;
+            if(i->pointer_->pointer_ != 0)
+                unloadChunk(i->pointer_, destroy);
+            delete i->pointer_;
+            i->pointer_ = 0;
+            i->chunk_state_ = Handle::chunk_uninitialized;
+            i->in_cache_ = false;
+        }
+    }
+
+    pointer getChunk(Handle * handle, bool isConst, shape_type const & chunk_index) const
+    {
+        vigra_precondition(isConst || !isReadOnly(),
+            "ChunkedArray::getChunk(): cannot write to a read-only array.");
+        self_type * self = const_cast<self_type *>(this);
+        if(handle->chunk_state_ < 0)
+        {
+            pointer p = self->loadChunk(&handle->pointer_, chunk_index);
+            vigra_postcondition(p != 0,
+                "ChunkedArray::getChunk(): unable to load chunk.");
+            handle->chunk_state_ = 0;
+        }
+        ++handle->chunk_state_;
+        if(!isConst)
+            handle->pointer_->dirty_ = true;
+
+        // move the chunk to the most-recently-used end of the cache
+        if(handle->in_cache_)
+        {
+            self->cache_.splice(self->cache_.end(), self->cache_, handle->cache_pos_);
+        }
+        else
+        {
+            handle->cache_pos_ = self->cache_.insert(self->cache_.end(), handle);
+            handle->in_cache_ = true;
+            self->cleanCache(2);
+        }
+        return handle->pointer_->pointer_;
+    }
+
+    void releaseChunk(Handle * handle) const
+    {
+        --handle->chunk_state_;
+    }
+
+        /* Remove up to 'how_many' least recently used chunks from the
+           cache, as long as the cache is larger than its maximum size.
+        */
+    void cleanCache(std::size_t how_many)
+    {
+        typename std::list<Handle *>::iterator i = cache_.begin();
+        for(; how_many > 0 && cache_.size() > cacheMaxSize() && i != cache_.end(); --how_many)
+        {
+            Handle * handle = *i;
+            if(handle->chunk_state_ > 0)
+            {
+                // chunk is in use => keep it
+                ++i;
+                continue;
+            }
+            i = cache_.erase(i);
+            handle->in_cache_ = false;
+            unloadHandle(*handle, false);
+        }
+    }
+
+    void unloadHandle(Handle & handle, bool destroy)
+    {
+        if(unloadChunk(handle.pointer_, destroy))
+        {
+            handle.pointer_->dirty_ = false;
+            handle.chunk_state_ = destroy
+                                     ? Handle::chunk_uninitialized
+                                     : Handle::chunk_asleep;
+            if(destroy)
+            {
+                delete handle.pointer_;
+                handle.pointer_ = 0;
+            }
+        }
+    }
+
+    void checkSubarrayBounds(shape_type const & start, shape_type const & stop,
+                             std::string message) const
+    {
+        bool ok = true;
+        for(unsigned int k=0; k<N; ++k)
+            if(start[k] < 0 || start[k] >= stop[k] || stop[k] > shape_[k])
+                ok = false;
+        message += ": subarray out of bounds.";
+        vigra_precondition(ok, message);
+    }
+
+    chunk_iterator chunk_begin(shape_type const & start, shape_type const & stop, bool isConst)
+    {
+        checkSubarrayBounds(start, stop, "ChunkedArray::chunk_begin()");
+        shape_type chunk_start(detail::chunkIndexOf(start, bits_)),
+                   chunk_stop(detail::chunkIndexOf(stop - shape_type(1), bits_) + shape_type(1));
+        return chunk_iterator(this, start, stop, chunk_start, chunk_stop, chunk_start[N-1], isConst);
+    }
+
+    shape_type shape_, chunk_shape_, bits_, mask_;
+    mutable int cache_max_size_;  // computed lazily by cacheMaxSize() when negative
+    T fill_value_;
+    MultiArray<N, Handle> handle_array_;
+    std::list<Handle *> cache_;
+
+  private:
+    ChunkedArray(ChunkedArray const &);
+    ChunkedArray & operator=(ChunkedArray const &);
+};
+
+/********************************************************/
+/*                                                      */
+/*                     ChunkIterator                    */
+/*                                                      */
+/********************************************************/
+
+namespace detail {
+
+    // MultiArrayView::operator=() copies data when the view is already bound,
+    // so the chunk iterator needs a way to point its view to the next chunk.
+template <unsigned int N, class T>
+class RebindableView
+: public MultiArrayView<N, T, StridedArrayTag>
+{
+  public:
+    typedef typename MultiArrayShape<N>::type shape_type;
+
+    void rebind(shape_type const & shape, shape_type const & stride, T * ptr)
+    {
+        this->m_shape = shape;
+        this->m_stride = stride;
+        this->m_ptr = ptr;
+    }
+};
+
+} // namespace detail
+
+/** \brief Iterate over the chunks of a \ref ChunkedArray.
+
+    Dereferencing the iterator returns a \ref MultiArrayView to the part of the
+    current chunk that is inside the iterator's region of interest. The chunk
+    remains locked in memory until the iterator moves on. Iteration proceeds in
+    scan-order of the chunk grid.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br/>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class ChunkIterator
+{
+  public:
+    typedef ChunkedArray<N, T>                     array_type;
+    typedef typename array_type::shape_type        shape_type;
+    typedef typename array_type::Handle            Handle;
+    typedef MultiArrayView<N, T, StridedArrayTag>  value_type;
+    typedef value_type &                           reference;
+    typedef value_type const &                     const_reference;
+    typedef value_type *                           pointer;
+    typedef value_type const *                     const_pointer;
+    typedef MultiArrayIndex                        difference_type;
+    typedef std::forward_iterator_tag              iterator_category;
+
+    ChunkIterator()
+    : array_(0)
+    , handle_(0)
+    , is_const_(true)
+    {}
+
+    ChunkIterator(array_type * array,
+                  shape_type const & start, shape_type const & stop,
+                  shape_type const & chunk_start, shape_type const & chunk_stop,
+                  MultiArrayIndex outer_chunk, bool isConst)
+    : array_(array)
+    , start_(start)
+    , stop_(stop)
+    , chunk_start_(chunk_start)
+    , chunk_stop_(chunk_stop)
+    , chunk_(chunk_start)
+    , handle_(0)
+    , is_const_(isConst)
+    {
+        chunk_[N-1] = outer_chunk;
+        getView();
+    }
+
+    ChunkIterator(ChunkIterator const & rhs)
+    : array_(rhs.array_)
+    , start_(rhs.start_)
+    , stop_(rhs.stop_)
+    , chunk_start_(rhs.chunk_start_)
+    , chunk_stop_(rhs.chunk_stop_)
+    , chunk_(rhs.chunk_)
+    , handle_(0)
+    , is_const_(rhs.is_const_)
+    {
+        getView();
+    }
+
+    ChunkIterator & operator=(ChunkIterator const & rhs)
+    {
+        if(this != &rhs)
+        {
+            release();
+            array_ = rhs.array_;
+            start_ = rhs.start_;
+            stop_ = rhs.stop_;
+            chunk_start_ = rhs.chunk_start_;
+            chunk_stop_ = rhs.chunk_stop_;
+            chunk_ = rhs.chunk_;
+            is_const_ = rhs.is_const_;
+            getView();
+        }
+        return *this;
+    }
+
+    ~ChunkIterator()
+    {
+        release();
+    }
+
+    reference operator*()
+    {
+        return view_;
+    }
+
+    pointer operator->()
+    {
+        return &view_;
+    }
+
+    ChunkIterator & operator++()
+    {
+        release();
+        for(unsigned int k=0; k<N; ++k)
+        {
+            if(++chunk_[k] < chunk_stop_[k] || k == N-1)
+                break;
+            chunk_[k] = chunk_start_[k];
+        }
+        getView();
+        return *this;
+    }
+
+    bool operator==(ChunkIterator const & rhs) const
+    {
+        return chunk_ == rhs.chunk_;
+    }
+
+    bool operator!=(ChunkIterator const & rhs) const
+    {
+        return chunk_ != rhs.chunk_;
+    }
+
+        /** Index of the current chunk in the chunk grid.
+        */
+    shape_type const & chunkIndex() const
+    {
+        return chunk_;
+    }
+
+        /** Array coordinate of the first element of the current view.
+        */
+    shape_type chunkStart() const
+    {
+        return max(start_, chunk_ * array_->chunk_shape_);
+    }
+
+        /** Array coordinate one past the last element of the current view.
+        */
+    shape_type chunkStop() const
+    {
+        return min(stop_, (chunk_ + shape_type(1)) * array_->chunk_shape_);
+    }
+
+  private:
+    bool isValid() const
+    {
+        return array_ != 0 && chunk_[N-1] < chunk_stop_[N-1];
+    }
+
+    void getView()
+    {
+        if(!isValid())
+        {
+            view_.rebind(shape_type(), shape_type(), 0);
+            return;
+        }
+        handle_ = &array_->handle_array_[chunk_];
+        T * p = array_->getChunk(handle_, is_const_, chunk_);
+        shape_type offset = chunkStart() - chunk_ * array_->chunk_shape_;
+        view_.rebind(chunkStop() - chunkStart(), handle_->pointer_->strides_,
+                     p + dot(offset, handle_->pointer_->strides_));
+    }
+
+    void release()
+    {
+        if(handle_ != 0)
+            array_->releaseChunk(handle_);
+        handle_ = 0;
+    }
+
+    array_type * array_;
+    shape_type start_, stop_, chunk_start_, chunk_stop_, chunk_;
+    Handle * handle_;
+    detail::RebindableView<N, T> view_;
+    bool is_const_;
+};
+
+/********************************************************/
+/*                                                      */
+/*                   ChunkedArrayLazy                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array that keeps all chunks in memory and allocates them
+           on first access.
+
+    This is useful for sparse data, because chunks that are never
+    accessed don't consume any memory. Since there is no secondary storage,
+    chunks are never swapped out (the cache size is irrelevant), but their memory
+    can be freed explicitly via <tt>releaseChunks(start, stop, true)</tt>.
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br/>
+    Namespace: vigra
+*/
+template <unsigned int N, class T, class Alloc = std::allocator<T> >
+class ChunkedArrayLazy
+: public ChunkedArray<N, T>
+{
+  public:
+    typedef ChunkedArray<N, T>                 base_type;
+    typedef typename base_type::shape_type     shape_type;
+    typedef typename base_type::pointer        pointer;
+    typedef typename base_type::Chunk          ChunkBaseType;
+    typedef ChunkIterator<N, T>                chunk_iterator;
+
+    class Chunk
+    : public ChunkBaseType
+    {
+      public:
+        Chunk(shape_type const & shape, Alloc const & alloc)
+        : ChunkBaseType(detail::defaultStride(shape))
+        , size_(prod(shape))
+        , alloc_(alloc)
+        {}
+
+        ~Chunk()
+        {
+            deallocate();
+        }
+
+        pointer allocate(T const & fill_value)
+        {
+            if(this->pointer_ == 0)
+            {
+                this->pointer_ = alloc_.allocate((typename Alloc::size_type)size_);
+                std::uninitialized_fill(this->pointer_, this->pointer_ + size_, fill_value);
+            }
+            return this->pointer_;
+        }
+
+        void deallocate()
+        {
+            if(this->pointer_ != 0)
+            {
+                detail::destroy_n(this->pointer_, size_);
+                alloc_.deallocate(this->pointer_, (typename Alloc::size_type)size_);
+            }
+            this->pointer_ = 0;
+        }
+
+        MultiArrayIndex size_;
+        Alloc alloc_;
+    };
+
+        /** Construct with given shape and chunk shape (a default chunk
+            shape is used if \a chunk_shape is zero).
+        */
+    explicit ChunkedArrayLazy(shape_type const & shape,
+                              shape_type const & chunk_shape = shape_type(),
+                              ChunkedArrayOptions const & options = ChunkedArrayOptions(),
+                              Alloc const & alloc = Alloc())
+    : base_type(shape, chunk_shape, options.cache_max < 0
+                                       ? ChunkedArrayOptions(options).cacheMax(NumericTraits<int>::max())
+                                       : options)
+    , alloc_(alloc)
+    {}
+
+    ~ChunkedArrayLazy()
+    {
+        this->deleteAllChunks(true);
+    }
+
+    virtual std::string backend() const
+    {
+        return "ChunkedArrayLazy";
+    }
+
+  protected:
+    virtual pointer loadChunk(ChunkBaseType ** p, shape_type const & index)
+    {
+        if(*p == 0)
+            *p = new Chunk(this->chunkShape(index), alloc_);
+        return static_cast<Chunk *>(*p)->allocate(this->fill_value_);
+    }
+
+    virtual bool unloadChunk(ChunkBaseType * chunk, bool destroy)
+    {
+        if(destroy)
+            static_cast<Chunk *>(chunk)->deallocate();
+        return destroy;
+    }
+
+    Alloc alloc_;
+};
+
+/********************************************************/
+/*                                                      */
+/*                  ChunkedArrayTmpFile                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array that swaps chunks out to a memory-mapped temporary file.
+
+    The file is created as a sparse file in the system's temporary directory
+    and is automatically deleted when the array is destroyed. Chunks that are in
+    the cache are mapped into memory, other chunks only occupy disk space (once
+    they have been written to).
+
+    <b>\#include</b> \<vigra/multi_array_chunked.hxx\><br/>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class ChunkedArrayTmpFile
+: public ChunkedArray<N, T>
+{
+  public:
+#ifdef _WIN32
+    typedef HANDLE FileHandle;
+#else
+    typedef int FileHandle;
+#endif
+
+    typedef ChunkedArray<N, T>                 base_type;
+    typedef typename base_type::shape_type     shape_type;
+    typedef typename base_type::pointer        pointer;
+    typedef typename base_type::Chunk          ChunkBaseType;
+    typedef ChunkIterator<N, T>                chunk_iterator;
+
+    class Chunk
+    : public ChunkBaseType
+    {
+      public:
+        Chunk(shape_type const & shape, std::size_t offset, std::size_t alloc_size,
+              FileHandle file)
+        : ChunkBaseType(detail::defaultStride(shape))
+        , offset_(offset)
+        , alloc_size_(alloc_size)
+        , file_(file)
+        {}
+
+        ~Chunk()
+        {
+            unmap();
+        }
+
+        pointer map()
+        {
+            if(this->pointer_ == 0)
+            {
+#ifdef _WIN32
+                static const std::size_t bits = sizeof(DWORD)*8,
+                                         mask = (std::size_t(1) << bits) - 1;
+                this->pointer_ = (pointer)MapViewOfFile(file_, FILE_MAP_ALL_ACCESS,
+                                           std::size_t(offset_) >> bits, offset_ & mask, alloc_size_);
+#else
+                void * p = mmap(0, alloc_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                file_, (off_t)offset_);
+                this->pointer_ = (p == MAP_FAILED) ? 0 : (pointer)p;
+#endif
+                vigra_postcondition(this->pointer_ != 0,
+                    "ChunkedArrayTmpFile: unable to map chunk into memory.");
+            }
+            return this->pointer_;
+        }
+
+        void unmap()
+        {
+            if(this->pointer_ != 0)
+            {
+#ifdef _WIN32
+                ::UnmapViewOfFile(this->pointer_);
+#else
+                munmap(this->pointer_, alloc_size_);
+#endif
+                this->pointer_ = 0;
+            }
+        }
+
+        std::size_t offset_, alloc_size_;
+        FileHandle file_;
+    };
+
+        /** Construct with given shape and chunk shape (a default chunk
+            shape is used if \a chunk_shape is zero). The temporary file
+            is created in the system's default location.
+        */
+    explicit ChunkedArrayTmpFile(shape_type const & shape,
+                                 shape_type const & chunk_shape = shape_type(),
+                                 ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    : base_type(shape, chunk_shape, options)
+    , offset_array_(this->chunkArrayShape())
+    , initialized_(this->chunkArrayShape())
+    , file_size_()
+    {
+        // compute the file offset of each chunk, respecting the mmap() alignment
+        std::size_t alignment = detail::mmap_alignment();
+        MultiCoordinateIterator<N> i(offset_array_.shape()),
+                                   end(i.getEndIterator());
+        for(; i != end; ++i)
+        {
+            offset_array_[*i] = file_size_;
+            std::size_t size = prod(this->chunkShape(*i))*sizeof(T);
+            file_size_ += ((size + alignment - 1) / alignment) * alignment;
+        }
+
+#ifdef _WIN32
+        mapped_file_ = file_ = INVALID_HANDLE_VALUE;
+        char path[MAX_PATH], name[MAX_PATH];
+        if(GetTempPathA(MAX_PATH, path) != 0 && GetTempFileNameA(path, "vig", 0, name) != 0)
+            file_ = ::CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+        vigra_postcondition(file_ != INVALID_HANDLE_VALUE,
+            "ChunkedArrayTmpFile(): unable to open temporary file.");
+
+        // mark the file as sparse
+        DWORD dwTemp;
+        ::DeviceIoControl(file_, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &dwTemp, NULL);
+
+        static const std::size_t bits = sizeof(DWORD)*8,
+                                 mask = (std::size_t(1) << bits) - 1;
+        mapped_file_ = CreateFileMapping(file_, NULL, PAGE_READWRITE,
+                                         file_size_ >> bits, file_size_ & mask, NULL);
+        vigra_postcondition(mapped_file_ != NULL,
+            "ChunkedArrayTmpFile(): unable to map temporary file.");
+#else
+        mapped_file_ = file_ = -1;
+        tmp_file_ = tmpfile();
+        vigra_postcondition(tmp_file_ != 0,
+            "ChunkedArrayTmpFile(): unable to open temporary file.");
+        mapped_file_ = file_ = fileno(tmp_file_);
+        vigra_postcondition(ftruncate(file_, (off_t)file_size_) == 0,
+            "ChunkedArrayTmpFile(): unable to resize temporary file.");
+#endif
+    }
+
+    ~ChunkedArrayTmpFile()
+    {
+        this->deleteAllChunks(true);
+#ifdef _WIN32
+        ::CloseHandle(mapped_file_);
+        ::CloseHandle(file_);
+#else
+        fclose(tmp_file_);
+#endif
+    }
+
+    virtual std::string backend() const
+    {
+        return "ChunkedArrayTmpFile";
+    }
+
+        /** Size of the temporary file in bytes (the file is sparse, so
+            the actual disk usage may be much lower).
+        */
+    std::size_t fileSize() const
+    {
+        return file_size_;
+    }
+
+  protected:
+    virtual pointer loadChunk(ChunkBaseType ** p, shape_type const & index)
+    {
+        bool initialize = false;
+        if(*p == 0)
+        {
+            shape_type shape = this->chunkShape(index);
+            std::size_t alloc_size = prod(shape)*sizeof(T);
+            *p = new Chunk(shape, offset_array_[index], alloc_size, mapped_file_);
+            initialize = true;
+        }
+        Chunk * chunk = static_cast<Chunk *>(*p);
+        pointer res = chunk->map();
+        // the file is zero-initialized, but a destroyed chunk may have left data behind
+        if(initialize && (this->fill_value_ != T() || initialized_[index] != 0))
+            std::fill(res, res + chunk->alloc_size_ / sizeof(T), this->fill_value_);
+        initialized_[index] = 1;
+        return res;
+    }
+
+    virtual bool unloadChunk(ChunkBaseType * chunk, bool /* destroy */)
+    {
+        // the data remain in the file when the chunk is unmapped
+        static_cast<Chunk *>(chunk)->unmap();
+        return true;
+    }
+
+    MultiArray<N, std::size_t> offset_array_;
+    MultiArray<N, UInt8> initialized_;
+    std::size_t file_size_;
+    FileHandle file_, mapped_file_;
+#ifndef _WIN32
+    FILE * tmp_file_;
+#endif
+};
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_CHUNKED_HXX
@@ -0,0 +1,314 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2013 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
+#define VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
+
+#include <string>
+#include "multi_array_chunked.hxx"
+#include "hdf5impex.hxx"
+
+namespace vigra {
+
+/********************************************************/
+/*                                                      */
+/*                   ChunkedArrayHDF5                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Chunked array that stores its data in an HDF5 dataset.
+
+    Chunks are read from the dataset when they are first accessed, and
+    modified chunks are written back when they are evicted from the cache,
+    when <tt>flushToDisk()</tt> is called, and upon destruction of the array.
+    The HDF5 dataset is created with the same chunk shape as the array,
+    so that each chunk maps to exactly one HDF5 chunk. When an existing
+    dataset is opened without an explicit chunk shape, the array uses the
+    dataset's chunk shape (rounded up to powers of 2). Arrays opened with
+    <tt>HDF5File::OpenReadOnly</tt> reject write access. The \ref HDF5File
+    must outlive the array.
+
+    <b>Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_array_chunked_hdf5.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    HDF5File file("volume.h5", HDF5File::Open);
+
+    // create a new dataset
+    ChunkedArrayHDF5<3, float> array(file, "data", HDF5File::New,
+                                     Shape3(2000, 2000, 2000), Shape3(64));
+    ...
+
+    // open an existing dataset for reading
+    ChunkedArrayHDF5<3, float> input(file, "data", HDF5File::OpenReadOnly);
+    \endcode
+*/
+template <unsigned int N, class T, class Alloc = std::allocator<T> >
+class ChunkedArrayHDF5
+: public ChunkedArray<N, T>
+{
+  public:
+    typedef ChunkedArray<N, T>                 base_type;
+    typedef typename base_type::shape_type     shape_type;
+    typedef typename base_type::pointer        pointer;
+    typedef typename base_type::Handle         Handle;
+    typedef typename base_type::Chunk          ChunkBaseType;
+    typedef ChunkIterator<N, T>                chunk_iterator;
+
+    class Chunk
+    : public ChunkBaseType
+    {
+      public:
+        Chunk(shape_type const & shape, shape_type const & start,
+              ChunkedArrayHDF5 * array, Alloc const & alloc)
+        : ChunkBaseType(detail::defaultStride(shape))
+        , shape_(shape)
+        , start_(start)
+        , array_(array)
+        , alloc_(alloc)
+        {}
+
+        ~Chunk()
+        {
+            deallocate();
+        }
+
+        pointer read(bool destroyed)
+        {
+            if(this->pointer_ == 0)
+            {
+                MultiArrayIndex size = prod(shape_);
+                this->pointer_ = alloc_.allocate((typename Alloc::size_type)size);
+                if(destroyed)
+                {
+                    // the file still holds the old data => overwrite them upon write()
+                    std::uninitialized_fill(this->pointer_, this->pointer_ + size, array_->fill_value_);
+                    this->dirty_ = true;
+                }
+                else
+                {
+                    std::uninitialized_fill(this->pointer_, this->pointer_ + size, T());
+                    array_->file_.readBlock(array_->dataset_name_, start_, shape_,
+                                            MultiArrayView<N, T>(shape_, this->strides_, this->pointer_));
+                }
+            }
+            return this->pointer_;
+        }
+
+        void write()
+        {
+            if(this->pointer_ != 0 && this->dirty_ && !array_->read_only_)
+            {
+                array_->file_.writeBlock(array_->dataset_name_, start_,
+                                         MultiArrayView<N, T>(shape_, this->strides_, this->pointer_));
+                this->dirty_ = false;
+            }
+        }
+
+        void deallocate()
+        {
+            if(this->pointer_ != 0)
+            {
+                MultiArrayIndex size = prod(shape_);
+                detail::destroy_n(this->pointer_, size);
+                alloc_.deallocate(this->pointer_, (typename Alloc::size_type)size);
+            }
+            this->pointer_ = 0;
+        }
+
+        shape_type shape_, start_;
+        ChunkedArrayHDF5 * array_;
+        Alloc alloc_;
+    };
+
+        /** Create a new dataset (if \a mode is <tt>HDF5File::New</tt> or the dataset
+            doesn't exist yet) or open an existing dataset (otherwise). When a new dataset
+            is created, it is filled with the fill value given in \a options.
+            When an existing dataset is opened, its shape must match \a shape unless
+            \a shape is zero, and the dataset's chunk shape is used unless
+            \a chunk_shape is non-zero. \a compression (0...9) is only used for new datasets.
+        */
+    ChunkedArrayHDF5(HDF5File & file, std::string const & dataset,
+                     HDF5File::OpenMode mode,
+                     shape_type const & shape,
+                     shape_type const & chunk_shape = shape_type(),
+                     ChunkedArrayOptions const & options = ChunkedArrayOptions(),
+                     int compression = 0,
+                     Alloc const & alloc = Alloc())
+    : base_type(initDataset(file, dataset, mode, shape, chunk_shape, options, compression),
+                initChunkShape(file, dataset, mode, chunk_shape), options)
+    , file_(file)
+    , dataset_name_(dataset)
+    , read_only_(mode == HDF5File::OpenReadOnly)
+    , destroyed_(this->chunkArrayShape())
+    , alloc_(alloc)
+    {}
+
+        /** Open an existing dataset. Its shape and chunk shape are determined from the file.
+        */
+    ChunkedArrayHDF5(HDF5File & file, std::string const & dataset,
+                     HDF5File::OpenMode mode = HDF5File::OpenReadOnly,
+                     ChunkedArrayOptions const & options = ChunkedArrayOptions(),
+                     Alloc const & alloc = Alloc())
+    : base_type(initDataset(file, dataset, mode, shape_type(), shape_type(), options, 0),
+                initChunkShape(file, dataset, mode, shape_type()), options)
+    , file_(file)
+    , dataset_name_(dataset)
+    , read_only_(mode == HDF5File::OpenReadOnly)
+    , destroyed_(this->chunkArrayShape())
+    , alloc_(alloc)
+    {}
+
+    ~ChunkedArrayHDF5()
+    {
+        flushToDisk();
+        this->deleteAllChunks(true);
+    }
+
+    virtual std::string backend() const
+    {
+        return "ChunkedArrayHDF5";
+    }
+
+        /** Name of the dataset holding the data.
+        */
+    std::string const & datasetName() const
+    {
+        return dataset_name_;
+    }
+
+        /** Check if the array was opened in read-only mode.
+        */
+    virtual bool isReadOnly() const
+    {
+        return read_only_;
+    }
+
+        /** Write all modified chunks to the file (they remain in the cache)
+            and flush the file.
+        */
+    void flushToDisk()
+    {
+        if(read_only_)
+            return;
+        typename MultiArray<N, Handle>::iterator i   = this->handle_array_.begin(),
+                                                 end = this->handle_array_.end();
+        for(; i != end; ++i)
+            if(i->pointer_ != 0)
+                static_cast<Chunk *>(i->pointer_)->write();
+        file_.flushToDisk();
+    }
+
+  protected:
+    virtual pointer loadChunk(ChunkBaseType ** p, shape_type const & index)
+    {
+        if(*p == 0)
+            *p = new Chunk(this->chunkShape(index), index*this->chunk_shape_, this, alloc_);
+        pointer res = static_cast<Chunk *>(*p)->read(destroyed_[index] != 0);
+        // a read-only array cannot overwrite the file, so it must refill the chunk every time
+        if(!read_only_)
+            destroyed_[index] = 0;
+        return res;
+    }
+
+    virtual bool unloadChunk(ChunkBaseType * chunk, bool destroy)
+    {
+        Chunk * c = static_cast<Chunk *>(chunk);
+        if(destroy)
+            destroyed_[detail::chunkIndexOf(c->start_, this->bits_)] = 1;
+        else
+            c->write();
+        c->deallocate();
+        return true;
+    }
+
+        // create the dataset if needed and return the array shape
+    static shape_type initDataset(HDF5File & file, std::string const & dataset,
+                                  HDF5File::OpenMode mode,
+                                  shape_type const & shape, shape_type const & chunk_shape,
+                                  ChunkedArrayOptions const & options, int compression)
+    {
+        if(mode == HDF5File::New || !file.existsDataset(dataset))
+        {
+            vigra_precondition(mode != HDF5File::OpenReadOnly,
+                "ChunkedArrayHDF5(): dataset does not exist in read-only mode.");
+            vigra_precondition(prod(shape) > 0,
+                "ChunkedArrayHDF5(): cannot create dataset with zero shape.");
+            shape_type cshape(prod(chunk_shape) > 0
+                                  ? chunk_shape
+                                  : detail::ChunkShape<N>::defaultShape());
+            file.createDataset<N, T>(dataset, shape, T(options.fill_value),
+                                     min(cshape, shape), compression);
+            return shape;
+        }
+
+        ArrayVector<hsize_t> fileShape(file.getDatasetShape(dataset));
+        vigra_precondition(fileShape.size() == N,
+            "ChunkedArrayHDF5(): dataset has wrong dimension.");
+        shape_type res;
+        for(unsigned int k=0; k<N; ++k)
+            res[k] = (MultiArrayIndex)fileShape[k];
+        vigra_precondition(prod(shape) == 0 || shape == res,
+            "ChunkedArrayHDF5(): shape mismatch between dataset and array.");
+        return res;
+    }
+
+        // use the dataset's chunk shape unless a chunk shape is given explicitly
+    static shape_type initChunkShape(HDF5File & file, std::string const & dataset,
+                                     HDF5File::OpenMode mode, shape_type const & chunk_shape)
+    {
+        if(prod(chunk_shape) > 0 || mode == HDF5File::New || !file.existsDataset(dataset))
+            return chunk_shape;
+        ArrayVector<hsize_t> fileChunks(file.getChunkShape(dataset));
+        if(fileChunks.size() != N)
+            return chunk_shape;
+        shape_type res;
+        for(unsigned int k=0; k<N; ++k)
+            res[k] = (MultiArrayIndex)ceilPower2(UInt32(fileChunks[k]));
+        return res;
+    }
+
+    HDF5File & file_;
+    std::string dataset_name_;
+    bool read_only_;
+    MultiArray<N, UInt8> destroyed_;
+    Alloc alloc_;
+};
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
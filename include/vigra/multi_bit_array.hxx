@@ -0,0 +1,389 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_BIT_ARRAY_HXX
+#define VIGRA_MULTI_BIT_ARRAY_HXX
+
+#include <algorithm>
+#include "multi_array.hxx"
+#include "sized_int.hxx"
+
+namespace vigra {
+
+namespace detail {
+
+inline MultiArrayIndex bitCount(UInt64 w)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (MultiArrayIndex)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+    // Shift the bit line 'src' of n words by 's' bits towards higher bit
+    // indices (s > 0) or towards lower bit indices (s < 0), i.e.
+    // bit i of 'dest' becomes bit i-s of 'src'. Bits shifted in from outside
+    // the line are set to 'fill'. 'src' and 'dest' must not overlap.
+inline void
+shiftBitLine(UInt64 const * src, UInt64 * dest, MultiArrayIndex n,
+             MultiArrayIndex s, bool fill)
+{
+    UInt64 fillWord = fill ? ~UInt64(0) : UInt64(0);
+    MultiArrayIndex q = (s < 0 ? -s : s) / 64;
+    int b = (int)((s < 0 ? -s : s) % 64);
+    for(MultiArrayIndex w = 0; w < n; ++w)
+    {
+        // the words of 'src' that contribute to word w of 'dest'
+        MultiArrayIndex k0 = s < 0 ? w + q : w - q,
+                        k1 = s < 0 ? k0 + 1 : k0 - 1;
+        UInt64 w0 = k0 >= 0 && k0 < n ? src[k0] : fillWord;
+        if(b == 0)
+        {
+            dest[w] = w0;
+            continue;
+        }
+        UInt64 w1 = k1 >= 0 && k1 < n ? src[k1] : fillWord;
+        dest[w] = s < 0 ? (w0 >> b) | (w1 << (64 - b))
+                        : (w0 << b) | (w1 >> (64 - b));
+    }
+}
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                     MultiBitArray                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Bit-packed N-dimensional binary array.
+
+    <b>\#include</b> \<vigra/multi_bit_array.hxx\><br/>
+    Namespace: vigra
+
+    The array stores one bit per element, packing 64 consecutive elements
+    along dimension 0 into a <tt>UInt64</tt> word. Each line along dimension 0
+    starts at a new word, and the unused bits at the end of a line are always zero.
+    The words are held in a <tt>MultiArray<N, UInt64></tt> of shape
+    <tt>(ceil(shape[0] / 64), shape[1], ..., shape[N-1])</tt>, which is
+    accessible via <tt>words()</tt>, so that algorithms can process 64 elements
+    per operation (see \ref multiBinaryBoxErosion() and \ref multiBinaryHitOrMiss()).
+    Compared to a <tt>MultiArray<N, UInt8></tt>, a mask needs eight times less memory.
+
+    \code
+    MultiArray<3, float> volume(Shape3(width, height, depth));
+    ...
+    MultiArray<3, UInt8> mask(volume.shape());
+    transformMultiArray(volume, mask, Arg1() > Param(threshold));
+
+    MultiBitArray<3> bits(mask), eroded(mask.shape());
+    multiBinaryBoxErosion(bits, eroded, 2);
+    eroded.unpack(mask);
+    \endcode
+*/
+template <unsigned int N>
+class MultiBitArray
+{
+  public:
+    typedef UInt64                                 word_type;
+    typedef typename MultiArrayShape<N>::type      difference_type;
+    typedef MultiArray<N, word_type>               word_array_type;
+    typedef bool                                   value_type;
+
+    static const int bits_per_word = 64;
+
+        /** Construct an empty array.
+        */
+    MultiBitArray()
+    : shape_(),
+      last_mask_(0)
+    {}
+
+        /** Construct an array of the given shape with all bits set to \a init.
+        */
+    explicit MultiBitArray(difference_type const & shape, bool init = false)
+    {
+        reshape(shape, init);
+    }
+
+        /** Construct from a scalar array, setting the bits of all non-zero elements.
+        */
+    template <class T, class S>
+    explicit MultiBitArray(MultiArrayView<N, T, S> const & mask)
+    {
+        reshape(mask.shape());
+        pack(mask);
+    }
+
+        /** Change the shape and set all bits to \a init.
+        */
+    void reshape(difference_type const & shape, bool init = false)
+    {
+        shape_ = shape;
+        difference_type wordShape(shape);
+        wordShape[0] = (shape[0] + bits_per_word - 1) / bits_per_word;
+        int tail = (int)(shape[0] % bits_per_word);
+        last_mask_ = tail == 0 ? ~word_type(0) : (word_type(1) << tail) - 1;
+        words_.reshape(wordShape);
+        this->init(init);
+    }
+
+        /** Set all bits to \a value.
+        */
+    MultiBitArray & init(bool value)
+    {
+        words_.init(value ? ~word_type(0) : word_type(0));
+        if(value)
+            clearPadding();
+        return *this;
+    }
+
+        /** Set the bits of all non-zero elements of \a mask and clear the others.
+            The shapes must agree.
+        */
+    template <class T, class S>
+    void pack(MultiArrayView<N, T, S> const & mask)
+    {
+        vigra_precondition(mask.shape() == shape_,
+            "MultiBitArray::pack(): shape mismatch.");
+        if(size() == 0)
+            return;
+        typename MultiArrayView<N, T, S>::const_iterator i = mask.begin();
+        word_type * w = words_.data();
+        for(MultiArrayIndex k = 0, lines = size() / shape_[0]; k < lines; ++k)
+        {
+            for(MultiArrayIndex x0 = 0; x0 < shape_[0]; x0 += bits_per_word, ++w)
+            {
+                MultiArrayIndex x1 = std::min<MultiArrayIndex>(x0 + bits_per_word, shape_[0]);
+                word_type bits = 0;
+                for(MultiArrayIndex x = x0; x < x1; ++x, ++i)
+                    if(*i != NumericTraits<T>::zero())
+                        bits |= word_type(1) << (x - x0);
+                *w = bits;
+            }
+        }
+    }
+
+        /** Write \a foreground for all set bits and \a background for the others
+            into \a dest. The shapes must agree.
+        */
+    template <class T, class S>
+    void unpack(MultiArrayView<N, T, S> dest,
+                T foreground = NumericTraits<T>::one(),
+                T background = NumericTraits<T>::zero()) const
+    {
+        vigra_precondition(dest.shape() == shape_,
+            "MultiBitArray::unpack(): shape mismatch.");
+        if(size() == 0)
+            return;
+        typename MultiArrayView<N, T, S>::iterator i = dest.begin();
+        word_type const * w = words_.data();
+        for(MultiArrayIndex k = 0, lines = size() / shape_[0]; k < lines; ++k)
+        {
+            for(MultiArrayIndex x0 = 0; x0 < shape_[0]; x0 += bits_per_word, ++w)
+            {
+                MultiArrayIndex x1 = std::min<MultiArrayIndex>(x0 + bits_per_word, shape_[0]);
+                word_type bits = *w;
+                for(MultiArrayIndex x = x0; x < x1; ++x, ++i, bits >>= 1)
+                    *i = (bits & 1) != 0 ? foreground : background;
+            }
+        }
+    }
+
+        /** The shape of the array (in elements, not words).
+        */
+    difference_type const & shape() const
+    {
+        return shape_;
+    }
+
+    MultiArrayIndex shape(int k) const
+    {
+        return shape_[k];
+    }
+
+        /** The number of elements.
+        */
+    MultiArrayIndex size() const
+    {
+        return prod(shape_);
+    }
+
+        /** Check if the given point is inside the array.
+        */
+    bool isInside(difference_type const & p) const
+    {
+        for(unsigned int k=0; k<N; ++k)
+            if(p[k] < 0 || p[k] >= shape_[k])
+                return false;
+        return true;
+    }
+
+        /** Read the bit at point \a p.
+        */
+    bool operator[](difference_type const & p) const
+    {
+        difference_type w(p);
+        w[0] /= bits_per_word;
+        return ((words_[w] >> (p[0] % bits_per_word)) & 1) != 0;
+    }
+
+        /** Set the bit at point \a p to \a value.
+        */
+    void set(difference_type const & p, bool value = true)
+    {
+        difference_type w(p);
+        w[0] /= bits_per_word;
+        word_type bit = word_type(1) << (p[0] % bits_per_word);
+        if(value)
+            words_[w] |= bit;
+        else
+            words_[w] &= ~bit;
+    }
+
+        /** The number of set bits.
+        */
+    MultiArrayIndex count() const
+    {
+        MultiArrayIndex res = 0;
+        for(word_type const * w = words_.data(), * end = w + words_.size(); w != end; ++w)
+            res += detail::bitCount(*w);
+        return res;
+    }
+
+        /** Complement all bits.
+        */
+    MultiBitArray & flip()
+    {
+        for(word_type * w = words_.data(), * end = w + words_.size(); w != end; ++w)
+            *w = ~*w;
+        clearPadding();
+        return *this;
+    }
+
+    MultiBitArray & operator&=(MultiBitArray const & other)
+    {
+        vigra_precondition(shape_ == other.shape_,
+            "MultiBitArray::operator&=(): shape mismatch.");
+        word_type const * o = other.words_.data();
+        for(word_type * w = words_.data(), * end = w + words_.size(); w != end; ++w, ++o)
+            *w &= *o;
+        return *this;
+    }
+
+    MultiBitArray & operator|=(MultiBitArray const & other)
+    {
+        vigra_precondition(shape_ == other.shape_,
+            "MultiBitArray::operator|=(): shape mismatch.");
+        word_type const * o = other.words_.data();
+        for(word_type * w = words_.data(), * end = w + words_.size(); w != end; ++w, ++o)
+            *w |= *o;
+        return *this;
+    }
+
+    MultiBitArray & operator^=(MultiBitArray const & other)
+    {
+        vigra_precondition(shape_ == other.shape_,
+            "MultiBitArray::operator^=(): shape mismatch.");
+        word_type const * o = other.words_.data();
+        for(word_type * w = words_.data(), * end = w + words_.size(); w != end; ++w, ++o)
+            *w ^= *o;
+        return *this;
+    }
+
+    bool operator==(MultiBitArray const & other) const
+    {
+        return shape_ == other.shape_ && words_ == other.words_;
+    }
+
+    bool operator!=(MultiBitArray const & other) const
+    {
+        return !operator==(other);
+    }
+
+    void swap(MultiBitArray & other)
+    {
+        std::swap(shape_, other.shape_);
+        std::swap(last_mask_, other.last_mask_);
+        words_.swap(other.words_);
+    }
+
+        /** The array of words. Functions that write into the words must keep
+            the padding bits (those after <tt>lastWordMask()</tt> in the last
+            word of each line) at zero.
+        */
+    word_array_type const & words() const
+    {
+        return words_;
+    }
+
+    word_array_type & words()
+    {
+        return words_;
+    }
+
+        /** The mask of valid bits in the last word of each line.
+        */
+    word_type lastWordMask() const
+    {
+        return last_mask_;
+    }
+
+        /** Reset the padding bits to zero.
+        */
+    void clearPadding()
+    {
+        if(last_mask_ == ~word_type(0) || words_.size() == 0)
+            return;
+        MultiArrayIndex n = words_.shape(0);
+        for(word_type * w = words_.data() + n - 1, * end = words_.data() + words_.size();
+            w < end; w += n)
+            *w &= last_mask_;
+    }
+
+  private:
+    difference_type shape_;
+    word_type last_mask_;
+    word_array_type words_;
+};
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_BIT_ARRAY_HXX
@@ -0,0 +1,472 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_MULTI_BLOCKWISE_HXX
+#define VIGRA_MULTI_BLOCKWISE_HXX
+
+#include <algorithm>
+#include "multi_array.hxx"
+#include "multi_convolution.hxx"
+#include "threadpool.hxx"
+
+namespace vigra {
+
+/********************************************************/
+/*                                                      */
+/*             BlockwiseConvolutionOptions              */
+/*                                                      */
+/********************************************************/
+
+/** \brief Options class template for blockwise convolutions.
+
+  <b>\#include</b> \<vigra/multi_blockwise.hxx\><br/>
+  Namespace: vigra
+
+  In addition to the options in \ref ConvolutionOptions, this class specifies
+  the shape of the blocks the array is split into and the number of threads
+  (see \ref ParallelOptions). The filter options must be set on a
+  \ref ConvolutionOptions object that is then passed to the constructor,
+  because the setters of the base classes return base class references:
+
+  \code
+  BlockwiseConvolutionOptions<3> opt(ConvolutionOptions<3>().stepSize(1.0, 1.0, 3.0));
+  opt.blockShape(Shape3(64)).numThreads(4);
+
+  gaussianSmoothMultiArray(source, dest, 2.0, opt);
+  \endcode
+*/
+template <unsigned int N>
+class BlockwiseConvolutionOptions
+: public ConvolutionOptions<N>
+, public ParallelOptions
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    BlockwiseConvolutionOptions()
+    : block_shape_(defaultBlockShape())
+    {}
+
+    BlockwiseConvolutionOptions(ConvolutionOptions<N> const & opt)
+    : ConvolutionOptions<N>(opt)
+    , block_shape_(defaultBlockShape())
+    {}
+
+        /** Shape of the blocks (without halo). Along each axis, a value
+            of zero or less means 'do not split this axis'.
+
+            Default: <tt>64</tt> along each axis for 3D and higher,
+            <tt>512</tt> for 2D, and <tt>65536</tt> for 1D.
+        */
+    BlockwiseConvolutionOptions & blockShape(Shape const & shape)
+    {
+        block_shape_ = shape;
+        return *this;
+    }
+
+    Shape const & getBlockShape() const
+    {
+        return block_shape_;
+    }
+
+        /** Set the number of threads (see \ref ParallelOptions::numThreads()).
+        */
+    BlockwiseConvolutionOptions & numThreads(const int n)
+    {
+        ParallelOptions::numThreads(n);
+        return *this;
+    }
+
+  private:
+    static Shape defaultBlockShape()
+    {
+        return Shape(N == 1
+                        ? 65536
+                        : N == 2
+                            ? 512
+                            : 64);
+    }
+
+    Shape block_shape_;
+};
+
+namespace detail {
+
+    // Compute the halo needed to filter a block without border effects.
+    // This is the radius of the largest kernel used by the filter, which
+    // is determined by creating the kernel exactly as the filter does.
+    // Recursive filters need their (larger) effective support instead.
+template <unsigned int N>
+typename MultiArrayShape<N>::type
+blockwiseHalo(ConvolutionOptions<N> const & opt, int order, const char * function_name)
+{
+    typename MultiArrayShape<N>::type halo;
+    typename ConvolutionOptions<N>::ScaleIterator params = opt.scaleParams();
+    for(unsigned int k=0; k<N; ++k, ++params)
+    {
+        if(opt.use_recursive_filter)
+        {
+            halo[k] = recursiveGaussianMargin(params.sigma_scaled(function_name), order);
+            continue;
+        }
+        Kernel1D<double> kernel;
+        if(order == 0)
+            kernel.initGaussian(params.sigma_scaled(function_name), 1.0, opt.window_ratio);
+        else
+            kernel.initGaussianDerivative(params.sigma_scaled(function_name), order, 1.0, opt.window_ratio);
+        halo[k] = std::max(-kernel.left(), kernel.right());
+    }
+    return halo;
+}
+
+template <unsigned int N, class T1, class S1, class T2, class S2, class FILTER>
+class BlockwiseFilterTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    BlockwiseFilterTask(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        ConvolutionOptions<N> const & opt,
+                        Shape const & roi_start, Shape const & block_shape,
+                        Shape const & halo, FILTER const & filter)
+    : source_(source)
+    , dest_(dest)
+    , opt_(opt)
+    , roi_start_(roi_start)
+    , block_shape_(block_shape)
+    , blocks_((dest.shape() + block_shape - Shape(1)) / block_shape)
+    , halo_(halo)
+    , filter_(filter)
+    {
+        // the blocks define their own ROI
+        opt_.subarray(Shape(), Shape());
+    }
+
+    MultiArrayIndex blockCount() const
+    {
+        return prod(blocks_);
+    }
+
+    void operator()(int, MultiArrayIndex index) const
+    {
+        Shape block;
+        detail::ScanOrderToCoordinate<N>::exec(index, blocks_, block);
+
+        // block core in destination coordinates
+        Shape start = block * block_shape_,
+              stop  = min(start + block_shape_, dest_.shape());
+
+        // block core and halo in source coordinates
+        Shape sstart = roi_start_ + start,
+              sstop  = roi_start_ + stop,
+              hstart = max(sstart - halo_, Shape()),
+              hstop  = min(sstop + halo_, source_.shape());
+
+        ConvolutionOptions<N> opt(opt_);
+        opt.subarray(sstart - hstart, sstop - hstart);
+        filter_(source_.subarray(hstart, hstop), dest_.subarray(start, stop), opt);
+    }
+
+  private:
+    MultiArrayView<N, T1, S1> source_;
+    MultiArrayView<N, T2, S2> dest_;
+    ConvolutionOptions<N> opt_;
+    Shape roi_start_, block_shape_, blocks_, halo_;
+    FILTER filter_;
+};
+
+    // Split 'dest' into blocks and apply 'filter' to each block in parallel.
+    // 'source' must be large enough to contain the ROI given in 'opt'.
+template <unsigned int N, class T1, class S1, class T2, class S2, class FILTER>
+void
+blockwiseFilter(MultiArrayView<N, T1, S1> const & source,
+                MultiArrayView<N, T2, S2> dest,
+                BlockwiseConvolutionOptions<N> const & opt,
+                typename MultiArrayShape<N>::type const & halo,
+                FILTER const & filter,
+                const char * function_name)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    Shape roi_start, roi_stop(source.shape());
+    if(opt.to_point != Shape())
+    {
+        roi_start = opt.from_point;
+        roi_stop  = opt.to_point;
+        detail::RelativeToAbsoluteCoordinate<N-1>::exec(source.shape(), roi_start);
+        detail::RelativeToAbsoluteCoordinate<N-1>::exec(source.shape(), roi_stop);
+        vigra_precondition(dest.shape() == (roi_stop - roi_start),
+            std::string(function_name) + "(): shape mismatch between ROI and output.");
+    }
+    else
+    {
+        vigra_precondition(source.shape() == dest.shape(),
+            std::string(function_name) + "(): shape mismatch between input and output.");
+    }
+
+    Shape block_shape(opt.getBlockShape());
+    for(unsigned int k=0; k<N; ++k)
+        if(block_shape[k] <= 0 || block_shape[k] > dest.shape(k))
+            block_shape[k] = dest.shape(k);
+    if(prod(block_shape) == 0)
+        return;
+
+    BlockwiseFilterTask<N, T1, S1, T2, S2, FILTER>
+        task(source, dest, opt, roi_start, block_shape, halo, filter);
+    parallel_foreach(opt, task.blockCount(), task);
+}
+
+struct BlockwiseGaussianSmoothFunctor
+{
+    template <class SRC, class DEST, class OPT>
+    void operator()(SRC const & source, DEST const & dest, OPT const & opt) const
+    {
+        gaussianSmoothMultiArray(source, dest, opt);
+    }
+};
+
+struct BlockwiseGaussianGradientFunctor
+{
+    template <class SRC, class DEST, class OPT>
+    void operator()(SRC const & source, DEST const & dest, OPT const & opt) const
+    {
+        gaussianGradientMultiArray(source, dest, opt);
+    }
+};
+
+struct BlockwiseHessianOfGaussianFunctor
+{
+    template <class SRC, class DEST, class OPT>
+    void operator()(SRC const & source, DEST const & dest, OPT const & opt) const
+    {
+        hessianOfGaussianMultiArray(source, dest, opt);
+    }
+};
+
+struct BlockwiseStructureTensorFunctor
+{
+    template <class SRC, class DEST, class OPT>
+    void operator()(SRC const & source, DEST const & dest, OPT const & opt) const
+    {
+        structureTensorMultiArray(source, dest, opt);
+    }
+};
+
+} // namespace detail
+
+/** \addtogroup MultiArrayConvolutionFilters
+*/
+//@{
+
+/** \brief Blockwise parallel versions of the Gaussian filters.
+
+    When the filters \ref gaussianSmoothMultiArray(), \ref gaussianGradientMultiArray(),
+    \ref hessianOfGaussianMultiArray() and \ref structureTensorMultiArray() are called
+    with a \ref BlockwiseConvolutionOptions object, the output array is split into
+    blocks of the given shape, and the blocks are processed by a pool of threads.
+    Each block is computed from the corresponding input region enlarged by a halo,
+    whose width is the radius of the filter kernels as determined by the scale,
+    the step size and the filter window size in the options. Only the block core
+    is written to the output, so the result is identical to the non-blockwise
+    function (up to round-off), but the size of the temporary arrays is bounded
+    by the block size rather than the array size. All other options (including
+    the ROI given by <tt>subarray()</tt>) have the same meaning as in the
+    non-blockwise functions.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        gaussianSmoothMultiArray(MultiArrayView<N, T1, S1> const & source,
+                                 MultiArrayView<N, T2, S2> dest,
+                                 double sigma,
+                                 BlockwiseConvolutionOptions<N> const & opt);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
+                                   MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
+                                   double sigma,
+                                   BlockwiseConvolutionOptions<N> const & opt);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        hessianOfGaussianMultiArray(MultiArrayView<N, T1, S1> const & source,
+                                    MultiArrayView<N, TinyVector<T2, int(N*(N+1)/2)>, S2> dest,
+                                    double sigma,
+                                    BlockwiseConvolutionOptions<N> const & opt);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        structureTensorMultiArray(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, TinyVector<T2, int(N*(N+1)/2)>, S2> dest,
+                                  double innerScale, double outerScale,
+                                  BlockwiseConvolutionOptions<N> const & opt);
+    }
+    \endcode
+
+    Variants without explicit scale parameters take the scales from the options
+    object (via <tt>stdDev()</tt> or <tt>innerScale()</tt> and <tt>outerScale()</tt>).
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_blockwise.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, float> source(Shape3(1000, 1000, 200));
+    MultiArray<3, TinyVector<float, 3> > gradient(source.shape());
+    ...
+    BlockwiseConvolutionOptions<3> opt;
+    opt.blockShape(Shape3(128, 128, 64)).numThreads(ParallelOptions::Auto);
+
+    gaussianGradientMultiArray(source, gradient, 2.0, opt);
+    \endcode
+*/
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+gaussianSmoothMultiArray(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         BlockwiseConvolutionOptions<N> const & opt)
+{
+    detail::blockwiseFilter(source, dest, opt,
+                            detail::blockwiseHalo(opt, 0, "gaussianSmoothMultiArray"),
+                            detail::BlockwiseGaussianSmoothFunctor(),
+                            "gaussianSmoothMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+gaussianSmoothMultiArray(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         double sigma,
+                         BlockwiseConvolutionOptions<N> opt)
+{
+    opt.stdDev(sigma);
+    gaussianSmoothMultiArray(source, dest, opt);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
+                           MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
+                           BlockwiseConvolutionOptions<N> const & opt)
+{
+    detail::blockwiseFilter(source, dest, opt,
+                            detail::blockwiseHalo(opt, 1, "gaussianGradientMultiArray"),
+                            detail::BlockwiseGaussianGradientFunctor(),
+                            "gaussianGradientMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
+                           MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
+                           double sigma,
+                           BlockwiseConvolutionOptions<N> opt)
+{
+    opt.stdDev(sigma);
+    gaussianGradientMultiArray(source, dest, opt);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+hessianOfGaussianMultiArray(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, TinyVector<T2, int(N*(N+1)/2)>, S2> dest,
+                            BlockwiseConvolutionOptions<N> const & opt)
+{
+    detail::blockwiseFilter(source, dest, opt,
+                            detail::blockwiseHalo(opt, 2, "hessianOfGaussianMultiArray"),
+                            detail::BlockwiseHessianOfGaussianFunctor(),
+                            "hessianOfGaussianMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+hessianOfGaussianMultiArray(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, TinyVector<T2, int(N*(N+1)/2)>, S2> dest,
+                            double sigma,
+                            BlockwiseConvolutionOptions<N> opt)
+{
+    opt.stdDev(sigma);
+    hessianOfGaussianMultiArray(source, dest, opt);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+structureTensorMultiArray(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, TinyVector<T2, int(N*(N+1)/2)>, S2> dest,
+                          BlockwiseConvolutionOptions<N> const & opt)
+{
+    // the gradient must be valid in the core dilated by the outer kernel
+    typename MultiArrayShape<N>::type halo =
+        detail::blockwiseHalo(opt, 1, "structureTensorMultiArray") +
+        detail::blockwiseHalo(opt.outerOptions(), 0, "structureTensorMultiArray");
+    detail::blockwiseFilter(source, dest, opt, halo,
+                            detail::BlockwiseStructureTensorFunctor(),
+                            "structureTensorMultiArray");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+structureTensorMultiArray(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, TinyVector<T2, int(N*(N+1)/2)>, S2> dest,
+                          double innerScale, double outerScale,
+                          BlockwiseConvolutionOptions<N> opt)
+{
+    opt.innerScale(innerScale).outerScale(outerScale);
+    structureTensorMultiArray(source, dest, opt);
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_BLOCKWISE_HXX
@@ -0,0 +1,452 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef VIGRA_MULTI_COMPONENT_TREE_HXX
+#define VIGRA_MULTI_COMPONENT_TREE_HXX
+
+#include <functional>
+#include "multi_array.hxx"
+#include "multi_gridgraph.hxx"
+#include "union_find.hxx"
+#include "algorithm.hxx"
+#include "array_vector.hxx"
+
+namespace vigra {
+
+/** \addtogroup MultiArrayMorphology
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                     ComponentTree                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Max-tree resp. min-tree of an N-dimensional array with region attributes.
+
+    The component tree represents the connected components of all threshold
+    sets of an array. In a max-tree (the default, <tt>Compare = std::greater&lt;T&gt;</tt>),
+    the nodes are the connected components of the upper threshold sets
+    <tt>{x | data[x] &gt;= t}</tt>, the leaves are the regional maxima, and the root
+    is the entire array. A min-tree (<tt>Compare = std::less&lt;T&gt;</tt>) is the
+    same for the lower threshold sets.
+
+    The tree is built with the union-find algorithm of Berger et al. ("Effective
+    Component Tree Computation with Application to Pattern Recognition in
+    Astronomical Imaging", ICIP 2007) on a \ref vigra::GridGraph with the given
+    neighborhood, using <tt>detail::UnionFindArray</tt>. The nodes are identified
+    by the scan-order indices of the array elements: every element points to its
+    parent, and each component is represented by one <i>canonical</i> element
+    whose parent has a different level (or which is the root). The
+    other elements of the component at the same level point to the canonical element.
+    The area (number of elements), the bounding box, and the contrast (the
+    difference between the level of the component and its most extreme value)
+    of all components are computed incrementally during construction. They are
+    valid for canonical elements.
+
+    Attribute filters are realized by <tt>filter()</tt>: it removes all components
+    for which a predicate is <tt>false</tt> by assigning the level of the closest
+    ancestor that is kept (the "direct" rule). For increasing attributes like area,
+    this is the attribute opening (resp. closing for a min-tree).
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_component_tree.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    // keep the components whose bounding box is at least 10 voxels high
+    struct TallComponents
+    {
+        bool operator()(ComponentTree<3, UInt8> const & tree, MultiArrayIndex node) const
+        {
+            return tree.boundingBoxEnd(node)[2] - tree.boundingBoxBegin(node)[2] >= 10;
+        }
+    };
+    ...
+    MultiArray<3, UInt8> volume(Shape3(width, height, depth)),
+                         res(volume.shape());
+    ...
+    ComponentTree<3, UInt8> maxTree(volume, IndirectNeighborhood);
+    maxTree.filter(res, TallComponents());
+    \endcode
+
+    \see multiAreaOpening(), multiReconstructionByDilation()
+*/
+template <unsigned int N, class T, class Compare = std::greater<T> >
+class ComponentTree
+{
+  public:
+        /** the array's value type
+        */
+    typedef T value_type;
+
+        /** the type of the contrast attribute
+        */
+    typedef typename NumericTraits<T>::Promote contrast_type;
+
+        /** the array's shape type
+        */
+    typedef typename MultiArrayShape<N>::type shape_type;
+
+        /** Build the component tree of \a data. The neighborhood defines the
+            connectivity of the components (<tt>DirectNeighborhood</tt> or
+            <tt>IndirectNeighborhood</tt>).
+        */
+    template <class S>
+    explicit ComponentTree(MultiArrayView<N, T, S> const & data,
+                           NeighborhoodType neighborhood = DirectNeighborhood,
+                           Compare const & compare = Compare())
+    : shape_(data.shape()),
+      compare_(compare),
+      levels_(data.begin(), data.end()),
+      parents_(levels_.size()),
+      order_(levels_.size()),
+      areas_(levels_.size(), 1),
+      bbBegin_(levels_.size()),
+      bbEnd_(levels_.size()),
+      extrema_(levels_)
+    {
+        build(neighborhood);
+    }
+
+        /** the shape of the underlying array
+        */
+    shape_type const & shape() const
+    {
+        return shape_;
+    }
+
+        /** the number of array elements (= the number of tree elements)
+        */
+    MultiArrayIndex size() const
+    {
+        return (MultiArrayIndex)levels_.size();
+    }
+
+        /** the scan-order index of the root (the entire array)
+        */
+    MultiArrayIndex root() const
+    {
+        return order_.back();
+    }
+
+        /** the parent of \a node. The root is its own parent.
+        */
+    MultiArrayIndex parent(MultiArrayIndex node) const
+    {
+        return parents_[node];
+    }
+
+        /** <tt>true</tt> if \a node represents its component
+        */
+    bool isCanonical(MultiArrayIndex node) const
+    {
+        return node == root() || levels_[parents_[node]] != levels_[node];
+    }
+
+        /** the canonical element of the component \a node belongs to
+            at the level of \a node
+        */
+    MultiArrayIndex canonical(MultiArrayIndex node) const
+    {
+        return isCanonical(node)
+                   ? node
+                   : parents_[node];
+    }
+
+        /** the level of \a node, i.e. the array value at this element
+        */
+    value_type level(MultiArrayIndex node) const
+    {
+        return levels_[node];
+    }
+
+        /** the number of elements in the component of canonical \a node
+        */
+    MultiArrayIndex area(MultiArrayIndex node) const
+    {
+        return areas_[node];
+    }
+
+        /** the first corner of the bounding box of the component of canonical \a node
+        */
+    shape_type const & boundingBoxBegin(MultiArrayIndex node) const
+    {
+        return bbBegin_[node];
+    }
+
+        /** the bounding box end (exclusive) of the component of canonical \a node
+        */
+    shape_type boundingBoxEnd(MultiArrayIndex node) const
+    {
+        return bbEnd_[node] + shape_type(1);
+    }
+
+        /** the absolute difference between the level of canonical \a node
+            and the most extreme value in its component
+        */
+    contrast_type contrast(MultiArrayIndex node) const
+    {
+        return levels_[node] < extrema_[node]
+                   ? contrast_type(extrema_[node]) - contrast_type(levels_[node])
+                   : contrast_type(levels_[node]) - contrast_type(extrema_[node]);
+    }
+
+        /** Apply an attribute filter and write the result to \a dest.
+
+            All components for which <tt>keep(*this, node)</tt> returns <tt>false</tt>
+            (where <tt>node</tt> is the canonical element of the component) are merged
+            into their closest kept ancestor. The root is always kept.
+        */
+    template <class T2, class S2, class Predicate>
+    void filter(MultiArrayView<N, T2, S2> dest, Predicate const & keep) const
+    {
+        vigra_precondition(dest.shape() == shape_,
+            "ComponentTree::filter(): shape mismatch between tree and output.");
+
+        ArrayVector<T> res(levels_.size());
+        // parents are visited before their children
+        for(MultiArrayIndex k = size()-1; k >= 0; --k)
+        {
+            MultiArrayIndex node = order_[k],
+                            parent = parents_[node];
+            if(node == root())
+                res[node] = levels_[node];
+            else if(isCanonical(node) && keep(*this, node))
+                res[node] = levels_[node];
+            else
+                res[node] = res[parent];
+        }
+        std::copy(res.begin(), res.end(), dest.begin());
+    }
+
+  private:
+    void build(NeighborhoodType neighborhood)
+    {
+        typedef GridGraph<N, undirected_tag> Graph;
+        typedef typename Graph::OutArcIt     neighbor_iterator;
+
+        MultiArrayIndex size = this->size();
+        if(size == 0)
+            return;
+
+        // process the elements from the extrema towards the root
+        indexSort(levels_.begin(), levels_.end(), order_.begin(), compare_);
+
+        Graph graph(shape_, neighborhood);
+        detail::UnionFindArray<MultiArrayIndex> sets(size);
+        ArrayVector<MultiArrayIndex> representatives(size);
+        ArrayVector<UInt8> processed(size);
+
+        for(MultiArrayIndex k = 0; k < size; ++k)
+        {
+            MultiArrayIndex current = order_[k];
+            shape_type node = graph.nodeFromId(current);
+            parents_[current] = current;
+            representatives[current] = current;
+            bbBegin_[current] = node;
+            bbEnd_[current] = node;
+            processed[current] = 1;
+
+            for(neighbor_iterator arc(graph, node); arc != lemon::INVALID; ++arc)
+            {
+                MultiArrayIndex neighbor = graph.id(graph.target(*arc));
+                if(!processed[neighbor])
+                    continue;
+                MultiArrayIndex currentSet = sets.find(current),
+                                neighborSet = sets.find(neighbor);
+                if(currentSet == neighborSet)
+                    continue;
+
+                // attach the subtree of the neighbor's component to 'current'
+                MultiArrayIndex child = representatives[neighborSet];
+                parents_[child] = current;
+                areas_[current] += areas_[child];
+                bbBegin_[current] = min(bbBegin_[current], bbBegin_[child]);
+                bbEnd_[current] = max(bbEnd_[current], bbEnd_[child]);
+                if(compare_(extrema_[child], extrema_[current]))
+                    extrema_[current] = extrema_[child];
+
+                representatives[sets.makeUnion(currentSet, neighborSet)] = current;
+            }
+        }
+
+        // canonicalize: let all elements point to the canonical element
+        // of their parent component
+        for(MultiArrayIndex k = size-1; k >= 0; --k)
+        {
+            MultiArrayIndex node = order_[k],
+                            parent = parents_[node];
+            if(levels_[parents_[parent]] == levels_[parent])
+                parents_[node] = parents_[parent];
+        }
+    }
+
+    shape_type shape_;
+    Compare compare_;
+    ArrayVector<T> levels_;
+    ArrayVector<MultiArrayIndex> parents_, order_, areas_;
+    ArrayVector<shape_type> bbBegin_, bbEnd_;
+    ArrayVector<T> extrema_;
+};
+
+namespace detail {
+
+struct ComponentTreeAreaPredicate
+{
+    MultiArrayIndex minArea_;
+
+    ComponentTreeAreaPredicate(MultiArrayIndex minArea)
+    : minArea_(minArea)
+    {}
+
+    template <class Tree>
+    bool operator()(Tree const & tree, MultiArrayIndex node) const
+    {
+        return tree.area(node) >= minArea_;
+    }
+};
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                   multiAreaOpening                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Area opening and closing of N-dimensional arrays.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiAreaOpening(MultiArrayView<N, T1, S1> const & src,
+                         MultiArrayView<N, T2, S2> dest,
+                         MultiArrayIndex minArea,
+                         NeighborhoodType neighborhood = DirectNeighborhood);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiAreaClosing(MultiArrayView<N, T1, S1> const & src,
+                         MultiArrayView<N, T2, S2> dest,
+                         MultiArrayIndex minArea,
+                         NeighborhoodType neighborhood = DirectNeighborhood);
+    }
+    \endcode
+
+    The area opening removes all bright connected components of the upper threshold
+    sets that have less than <tt>minArea</tt> elements, the area closing does the
+    same for the dark components of the lower threshold sets. In contrast to
+    an opening with a structuring element, the shape of the remaining components
+    is preserved exactly. The functions build a \ref vigra::ComponentTree (a max-tree
+    resp. min-tree), so that the cost is independent of the number of gray levels.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_component_tree.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, UInt8> image(Shape2(width, height)),
+                         res(image.shape());
+    ...
+    // remove bright spots with less than 50 pixels (8-connected)
+    multiAreaOpening(image, res, 50, IndirectNeighborhood);
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    src.shape() == dest.shape()
+    \endcode
+
+    \see ComponentTree
+*/
+doxygen_overloaded_function(template <...> void multiAreaOpening)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+multiAreaOpening(MultiArrayView<N, T1, S1> const & src,
+                 MultiArrayView<N, T2, S2> dest,
+                 MultiArrayIndex minArea,
+                 NeighborhoodType neighborhood = DirectNeighborhood)
+{
+    vigra_precondition(src.shape() == dest.shape(),
+        "multiAreaOpening(): shape mismatch between input and output.");
+    ComponentTree<N, T1> tree(src, neighborhood);
+    tree.filter(dest, detail::ComponentTreeAreaPredicate(minArea));
+}
+
+/********************************************************/
+/*                                                      */
+/*                   multiAreaClosing                   */
+/*                                                      */
+/********************************************************/
+
+    /** \brief Area closing of N-dimensional arrays.
+
+        See \ref multiAreaOpening() for the documentation.
+    */
+doxygen_overloaded_function(template <...> void multiAreaClosing)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+multiAreaClosing(MultiArrayView<N, T1, S1> const & src,
+                 MultiArrayView<N, T2, S2> dest,
+                 MultiArrayIndex minArea,
+                 NeighborhoodType neighborhood = DirectNeighborhood)
+{
+    vigra_precondition(src.shape() == dest.shape(),
+        "multiAreaClosing(): shape mismatch between input and output.");
+    ComponentTree<N, T1, std::less<T1> > tree(src, neighborhood);
+    tree.filter(dest, detail::ComponentTreeAreaPredicate(minArea));
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_COMPONENT_TREE_HXX
@@ -39,6 +39,7 @@
 #define VIGRA_MULTI_CONVOLUTION_H
 
 #include "separableconvolution.hxx"
+#include "recursiveconvolution.hxx"
 #include "array_vector.hxx"
 #include "multi_array.hxx"
 #include "accessor.hxx"
@@ -46,11 +47,16 @@
 #include "navigator.hxx"
 #include "metaprogramming.hxx"
 #include "multi_pointoperators.hxx"
+#include "threadpool.hxx"
 #include "multi_math.hxx"
 #include "functorexpression.hxx"
 #include "tinyvector.hxx"
 #include "algorithm.hxx"
 
+#ifdef HasFFTW3
+# include "multi_fft.hxx"
+#endif
+
 namespace vigra
 {
 
@@ -232,6 +238,20 @@ struct multiArrayScaleParam
     }
 
 
+/** \brief Algorithms for Gaussian convolution filters.
+
+    See \ref ConvolutionOptions::convolutionMethod().
+
+    <b>\#include</b> \<vigra/multi_convolution.hxx\><br/>
+    Namespace: vigra
+*/
+enum ConvolutionMethod
+{
+    CONVOLUTION_SPATIAL,  ///< separable convolution in the spatial domain
+    CONVOLUTION_FFT,      ///< multiplication in the Fourier domain (requires FFTW)
+    CONVOLUTION_AUTO      ///< use a cost model to select the faster of the two
+};
+
 /** \brief  Options class template for convolutions.
  
   <b>\#include</b> \<vigra/multi_convolution.hxx\><br/>
@@ -334,13 +354,21 @@ class ConvolutionOptions
     ParamVec outer_scale;
     double window_ratio;
     Shape from_point, to_point;
+    ParallelOptions parallel_lines;
+    bool use_recursive_filter;
+    ConvolutionMethod convolution_method;
+    bool float_arithmetic;
      
     ConvolutionOptions()
     : sigma_eff(0.0),
       sigma_d(0.0),
       step_size(1.0),
       outer_scale(0.0),
-      window_ratio(0.0)
+      window_ratio(0.0),
+      parallel_lines(ParallelOptions::Serial),
+      use_recursive_filter(false),
+      convolution_method(CONVOLUTION_SPATIAL),
+      float_arithmetic(false)
     {}
 
     typedef typename detail::WrapDoubleIteratorTriple<ParamIt, ParamIt, ParamIt>
@@ -486,6 +514,107 @@ class ConvolutionOptions
         to_point = to;
         return *this;
     }
+
+        /** Process the 1D lines of each axis pass in parallel.
+
+            The array is split into slabs perpendicular to the current
+            axis, and the slabs are distributed over <tt>numThreads</tt>
+            threads (see \ref ParallelOptions for the meaning of the special
+            values <tt>Auto</tt>, <tt>Nice</tt> and <tt>Serial</tt>). Each thread
+            uses its own line buffer. The results are identical to sequential
+            execution.
+            
+            Default: <tt>ParallelOptions::Serial</tt> (i.e. no parallelization)
+        */
+    ConvolutionOptions<dim> & parallelLines(int numThreads = ParallelOptions::Auto)
+    {
+        parallel_lines.numThreads(numThreads);
+        return *this;
+    }
+
+        /** Compute Gaussian filters by recursive (IIR) filters instead of
+            convolution kernels.
+
+            This option applies to \ref gaussianSmoothMultiArray(), \ref gaussianGradientMultiArray(),
+            \ref gaussianGradientMagnitude(), \ref laplacianOfGaussianMultiArray(),
+            \ref hessianOfGaussianMultiArray(), and \ref structureTensorMultiArray(). Smoothing is done by the 
+            third-order recursive filter of Young and van Vliet (see
+            \ref recursiveGaussianFilterLine()), and derivatives are computed by
+            central differences of the smoothed data. In contrast to convolution kernels,
+            whose size grows with the scale, the cost per pixel is then independent of sigma.
+            This is much faster for large scales (say, sigma > 3), but the result is only an
+            approximation of the exact Gaussian. The filter window size is ignored.
+            
+            Default: <tt>false</tt> (i.e. use convolution kernels)
+        */
+    ConvolutionOptions<dim> & recursiveFilter(bool use = true)
+    {
+        use_recursive_filter = use;
+        return *this;
+    }
+
+        /** Select how the convolution kernels of Gaussian filters are applied.
+
+            With <tt>CONVOLUTION_SPATIAL</tt>, the 1D kernels are applied to each axis
+            in turn. With <tt>CONVOLUTION_FFT</tt>, the array is convolved with the
+            equivalent N-dimensional kernel in the Fourier domain (see \ref convolveFFT()).
+            The cost of the former grows with the kernel size, whereas the cost
+            of the latter depends mainly on the array size, so that FFT convolution wins
+            for large scales. <tt>CONVOLUTION_AUTO</tt> estimates the cost
+            of both from operation counts and selects the cheaper one. This estimate
+            is a heuristic that has not been calibrated by timings, so explicitly
+            choose a method when performance matters. Both methods give the same result up to 
+            rounding errors (about 1e-12 for <tt>double</tt> and 1e-5 for <tt>float</tt>, 
+            relative to the data range), because the FFT input is padded by reflection, 
+            equivalent to <tt>BORDER_TREATMENT_REFLECT</tt>. When several derivatives of the 
+            same array are needed (e.g. in \ref gaussianGradientMultiArray() and 
+            \ref hessianOfGaussianMultiArray()), the FFT method computes them with a single 
+            plan and transforms the input only once. It then holds the padded ROI and one 
+            padded real array and one complex spectrum per result in memory at the same time.
+
+            Plans are not cached: each call creates new <tt>FFTW_ESTIMATE</tt> plans
+            and transforms the kernels again. When many arrays of the same shape are
+            filtered with the same kernels, use \ref FFTWConvolvePlan directly to
+            reuse the plan and the kernel spectra.
+
+            The FFT method runs in a single thread, because FFTW planning is not thread-safe.
+            Therefore, when \ref parallelLines() requests more than one thread, 
+            <tt>CONVOLUTION_AUTO</tt> selects spatial convolution, and 
+            <tt>CONVOLUTION_FFT</tt> raises a <tt>PreconditionViolation</tt>.
+
+            This option applies to the same functions as \ref recursiveFilter(), which takes
+            precedence. FFT convolution is only available when VIGRA is compiled with FFTW
+            support (i.e. when the macro <tt>HasFFTW3</tt> is defined), and only for
+            scalar <tt>float</tt> or <tt>double</tt> results. Otherwise,
+            <tt>CONVOLUTION_AUTO</tt> falls back to spatial convolution, and
+            <tt>CONVOLUTION_FFT</tt> raises a <tt>PreconditionViolation</tt>.
+
+            Default: <tt>CONVOLUTION_SPATIAL</tt>
+        */
+    ConvolutionOptions<dim> & convolutionMethod(ConvolutionMethod method)
+    {
+        convolution_method = method;
+        return *this;
+    }
+
+        /** Compute Gaussian filters in single precision when the destination is <tt>float</tt>.
+
+            By default, Gaussian smoothing uses <tt>Kernel1D<double></tt>, and 
+            \ref gaussianGradientMagnitude() and \ref gaussianDivergenceMultiArray()
+            derive their temporaries from the source type (i.e. <tt>double</tt> for
+            integer sources). When this option is set, kernels and temporaries follow
+            the destination instead, so that a <tt>float</tt> destination selects 
+            <tt>float</tt> arithmetic end to end (half the memory traffic and twice
+            the SIMD width). The results then differ from the default by 
+            single precision rounding errors.
+            
+            Default: <tt>false</tt> (i.e. keep the precision described above)
+        */
+    ConvolutionOptions<dim> & floatArithmetic(bool use = true)
+    {
+        float_arithmetic = use;
+        return *this;
+    }
 };
 
 namespace detail
@@ -497,60 +626,270 @@ namespace detail
 /*                                                      */
 /********************************************************/
 
-template <class SrcIterator, class SrcShape, class SrcAccessor,
-          class DestIterator, class DestAccessor, class KernelIterator>
-void
-internalSeparableConvolveMultiArrayTmp(
-                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
-                      DestIterator di, DestAccessor dest, KernelIterator kit)
+/********************************************************/
+/*                                                      */
+/*               convolveMultiArrayLines                */
+/*                                                      */
+/********************************************************/
+
+    // Convolve all lines along 'axis' in the region [sstart, sstop) of the
+    // source, writing the results at [dstart, ...) in the destination
+    // (shifted by 'doffset' along 'axis'). The region is split into slabs
+    // along another axis, which are processed by the given number of threads.
+    //
+    // When 'axis' is not the innermost dimension, the lines are strided in memory.
+    // They are then processed in panels of up to 256 adjacent lines:
+    // each position of the panel is read and written as a contiguous row
+    // along dimension 0, so that all memory accesses have unit stride.
+template <class TmpType, class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel>
+class ConvolveMultiArrayLinesTask
 {
-    enum { N = 1 + SrcIterator::level };
+  public:
+    typedef typename SrcIterator::multi_difference_type Shape;
+    typedef typename AccessorTraits<TmpType>::default_accessor TmpAccessor;
+    typedef MultiArrayNavigator<SrcIterator, Shape::static_size> SNavigator;
+    typedef MultiArrayNavigator<DestIterator, Shape::static_size> DNavigator;
+    typedef typename detail::ConvolveLineBuffer<TmpType,
+                          typename Kernel::value_type>::type LineBuffer;
+
+    ConvolveMultiArrayLinesTask(SrcIterator si, SrcAccessor src,
+                                Shape const & sstart, Shape const & sstop,
+                                DestIterator di, DestAccessor dest, Shape const & dstart,
+                                unsigned int axis, unsigned int split_axis, MultiArrayIndex slab_size,
+                                Kernel const & kernel, int lstart, int lstop, int doffset,
+                                ArrayVector<ArrayVector<TmpType> > & buffers)
+    : si_(si), src_(src), sstart_(sstart), sstop_(sstop),
+      di_(di), dest_(dest), dstart_(dstart),
+      axis_(axis), split_axis_(split_axis), slab_size_(slab_size),
+      kernel_(kernel), lstart_(lstart), lstop_(lstop), doffset_(doffset),
+      buffers_(buffers), line_buffers_(buffers.size())
+    {}
 
-    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
-    typedef typename AccessorTraits<TmpType>::default_accessor TmpAcessor;
+    void operator()(int threadId, MultiArrayIndex slab) const
+    {
+        Shape start(sstart_), stop(sstop_);
+        start[split_axis_] += slab*slab_size_;
+        stop[split_axis_] = std::min(start[split_axis_] + slab_size_, sstop_[split_axis_]);
 
-    // temporary array to hold the current line to enable in-place operation
-    ArrayVector<TmpType> tmp( shape[0] );
+        if(usePanels())
+            convolvePanels(threadId, start, stop);
+        else
+            convolveLines(threadId, start, stop);
+    }
 
-    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
-    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
-    
-    TmpAcessor acc;
+  private:
+    bool usePanels() const
+    {
+        BorderTreatmentMode border = kernel_.borderTreatment();
+        return axis_ != 0 && sstop_[0] - sstart_[0] > 1 &&
+               sstop_[axis_] - sstart_[axis_] > std::max(kernel_.right(), -kernel_.left()) &&
+               (border == BORDER_TREATMENT_WRAP || border == BORDER_TREATMENT_REFLECT ||
+                border == BORDER_TREATMENT_REPEAT || border == BORDER_TREATMENT_ZEROPAD);
+    }
 
+    void convolveLines(int threadId, Shape const & start, Shape const & stop) const
     {
-        // only operate on first dimension here
-        SNavigator snav( si, shape, 0 );
-        DNavigator dnav( di, shape, 0 );
-        
+        Shape dstart(dstart_ + start - sstart_), dstop(dstart + stop - start);
+        dstart[axis_] = dstart_[axis_];
+        dstop[axis_] = dstart[axis_] + 1;
+
+        SNavigator snav(si_, start, stop, axis_);
+        DNavigator dnav(di_, dstart, dstop, axis_);
+        ArrayVector<TmpType> & tmp = buffers_[threadId];
+        LineBuffer & scratch = line_buffers_[threadId];
+        TmpAccessor acc;
+
         for( ; snav.hasMore(); snav++, dnav++ )
         {
-             // first copy source to tmp for maximum cache efficiency
-             copyLine(snav.begin(), snav.end(), src, tmp.begin(), acc);
-
-             convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
-                          destIter( dnav.begin(), dest ),
-                          kernel1d( *kit ) );
+            // first copy source to tmp for maximum cache efficiency and
+            // because convolveLine() cannot work in-place
+            copyLine(snav.begin(), snav.end(), src_, tmp.begin(), acc);
+
+            detail::convolveLineWithBuffer(tmp.begin(), tmp.end(), acc,
+                                           dnav.begin() + doffset_, dest_,
+                                           kernel_.center(), kernel_.accessor(),
+                                           kernel_.left(), kernel_.right(), kernel_.borderTreatment(),
+                                           lstart_, lstop_, scratch);
         }
-        ++kit;
     }
 
-    // operate on further dimensions
-    for( int d = 1; d < N; ++d, ++kit )
+    void convolvePanels(int threadId, Shape const & start, Shape const & stop) const
     {
-        DNavigator dnav( di, shape, d );
-
-        tmp.resize( shape[d] );
-
-        for( ; dnav.hasMore(); dnav++ )
+        int w     = (int)(stop[axis_] - start[axis_]),
+            kleft = kernel_.left(), kright = kernel_.right(),
+            lstart = lstart_,
+            lstop  = lstop_ == 0 ? w : lstop_,
+            kw     = kright - kleft + 1,
+            outlen = lstop - lstart,
+            inlen  = outlen + kw - 1;
+
+        // Determine which source position of the line goes into each position
+        // of the padded line buffer by applying the border treatment to the
+        // positions 1...w. Thus, 'padded' holds the source position plus 1,
+        // and 0 for zero padding.
+        ArrayVector<int> positions(w), padded(inlen);
+        for(int k=0; k<w; ++k)
+            positions[k] = k + 1;
+        StandardValueAccessor<int> ia;
+        copyLineWithBorderTreatment(positions.begin(), positions.end(), ia,
+                                    padded.begin(), ia, lstart, lstop, kleft, kright,
+                                    kernel_.borderTreatment());
+
+        // use wide panels, but keep the buffer small enough to stay in cache
+        int panelWidth = std::max(16, std::min(256, (1 << 17) / inlen));
+
+        ArrayVector<TmpType> & tmp = buffers_[threadId];
+        if(tmp.size() < (std::size_t)((inlen + 1)*panelWidth))
+            tmp.resize((inlen + 1)*panelWidth);
+        TmpType * panel = tmp.begin(),
+                * sum   = tmp.begin() + inlen*panelWidth;
+
+        // iterate over the rows (along dimension 0) of the first position of all lines
+        Shape rows(stop - start);
+        rows[0] = 1;
+        rows[axis_] = 1;
+        MultiArrayIndex rowCount = prod(rows);
+
+        for(MultiArrayIndex r = 0; r < rowCount; ++r)
         {
-             // first copy source to tmp since convolveLine() cannot work in-place
-             copyLine(dnav.begin(), dnav.end(), dest, tmp.begin(), acc);
+            Shape row;
+            detail::ScanOrderToCoordinate<Shape::static_size>::exec(r, rows, row);
+            row += start;
 
-             convolveLine(srcIterRange(tmp.begin(), tmp.end(), acc),
-                          destIter( dnav.begin(), dest ),
-                          kernel1d( *kit ) );
+            for(MultiArrayIndex p0 = start[0]; p0 < stop[0]; p0 += panelWidth)
+            {
+                int pw = (int)std::min<MultiArrayIndex>(panelWidth, stop[0] - p0);
+                Shape s(row);
+                s[0] = p0;
+
+                // copy the panel into the buffer, applying the border treatment
+                for(int k = 0; k < inlen; ++k)
+                {
+                    TmpType * b = panel + k*panelWidth;
+                    if(padded[k] == 0)
+                    {
+                        for(int p = 0; p < pw; ++p)
+                            b[p] = NumericTraits<TmpType>::zero();
+                    }
+                    else
+                    {
+                        Shape pos(s);
+                        pos[axis_] += padded[k] - 1;
+                        typename SrcIterator::iterator l = (si_ + pos).iteratorForDimension(0);
+                        for(int p = 0; p < pw; ++p, ++l)
+                            b[p] = src_(l);
+                    }
+                }
+
+                Shape d(dstart_ + s - sstart_);
+                d[axis_] = dstart_[axis_] + doffset_;
+
+                // convolve all lines of the panel simultaneously (same summation
+                // order as convolveLine()) and write the results row by row
+                for(int x = 0; x < outlen; ++x, ++d[axis_])
+                {
+                    for(int p = 0; p < pw; ++p)
+                        sum[p] = NumericTraits<TmpType>::zero();
+                    for(int k = 0; k < kw; ++k)
+                    {
+                        typename Kernel::value_type c = kernel_[kright - k];
+                        TmpType const * b = panel + (x + k)*panelWidth;
+                        for(int p = 0; p < pw; ++p)
+                            sum[p] += c * b[p];
+                    }
+
+                    typename DestIterator::iterator l = (di_ + d).iteratorForDimension(0);
+                    for(int p = 0; p < pw; ++p, ++l)
+                        dest_.set(detail::RequiresExplicitCast<typename
+                                      DestAccessor::value_type>::cast(sum[p]), l);
+                }
+            }
         }
     }
+
+    SrcIterator si_;
+    SrcAccessor src_;
+    Shape sstart_, sstop_;
+    DestIterator di_;
+    DestAccessor dest_;
+    Shape dstart_;
+    unsigned int axis_, split_axis_;
+    MultiArrayIndex slab_size_;
+    Kernel const & kernel_;
+    int lstart_, lstop_, doffset_;
+    ArrayVector<ArrayVector<TmpType> > & buffers_;
+    mutable ArrayVector<LineBuffer> line_buffers_;
+};
+
+template <class TmpType, class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor, class Kernel>
+void
+convolveMultiArrayLines(SrcIterator si, SrcAccessor src,
+                        typename SrcIterator::multi_difference_type const & sstart,
+                        typename SrcIterator::multi_difference_type const & sstop,
+                        DestIterator di, DestAccessor dest,
+                        typename SrcIterator::multi_difference_type const & dstart,
+                        unsigned int axis, Kernel const & kernel,
+                        int lstart, int lstop, int doffset,
+                        ParallelOptions const & parallel)
+{
+    typedef typename SrcIterator::multi_difference_type Shape;
+    enum { N = Shape::static_size };
+
+    Shape shape(sstop - sstart);
+
+    // split along the largest axis perpendicular to the lines
+    unsigned int split_axis = axis == 0 ? N-1 : 0;
+    for(unsigned int k=0; k<N; ++k)
+        if(k != axis && shape[k] > shape[split_axis])
+            split_axis = k;
+
+    int threads = parallel.getActualNumThreads();
+    MultiArrayIndex slabs = 1;
+    if(threads > 1 && split_axis != axis)
+        slabs = std::min<MultiArrayIndex>(shape[split_axis], 4*threads);
+    MultiArrayIndex slab_size = (shape[split_axis] + slabs - 1) / slabs;
+    slabs = (shape[split_axis] + slab_size - 1) / slab_size;
+
+    ArrayVector<ArrayVector<TmpType> >
+        buffers(std::min<MultiArrayIndex>(threads, slabs), ArrayVector<TmpType>(shape[axis]));
+
+    ConvolveMultiArrayLinesTask<TmpType, SrcIterator, SrcAccessor, DestIterator, DestAccessor, Kernel>
+        task(si, src, sstart, sstop, di, dest, dstart, axis, split_axis, slab_size,
+             kernel, lstart, lstop, doffset, buffers);
+    parallel_foreach(ParallelOptions((int)buffers.size()), slabs, task);
+}
+
+/********************************************************/
+/*                                                      */
+/*        internalSeparableConvolveMultiArray           */
+/*                                                      */
+/********************************************************/
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelIterator>
+void
+internalSeparableConvolveMultiArrayTmp(
+                      SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                      DestIterator di, DestAccessor dest, KernelIterator kit,
+                      ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
+{
+    enum { N = 1 + SrcIterator::level };
+
+    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
+
+    // only operate on first dimension here
+    convolveMultiArrayLines<TmpType>(si, src, SrcShape(), shape, di, dest, SrcShape(),
+                                     0, *kit, 0, 0, 0, parallel);
+    ++kit;
+
+    // operate on further dimensions
+    for( int d = 1; d < N; ++d, ++kit )
+    {
+        convolveMultiArrayLines<TmpType>(di, dest, SrcShape(), shape, di, dest, SrcShape(),
+                                         d, *kit, 0, 0, 0, parallel);
+    }
 }
 
 /********************************************************/
@@ -565,13 +904,13 @@ void
 internalSeparableConvolveSubarray(
                       SrcIterator si, SrcShape const & shape, SrcAccessor src,
                       DestIterator di, DestAccessor dest, KernelIterator kit,
-                      SrcShape const & start, SrcShape const & stop)
+                      SrcShape const & start, SrcShape const & stop,
+                      ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     enum { N = 1 + SrcIterator::level };
 
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
     typedef MultiArray<N, TmpType> TmpArray;
-    typedef typename TmpArray::traverser TmpIterator;
     typedef typename AccessorTraits<TmpType>::default_accessor TmpAcessor;
     
     SrcShape sstart, sstop, axisorder, tmpshape;
@@ -595,52 +934,25 @@ internalSeparableConvolveSubarray(
     // temporary array to hold the current line to enable in-place operation
     MultiArray<N, TmpType> tmp(dstop);
 
-    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
-    typedef MultiArrayNavigator<TmpIterator, N> TNavigator;
-    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
-    
     TmpAcessor acc;
 
     {
         // only operate on first dimension here
-        SNavigator snav( si, sstart, sstop, axisorder[0]);
-        TNavigator tnav( tmp.traverser_begin(), dstart, dstop, axisorder[0]);
-        
-        ArrayVector<TmpType> tmpline(sstop[axisorder[0]] - sstart[axisorder[0]]);
-        
         int lstart = start[axisorder[0]] - sstart[axisorder[0]];
         int lstop  = lstart + (stop[axisorder[0]] - start[axisorder[0]]);
 
-        for( ; snav.hasMore(); snav++, tnav++ )
-        {
-            // first copy source to tmp for maximum cache efficiency
-            copyLine(snav.begin(), snav.end(), src, tmpline.begin(), acc);
-            
-            convolveLine(srcIterRange(tmpline.begin(), tmpline.end(), acc),
-                         destIter(tnav.begin(), acc),
-                         kernel1d( kit[axisorder[0]] ), lstart, lstop);
-        }
+        convolveMultiArrayLines<TmpType>(si, src, sstart, sstop, tmp.traverser_begin(), acc, dstart,
+                                         axisorder[0], kit[axisorder[0]], lstart, lstop, 0, parallel);
     }
     
     // operate on further dimensions
     for( int d = 1; d < N; ++d)
     {
-        TNavigator tnav( tmp.traverser_begin(), dstart, dstop, axisorder[d]);
-        
-        ArrayVector<TmpType> tmpline(dstop[axisorder[d]] - dstart[axisorder[d]]);
-        
         int lstart = start[axisorder[d]] - sstart[axisorder[d]];
         int lstop  = lstart + (stop[axisorder[d]] - start[axisorder[d]]);
 
-        for( ; tnav.hasMore(); tnav++ )
-        {
-            // first copy source to tmp because convolveLine() cannot work in-place
-            copyLine(tnav.begin(), tnav.end(), acc, tmpline.begin(), acc );
-
-            convolveLine(srcIterRange(tmpline.begin(), tmpline.end(), acc),
-                         destIter( tnav.begin() + lstart, acc ),
-                         kernel1d( kit[axisorder[d]] ), lstart, lstop);
-        }
+        convolveMultiArrayLines<TmpType>(tmp.traverser_begin(), acc, dstart, dstop, tmp.traverser_begin(), acc, dstart,
+                                         axisorder[d], kit[axisorder[d]], lstart, lstop, lstart, parallel);
         
         dstart[axisorder[d]] = lstart;
         dstop[axisorder[d]] = lstop;
@@ -658,6 +970,573 @@ scaleKernel(K & kernel, double a)
         kernel[i] = detail::RequiresExplicitCast<typename K::value_type>::cast(kernel[i] * a);
 }
 
+/********************************************************/
+/*                                                      */
+/*             recursiveGaussianMultiArray              */
+/*                                                      */
+/********************************************************/
+
+    // Apply the recursive Gaussian filter of Young and van Vliet to a panel of
+    // 'pw' lines of length 'w'. Element k of line p is stored at 'line[k*P + p]', so
+    // that the recursion over k runs on all lines simultaneously and the inner loop
+    // over the lines can be vectorized. Apart from the memory layout, the computation is
+    // identical to recursiveGaussianFilterLine(). Derivatives are computed by central
+    // differences of the smoothed lines (with reflective border treatment), as proposed in
+    //
+    //     L. van Vliet, I. Young, P. Verbeek: "Recursive Gaussian derivative filters",
+    //     Proc. 14th Intl. Conf. Pattern Recognition, pp. 509-514, 1998
+    //
+    // The result is multiplied by 'scale' and returned in 'line'. 'tmp' must have
+    // the same size as 'line'.
+template <class T>
+void
+recursiveGaussianPanel(T * line, T * tmp, int w, int P, int pw,
+                       double sigma, int order, double scale)
+{
+    RecursiveGaussianCoefficients c(sigma);
+    double b1 = c.b1, b2 = c.b2, b3 = c.b3, B = c.B;
+    int kernelw = std::min(w-4, (int)(4.0*sigma));
+    int x, p;
+
+    // initialise the filter for reflective boundary conditions
+    for(x = kernelw+1; x <= kernelw+3; ++x)
+        for(p = 0; p < pw; ++p)
+            tmp[x*P+p] = NumericTraits<T>::zero();
+    for(x = kernelw; x >= 0; --x)
+    {
+        T * t = tmp + x*P;
+        T const * l = line + x*P;
+        for(p = 0; p < pw; ++p)
+            t[p] = B*l[p] + (b1*t[p+P] + b2*t[p+2*P] + b3*t[p+3*P]);
+    }
+
+    // from left to right - causal - forward (in place)
+    for(p = 0; p < pw; ++p)
+    {
+        line[p]     = B*line[p]     + (b1*tmp[P+p]      + b2*tmp[2*P+p]  + b3*tmp[3*P+p]);
+        line[P+p]   = B*line[P+p]   + (b1*line[p]       + b2*tmp[P+p]    + b3*tmp[2*P+p]);
+        line[2*P+p] = B*line[2*P+p] + (b1*line[P+p]     + b2*line[p]     + b3*tmp[P+p]);
+    }
+    for(x = 3; x < w; ++x)
+    {
+        T * l = line + x*P;
+        for(p = 0; p < pw; ++p)
+            l[p] = B*l[p] + (b1*l[p-P] + b2*l[p-2*P] + b3*l[p-3*P]);
+    }
+
+    // from right to left - anticausal - backward (into tmp)
+    {
+        T const * l = line + (w-1)*P;
+        T * t = tmp + (w-1)*P;
+        for(p = 0; p < pw; ++p)
+        {
+            t[p]     = B*l[p]     + (b1*l[p-P]   + b2*l[p-2*P] + b3*l[p-3*P]);
+            t[p-P]   = B*l[p-P]   + (b1*t[p]     + b2*l[p-P]   + b3*l[p-2*P]);
+            t[p-2*P] = B*l[p-2*P] + (b1*t[p-P]   + b2*t[p]     + b3*l[p-P]);
+        }
+    }
+    for(x = w-4; x >= 0; --x)
+    {
+        T * t = tmp + x*P;
+        T const * l = line + x*P;
+        for(p = 0; p < pw; ++p)
+            t[p] = B*l[p] + (b1*t[p+P] + b2*t[p+2*P] + b3*t[p+3*P]);
+    }
+
+    // derivatives and output
+    if(order == 0)
+    {
+        for(x = 0; x < w; ++x)
+        {
+            T * l = line + x*P;
+            T const * t = tmp + x*P;
+            for(p = 0; p < pw; ++p)
+                l[p] = t[p] * scale;
+        }
+    }
+    else if(order == 1)
+    {
+        scale *= 0.5;
+        for(p = 0; p < pw; ++p)
+        {
+            line[p] = NumericTraits<T>::zero();
+            line[(w-1)*P+p] = NumericTraits<T>::zero();
+        }
+        for(x = 1; x < w-1; ++x)
+        {
+            T * l = line + x*P;
+            T const * t = tmp + x*P;
+            for(p = 0; p < pw; ++p)
+                l[p] = (t[p+P] - t[p-P]) * scale;
+        }
+    }
+    else
+    {
+        for(p = 0; p < pw; ++p)
+        {
+            line[p] = (tmp[P+p] - 2.0*tmp[p] + tmp[P+p]) * scale;
+            line[(w-1)*P+p] = (tmp[(w-2)*P+p] - 2.0*tmp[(w-1)*P+p] + 
+                              tmp[(w-2)*P+p]) * scale;
+        }
+        for(x = 1; x < w-1; ++x)
+        {
+            T * l = line + x*P;
+            T const * t = tmp + x*P;
+            for(p = 0; p < pw; ++p)
+                l[p] = (t[p+P] - 2.0*t[p] + t[p-P]) * scale;
+        }
+    }
+}
+
+    // Filter all lines along 'axis' of a (temporary) array in place. The lines
+    // are processed in panels of adjacent lines along another axis.
+template <unsigned int N, class T>
+class RecursiveGaussianLinesTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    RecursiveGaussianLinesTask(MultiArrayView<N, T> array, unsigned int axis,
+                               double sigma, int order, double scale,
+                               int panel_width, ArrayVector<ArrayVector<T> > & buffers)
+    : array_(array), axis_(axis), lane_axis_(axis == 0 ? N-1 : 0),
+      sigma_(sigma), order_(order), scale_(scale),
+      panel_width_(panel_width), buffers_(buffers)
+    {
+        outer_shape_ = array.shape();
+        outer_shape_[axis_] = 1;
+        outer_shape_[lane_axis_] = 1;
+        lanes_ = lane_axis_ == axis_ ? 1 : array.shape(lane_axis_);
+        panels_per_row_ = (lanes_ + panel_width_ - 1) / panel_width_;
+    }
+
+    MultiArrayIndex taskCount() const
+    {
+        return prod(outer_shape_) * panels_per_row_;
+    }
+
+    void operator()(int threadId, MultiArrayIndex task) const
+    {
+        int w  = (int)array_.shape(axis_),
+            P  = panel_width_;
+        MultiArrayIndex line_stride = array_.stride(axis_),
+                        lane_stride = lane_axis_ == axis_ ? 0 : array_.stride(lane_axis_);
+        T * line = buffers_[2*threadId].begin(),
+          * tmp  = buffers_[2*threadId+1].begin();
+
+        Shape s;
+        detail::ScanOrderToCoordinate<N>::exec(task / panels_per_row_, outer_shape_, s);
+        MultiArrayIndex lane0 = (task % panels_per_row_) * P;
+        if(lane_axis_ != axis_)
+            s[lane_axis_] = lane0;
+        int pw = (int)std::min<MultiArrayIndex>(P, lanes_ - lane0);
+        T * base = const_cast<T *>(&array_[s]);
+
+        for(int x = 0; x < w; ++x)
+        {
+            T const * a = base + x*line_stride;
+            for(int p = 0; p < pw; ++p)
+                line[x*P + p] = a[p*lane_stride];
+        }
+
+        recursiveGaussianPanel(line, tmp, w, P, pw, sigma_, order_, scale_);
+
+        for(int x = 0; x < w; ++x)
+        {
+            T * a = base + x*line_stride;
+            for(int p = 0; p < pw; ++p)
+                a[p*lane_stride] = line[x*P + p];
+        }
+    }
+
+  private:
+    MultiArrayView<N, T> array_;
+    unsigned int axis_, lane_axis_;
+    double sigma_;
+    int order_;
+    double scale_;
+    int panel_width_;
+    Shape outer_shape_;
+    MultiArrayIndex lanes_, panels_per_row_;
+    ArrayVector<ArrayVector<T> > & buffers_;
+};
+
+    // Distance from the ROI where the recursive Gaussian filter with the given
+    // derivative order is started (its effective support).
+inline MultiArrayIndex
+recursiveGaussianMargin(double sigma, int order)
+{
+    return (MultiArrayIndex)std::ceil(4.0*sigma) + order;
+}
+
+    // Recursive approximation of a separable Gaussian filter with derivative
+    // order 'order[k]' along axis k. The ROI [start, stop) is extended by a margin
+    // of 4*sigma (the effective support of the recursive filter), and the
+    // extended region is filtered in a temporary array.
+template <class TmpType, class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor>
+void
+recursiveGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                            DestIterator di, DestAccessor dest,
+                            TinyVector<double, SrcShape::static_size> const & sigma,
+                            TinyVector<double, SrcShape::static_size> const & scale,
+                            SrcShape const & order,
+                            SrcShape start, SrcShape stop,
+                            ParallelOptions const & parallel)
+{
+    enum { N = SrcShape::static_size };
+    typedef MultiArray<N, TmpType> TmpArray;
+
+    if(stop == SrcShape())
+    {
+        start = SrcShape();
+        stop  = shape;
+    }
+    else
+    {
+        detail::RelativeToAbsoluteCoordinate<N-1>::exec(shape, start);
+        detail::RelativeToAbsoluteCoordinate<N-1>::exec(shape, stop);
+        for(int k=0; k<N; ++k)
+            vigra_precondition(0 <= start[k] && start[k] < stop[k] && stop[k] <= shape[k],
+              "recursiveGaussianMultiArray(): invalid subarray shape.");
+    }
+
+    SrcShape sstart, sstop;
+    for(int k=0; k<N; ++k)
+    {
+        vigra_precondition(order[k] >= 0 && order[k] <= 2,
+            "recursiveGaussianMultiArray(): derivative order must be 0, 1, or 2.");
+        MultiArrayIndex margin = recursiveGaussianMargin(sigma[k], (int)order[k]);
+        sstart[k] = std::max<MultiArrayIndex>(0, start[k] - margin);
+        sstop[k]  = std::min<MultiArrayIndex>(shape[k], stop[k] + margin);
+        vigra_precondition(sstop[k] - sstart[k] >= 4,
+            "recursiveGaussianMultiArray(): array must have at least length 4 along every axis.");
+    }
+
+    TmpArray tmp(sstop - sstart);
+    ArrayVector<ArrayVector<TmpType> > buffers;
+    copyMultiArray(si + sstart, tmp.shape(), src,
+                   tmp.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor());
+
+    for(int k=0; k<N; ++k)
+    {
+        // panel buffers should fit into the cache
+        int w = (int)tmp.shape(k),
+            panel_width = std::max(4, std::min(64, (1 << 14) / w));
+        RecursiveGaussianLinesTask<N, TmpType> task(tmp, k, sigma[k], (int)order[k], scale[k],
+                                                    panel_width, buffers);
+        int threads = (int)std::min<MultiArrayIndex>(parallel.getActualNumThreads(), task.taskCount());
+        buffers.resize(2*threads);
+        for(int t=0; t<2*threads; ++t)
+            buffers[t].resize(w*panel_width);
+        parallel_foreach(ParallelOptions(threads), task.taskCount(), task);
+    }
+
+    copyMultiArray(srcMultiArrayRange(tmp.subarray(start - sstart, stop - sstart)), destIter(di, dest));
+}
+
+    // Create the 1D kernels of a Gaussian filter with derivative order 'order[k]'
+    // along axis k. Derivatives are scaled according to the step size.
+template <class KernelType, class Shape>
+void
+initGaussianDerivativeKernels(ConvolutionOptions<Shape::static_size> const & opt,
+                              Shape const & order,
+                              ArrayVector<Kernel1D<KernelType> > & kernels,
+                              const char * const function_name)
+{
+    static const int N = Shape::static_size;
+    typename ConvolutionOptions<N>::ScaleIterator params = opt.scaleParams();
+
+    kernels.resize(N);
+    for (int dim = 0; dim < N; ++dim, ++params)
+    {
+        double sigma = params.sigma_scaled(function_name);
+        if(order[dim] == 0)
+        {
+            kernels[dim].initGaussian(sigma, 1.0, opt.window_ratio);
+        }
+        else
+        {
+            kernels[dim].initGaussianDerivative(sigma, order[dim], 1.0, opt.window_ratio);
+            for(int k = 0; k < order[dim]; ++k)
+                scaleKernel(kernels[dim], 1.0 / params.step_size());
+        }
+    }
+}
+
+/********************************************************/
+/*                                                      */
+/*                 gaussianDerivativesFFT               */
+/*                                                      */
+/********************************************************/
+
+#ifdef HasFFTW3
+
+    // Decide if convolving an array of the given 'shape' with 'nkernels' kernels
+    // of size 'kernelShape' is faster in the Fourier domain. The cost unit is one
+    // multiply-add per pixel and tap of the 1D kernels in the spatial method.
+    // A real-valued FFT of size n is assumed to cost 'fftCost * n * log2(n)' units,
+    // and planning and allocation 'fftOverhead' units. These constants are rough
+    // operation-count estimates that have not been validated by timings, so
+    // CONVOLUTION_AUTO may pick the slower method near the break-even point.
+    // The Fourier method needs one forward transform of the input, and a forward
+    // transform of the kernel and an inverse transform for each result.
+    // Returns false if the reflective padding needed by the Fourier method
+    // does not fit into the array.
+template <class Shape>
+bool
+fftConvolutionIsFaster(Shape const & shape, Shape const & kernelShape, int nkernels)
+{
+    static const double fftCost = 1.3, fftOverhead = 4.0e5;
+
+    Shape padded = fftwBestPaddedShapeR2C(shape + kernelShape - Shape(1));
+    for(int k=0; k<Shape::static_size; ++k)
+        if((padded[k] - shape[k] + 1) / 2 > shape[k] - 1)
+            return false;
+
+    double size       = (double)prod(shape),
+           paddedSize = (double)prod(padded),
+           spatial    = nkernels * size * (double)sum(kernelShape),
+           fourier    = (1 + 2*nkernels) * fftCost * paddedSize * std::log(paddedSize) / std::log(2.0)
+                        + fftOverhead;
+    return fourier < spatial;
+}
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelType>
+bool
+gaussianDerivativesFFTImpl(SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                           DestIterator di, ArrayVector<DestAccessor> const & dests,
+                           ArrayVector<ArrayVector<Kernel1D<KernelType> > > const & kernels,
+                           ConvolutionOptions<SrcShape::static_size> const & opt,
+                           const char * const function_name, VigraTrueType)
+{
+    static const int N = SrcShape::static_size;
+    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote Real;
+    typedef MultiArray<N, Real> RealArray;
+
+    bool applicable = true;
+    SrcShape radius;
+    for(unsigned int i=0; i<kernels.size(); ++i)
+    {
+        for(int k=0; k<N; ++k)
+        {
+            applicable = applicable &&
+                         kernels[i][k].borderTreatment() == BORDER_TREATMENT_REFLECT;
+            radius[k] = std::max<MultiArrayIndex>(radius[k],
+                           std::max(-kernels[i][k].left(), kernels[i][k].right()));
+        }
+    }
+
+    SrcShape start = opt.from_point, stop = opt.to_point;
+    if(stop == SrcShape())
+    {
+        start = SrcShape();
+        stop  = shape;
+    }
+    else
+    {
+        detail::RelativeToAbsoluteCoordinate<N-1>::exec(shape, start);
+        detail::RelativeToAbsoluteCoordinate<N-1>::exec(shape, stop);
+    }
+    SrcShape sstart, sstop, kernelShape = 2*radius + SrcShape(1);
+    for(int k=0; k<N; ++k)
+    {
+        sstart[k] = std::max<MultiArrayIndex>(0, start[k] - radius[k]);
+        sstop[k]  = std::min<MultiArrayIndex>(shape[k], stop[k] + radius[k]);
+    }
+
+    if(applicable)
+        applicable = (opt.convolution_method == CONVOLUTION_FFT ||
+                      fftConvolutionIsFaster(sstop - sstart, kernelShape, (int)kernels.size()));
+    if(!applicable)
+    {
+        vigra_precondition(opt.convolution_method != CONVOLUTION_FFT,
+            std::string(function_name) + "(): FFT convolution requires reflective border "
+            "treatment and an array larger than the kernel radius.");
+        return false;
+    }
+
+    // the N-D kernel of result i is the outer product of the 1D kernels 'kernels[i]'
+    ArrayVector<RealArray> ndKernels(kernels.size(), RealArray(kernelShape));
+    for(unsigned int i=0; i<kernels.size(); ++i)
+    {
+        for(MultiArrayIndex j=0; j<prod(kernelShape); ++j)
+        {
+            SrcShape p;
+            detail::ScanOrderToCoordinate<N>::exec(j, kernelShape, p);
+            double v = 1.0;
+            for(int k=0; k<N; ++k)
+            {
+                MultiArrayIndex x = p[k] - radius[k];
+                v *= (x < kernels[i][k].left() || x > kernels[i][k].right())
+                         ? 0.0
+                         : (double)kernels[i][k][x];
+            }
+            ndKernels[i][p] = (Real)v;
+        }
+    }
+
+    RealArray in(sstop - sstart);
+    copyMultiArray(si + sstart, in.shape(), src, in.traverser_begin(), StandardValueAccessor<Real>());
+    ArrayVector<RealArray> outs(kernels.size(), RealArray(in.shape()));
+
+    // the plan is not cached, because FFTW planning is not thread-safe
+    // (see ConvolutionOptions::convolutionMethod())
+    FFTWConvolvePlan<N, Real> plan;
+    plan.initMany(in, ndKernels.begin(), ndKernels.end(), outs.begin());
+    plan.executeMany(in, ndKernels.begin(), ndKernels.end(), outs.begin());
+
+    for(unsigned int i=0; i<kernels.size(); ++i)
+        copyMultiArray(srcMultiArrayRange(outs[i].subarray(start - sstart, stop - sstart)),
+                       destIter(di, dests[i]));
+    return true;
+}
+
+#endif // HasFFTW3
+
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelType>
+bool
+gaussianDerivativesFFTImpl(SrcIterator, SrcShape const &, SrcAccessor,
+                           DestIterator, ArrayVector<DestAccessor> const &,
+                           ArrayVector<ArrayVector<Kernel1D<KernelType> > > const &,
+                           ConvolutionOptions<SrcShape::static_size> const & opt,
+                           const char * const function_name, VigraFalseType)
+{
+    vigra_precondition(opt.convolution_method != CONVOLUTION_FFT,
+        std::string(function_name) + "(): FFT convolution requires FFTW (macro HasFFTW3) "
+        "and scalar float or double results.");
+    return false;
+}
+
+    // Compute the results of several separable filters ('kernels[i]' holds the
+    // 1D kernels of result i) on the ROI given in 'opt' by means of FFT convolution.
+    // Result i is written to 'di' via accessor 'dests[i]'. Only the ROI plus a margin
+    // of the kernel radius is transformed. Returns false without doing anything if
+    // the spatial method shall be used (according to 'opt' and the cost model).
+template <class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor, class KernelType>
+inline bool
+gaussianDerivativesFFT(SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                       DestIterator di, ArrayVector<DestAccessor> const & dests,
+                       ArrayVector<ArrayVector<Kernel1D<KernelType> > > const & kernels,
+                       ConvolutionOptions<SrcShape::static_size> const & opt,
+                       const char * const function_name)
+{
+#ifdef HasFFTW3
+    typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote Real;
+    typedef typename IfBool<IsSameType<Real, float>::value || IsSameType<Real, double>::value,
+                            VigraTrueType, VigraFalseType>::type FFTApplicable;
+#else
+    typedef VigraFalseType FFTApplicable;
+#endif
+
+    if(opt.convolution_method == CONVOLUTION_SPATIAL)
+        return false;
+    if(opt.parallel_lines.getActualNumThreads() > 1)
+    {
+        vigra_precondition(opt.convolution_method != CONVOLUTION_FFT,
+            std::string(function_name) + "(): FFT convolution does not support parallelLines(), "
+            "use CONVOLUTION_SPATIAL for multi-threaded filtering.");
+        return false;
+    }
+    return gaussianDerivativesFFTImpl(si, shape, src, di, dests, kernels, opt,
+                                      function_name, FFTApplicable());
+}
+
+    // Kernel value type for ConvolutionOptions::floatArithmetic(): float if the
+    // destination computes in float, 'Default' otherwise.
+template <class DestValue, class Default>
+struct FloatArithmeticType
+{
+    typedef typename IfBool<IsSameType<typename NumericTraits<DestValue>::RealPromote, float>::value,
+                            float, Default>::type type;
+};
+
+    // Compute a Gaussian filter with derivative order 'order[k]' along axis k,
+    // using either recursive filters, FFT convolution, or spatial convolution
+    // (depending on 'opt'). Derivatives are scaled according to the step size.
+template <class KernelType, class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor>
+void
+gaussianDerivativeMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                             DestIterator di, DestAccessor dest,
+                             ConvolutionOptions<SrcShape::static_size> const & opt,
+                             SrcShape const & order,
+                             const char * const function_name)
+{
+    static const int N = SrcShape::static_size;
+
+    if(opt.use_recursive_filter)
+    {
+        typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
+
+        typename ConvolutionOptions<N>::ScaleIterator params = opt.scaleParams();
+        TinyVector<double, N> sigma, scale;
+        for (int dim = 0; dim < N; ++dim, ++params)
+        {
+            sigma[dim] = params.sigma_scaled(function_name);
+            scale[dim] = std::pow(params.step_size(), -(double)order[dim]);
+        }
+        recursiveGaussianMultiArray<TmpType>(si, shape, src, di, dest, sigma, scale, order,
+                                             opt.from_point, opt.to_point, opt.parallel_lines);
+        return;
+    }
+
+    ArrayVector<ArrayVector<Kernel1D<KernelType> > > kernels(1);
+    initGaussianDerivativeKernels(opt, order, kernels[0], function_name);
+    if(gaussianDerivativesFFT(si, shape, src, di, ArrayVector<DestAccessor>(1, dest),
+                              kernels, opt, function_name))
+        return;
+
+    typedef typename FloatArithmeticType<typename DestAccessor::value_type, KernelType>::type FloatKernelType;
+    if(opt.float_arithmetic && !IsSameType<FloatKernelType, KernelType>::value)
+    {
+        ArrayVector<Kernel1D<FloatKernelType> > float_kernels;
+        for(int k=0; k<N; ++k)
+            float_kernels.push_back(Kernel1D<FloatKernelType>(kernels[0][k]));
+        separableConvolveMultiArray(si, shape, src, di, dest, float_kernels.begin(),
+                                    opt.from_point, opt.to_point, opt.parallel_lines);
+        return;
+    }
+    separableConvolveMultiArray(si, shape, src, di, dest, kernels[0].begin(),
+                                opt.from_point, opt.to_point, opt.parallel_lines);
+}
+
+    // Compute several Gaussian derivatives of the same array and store result i
+    // in element i of the vector-valued destination. When the FFT method is used,
+    // the input is transformed only once for all results.
+template <class KernelType, class SrcIterator, class SrcShape, class SrcAccessor,
+          class DestIterator, class DestAccessor>
+void
+gaussianDerivativesMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor src,
+                              DestIterator di, DestAccessor dest,
+                              ConvolutionOptions<SrcShape::static_size> const & opt,
+                              ArrayVector<SrcShape> const & orders,
+                              const char * const function_name)
+{
+    typedef VectorElementAccessor<DestAccessor> ElementAccessor;
+
+    ArrayVector<ElementAccessor> dests;
+    for(unsigned int i=0; i<orders.size(); ++i)
+        dests.push_back(ElementAccessor(i, dest));
+
+    if(!opt.use_recursive_filter)
+    {
+        ArrayVector<ArrayVector<Kernel1D<KernelType> > > kernels(orders.size());
+        for(unsigned int i=0; i<orders.size(); ++i)
+            initGaussianDerivativeKernels(opt, orders[i], kernels[i], function_name);
+        if(gaussianDerivativesFFT(si, shape, src, di, dests, kernels, opt, function_name))
+            return;
+    }
+
+    ConvolutionOptions<SrcShape::static_size> spatial(opt);
+    spatial.convolutionMethod(CONVOLUTION_SPATIAL);
+    for(unsigned int i=0; i<orders.size(); ++i)
+        gaussianDerivativeMultiArray<KernelType>(si, shape, src, di, dests[i], spatial,
+                                                 orders[i], function_name);
+}
 
 } // namespace detail
 
@@ -695,6 +1574,12 @@ scaleKernel(K & kernel, double a)
     A full-sized internal array is only allocated if working on the destination
     array directly would cause round-off errors (i.e. if
     <tt>typeid(typename NumericTraits<T2>::RealPromote) != typeid(T2)</tt>).
+
+    All temporaries have type <tt>NumericTraits<T2>::RealPromote</tt>, and the
+    kernels are applied in the precision of their own value type. Pass 
+    <tt>Kernel1D<float></tt> kernels to compute in single precision when the 
+    destination is <tt>float</tt> (the Gaussian filters do this when 
+    \ref ConvolutionOptions::floatArithmetic() is set).
     
     If <tt>start</tt> and <tt>stop</tt> have non-default values, they must represent
     a valid subarray of the input array. The convolution is then restricted to that 
@@ -702,6 +1587,11 @@ scaleKernel(K & kernel, double a)
     subarray (i.e. <tt>dest.shape() == stop - start</tt>). Negative ROI boundaries are
     interpreted relative to the end of the respective dimension 
     (i.e. <tt>if(stop[k] < 0) stop[k] += source.shape(k);</tt>).
+    
+    If <tt>parallel</tt> requests more than one thread, the independent 1D lines of 
+    each axis pass are distributed over several threads (this option is available
+    in the iterator-based API; the Gaussian filters provide it via
+    \ref ConvolutionOptions::parallelLines()).
 
     <b> Declarations:</b>
 
@@ -754,7 +1644,8 @@ scaleKernel(K & kernel, double a)
                                     DestIterator diter, DestAccessor dest,
                                     KernelIterator kernels,
                                     SrcShape const & start = SrcShape(),
-                                    SrcShape const & stop = SrcShape());
+                                    SrcShape const & stop = SrcShape(),
+                                    ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
     }
     \endcode
     use argument objects in conjunction with \ref ArgumentObjectFactories :
@@ -778,7 +1669,8 @@ scaleKernel(K & kernel, double a)
                                     pair<DestIterator, DestAccessor> const & dest,
                                     KernelIterator kernels,
                                     SrcShape const & start = SrcShape(),
-                                    SrcShape const & stop = SrcShape());
+                                    SrcShape const & stop = SrcShape(),
+                                    ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
     }
     \endcode
     \deprecatedEnd
@@ -850,7 +1742,8 @@ separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor
                              DestIterator d, DestAccessor dest, 
                              KernelIterator kernels,
                              SrcShape start = SrcShape(),
-                             SrcShape stop = SrcShape())
+                             SrcShape stop = SrcShape(),
+                             ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
 
@@ -866,20 +1759,20 @@ separableConvolveMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor
             vigra_precondition(0 <= start[k] && start[k] < stop[k] && stop[k] <= shape[k],
               "separableConvolveMultiArray(): invalid subarray shape.");
 
-        detail::internalSeparableConvolveSubarray(s, shape, src, d, dest, kernels, start, stop);
+        detail::internalSeparableConvolveSubarray(s, shape, src, d, dest, kernels, start, stop, parallel);
     }
     else if(!IsSameType<TmpType, typename DestAccessor::value_type>::boolResult)
     {
         // need a temporary array to avoid rounding errors
         MultiArray<SrcShape::static_size, TmpType> tmpArray(shape);
         detail::internalSeparableConvolveMultiArrayTmp( s, shape, src,
-             tmpArray.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(), kernels );
+             tmpArray.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(), kernels, parallel );
         copyMultiArray(srcMultiArrayRange(tmpArray), destIter(d, dest));
     }
     else
     {
         // work directly on the destination array
-        detail::internalSeparableConvolveMultiArrayTmp( s, shape, src, d, dest, kernels );
+        detail::internalSeparableConvolveMultiArrayTmp( s, shape, src, d, dest, kernels, parallel );
     }
 }
 
@@ -904,10 +1797,11 @@ separableConvolveMultiArray(triple<SrcIterator, SrcShape, SrcAccessor> const & s
                             pair<DestIterator, DestAccessor> const & dest, 
                             KernelIterator kit,
                             SrcShape const & start = SrcShape(),
-                            SrcShape const & stop = SrcShape())
+                            SrcShape const & stop = SrcShape(),
+                            ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     separableConvolveMultiArray( source.first, source.second, source.third,
-                                 dest.first, dest.second, kit, start, stop );
+                                 dest.first, dest.second, kit, start, stop, parallel );
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1069,13 +1963,8 @@ convolveMultiArrayOneDimension(SrcIterator s, SrcShape const & shape, SrcAccesso
                         "than the data dimensionality" );
 
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
-    typedef typename AccessorTraits<TmpType>::default_const_accessor TmpAccessor;
-    ArrayVector<TmpType> tmp( shape[dim] );
 
-    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
-    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
-    
-    SrcShape sstart, sstop(shape), dstart, dstop(shape);
+    SrcShape sstart, sstop(shape);
     
     if(stop != SrcShape())
     {
@@ -1083,22 +1972,11 @@ convolveMultiArrayOneDimension(SrcIterator s, SrcShape const & shape, SrcAccesso
         sstop  = stop;
         sstart[dim] = 0;
         sstop[dim]  = shape[dim];
-        dstop = stop - start;
     }
 
-    SNavigator snav( s, sstart, sstop, dim );
-    DNavigator dnav( d, dstart, dstop, dim );
-
-    for( ; snav.hasMore(); snav++, dnav++ )
-    {
-        // first copy source to temp for maximum cache efficiency
-        copyLine(snav.begin(), snav.end(), src,
-                 tmp.begin(), typename AccessorTraits<TmpType>::default_accessor() );
-
-        convolveLine(srcIterRange( tmp.begin(), tmp.end(), TmpAccessor()),
-                     destIter( dnav.begin(), dest ),
-                     kernel1d( kernel), start[dim], stop[dim]);
-    }
+    detail::convolveMultiArrayLines<TmpType>(s, src, sstart, sstop, d, dest, SrcShape(),
+                                             dim, kernel, start[dim], stop[dim], 0,
+                                             ParallelOptions(ParallelOptions::Serial));
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1253,17 +2131,7 @@ gaussianSmoothMultiArray( SrcIterator s, SrcShape const & shape, SrcAccessor src
                    const ConvolutionOptions<SrcShape::static_size> & opt,
                    const char *const function_name = "gaussianSmoothMultiArray" )
 {
-    typedef typename DestAccessor::value_type DestType;
-
-    static const int N = SrcShape::static_size;
-
-    typename ConvolutionOptions<N>::ScaleIterator params = opt.scaleParams();
-    ArrayVector<Kernel1D<double> > kernels(N);
-
-    for (int dim = 0; dim < N; ++dim, ++params)
-        kernels[dim].initGaussian(params.sigma_scaled(function_name), 1.0, opt.window_ratio);
-
-    separableConvolveMultiArray(s, shape, src, d, dest, kernels.begin(), opt.from_point, opt.to_point);
+    detail::gaussianDerivativeMultiArray<double>(s, shape, src, d, dest, opt, SrcShape(), function_name);
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1365,7 +2233,7 @@ gaussianSmoothMultiArray(MultiArrayView<N, T1, S1> const & source,
                   class T2, class S2>
         void
         gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
-                                   MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                                   MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
                                    double sigma,
                                    ConvolutionOptions<N> opt = ConvolutionOptions<N>());
 
@@ -1374,7 +2242,7 @@ gaussianSmoothMultiArray(MultiArrayView<N, T1, S1> const & source,
                                   class T2, class S2>
         void
         gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
-                                   MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                                   MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
                                    ConvolutionOptions<N> opt);
     }
     \endcode
@@ -1451,7 +2319,6 @@ gaussianGradientMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor s
     typedef typename NumericTraits<DestValueType>::RealPromote KernelType;
    
     static const int N = SrcShape::static_size;
-    typedef typename ConvolutionOptions<N>::ScaleIterator ParamType;
 
     for(int k=0; k<N; ++k)
         if(shape[k] <=0)
@@ -1460,27 +2327,12 @@ gaussianGradientMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor s
     vigra_precondition(N == (int)dest.size(di),
         "gaussianGradientMultiArray(): Wrong number of channels in output array.");
 
-    ParamType params = opt.scaleParams();
-    ParamType params2(params);
-
-    ArrayVector<Kernel1D<KernelType> > plain_kernels(N);
-    for (int dim = 0; dim < N; ++dim, ++params)
-    {
-        double sigma = params.sigma_scaled(function_name);
-        plain_kernels[dim].initGaussian(sigma, 1.0, opt.window_ratio);
-    }
-
-    typedef VectorElementAccessor<DestAccessor> ElementAccessor;
-
     // compute gradient components
-    for (int dim = 0; dim < N; ++dim, ++params2)
-    {
-        ArrayVector<Kernel1D<KernelType> > kernels(plain_kernels);
-        kernels[dim].initGaussianDerivative(params2.sigma_scaled(), 1, 1.0, opt.window_ratio);
-        detail::scaleKernel(kernels[dim], 1.0 / params2.step_size());
-        separableConvolveMultiArray(si, shape, src, di, ElementAccessor(dim, dest), kernels.begin(), 
-                                    opt.from_point, opt.to_point);
-    }
+    ArrayVector<SrcShape> orders(N);
+    for (int dim = 0; dim < N; ++dim)
+        orders[dim][dim] = 1;
+    detail::gaussianDerivativesMultiArray<KernelType>(si, shape, src, di, dest, opt, orders,
+                                                      function_name);
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -1520,7 +2372,7 @@ template <unsigned int N, class T1, class S1,
                           class T2, class S2>
 inline void
 gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
-                           MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                           MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
                            ConvolutionOptions<N> opt )
 {
     if(opt.to_point != typename MultiArrayShape<N>::type())
@@ -1544,7 +2396,7 @@ template <unsigned int N, class T1, class S1,
           class T2, class S2>
 inline void
 gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
-                           MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                           MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
                            double sigma,
                            ConvolutionOptions<N> opt = ConvolutionOptions<N>())
 {
@@ -1559,6 +2411,25 @@ gaussianGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
 
 namespace detail {
 
+template <class TmpType, unsigned int N, class T1, class S1,
+                                         class T2, class S2>
+void 
+gaussianGradientMagnitudeSum(MultiArrayView<N+1, T1, S1> const & src,
+                             MultiArrayView<N, T2, S2> dest,
+                             ConvolutionOptions<N> const & opt)
+{
+    MultiArray<N, TinyVector<TmpType, N> > grad(dest.shape());
+    
+    using namespace multi_math;
+    
+    for(int k=0; k<src.shape(N); ++k)
+    {
+        gaussianGradientMultiArray(src.bindOuter(k), grad, opt);
+        
+        dest += squaredNorm(grad);
+    }
+}
+
 template <unsigned int N, class T1, class S1,
                           class T2, class S2>
 void 
@@ -1582,17 +2453,12 @@ gaussianGradientMagnitudeImpl(MultiArrayView<N+1, T1, S1> const & src,
               
     dest.init(0.0);
     
-    typedef typename NumericTraits<T1>::RealPromote TmpType;
-    MultiArray<N, TinyVector<TmpType, N> > grad(dest.shape());
+    if(opt.float_arithmetic)
+        gaussianGradientMagnitudeSum<typename NumericTraits<T2>::RealPromote>(src, dest, opt);
+    else
+        gaussianGradientMagnitudeSum<typename NumericTraits<T1>::RealPromote>(src, dest, opt);
     
     using namespace multi_math;
-    
-    for(int k=0; k<src.shape(N); ++k)
-    {
-        gaussianGradientMultiArray(src.bindOuter(k), grad, opt);
-        
-        dest += squaredNorm(grad);
-    }
     dest = sqrt(dest);
 }
 
@@ -1689,7 +2555,7 @@ gaussianGradientMagnitude(MultiArrayView<N+1, Multiband<T1>, S1> const & src,
                                   class T2, class S2>
         void
         symmetricGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
-                                    MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                                    MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
                                     ConvolutionOptions<N> opt = ConvolutionOptions<N>());
     }
     \endcode
@@ -1804,7 +2670,7 @@ template <unsigned int N, class T1, class S1,
                           class T2, class S2>
 inline void
 symmetricGradientMultiArray(MultiArrayView<N, T1, S1> const & source,
-                            MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                            MultiArrayView<N, TinyVector<T2, int(N)>, S2> dest,
                             ConvolutionOptions<N> opt = ConvolutionOptions<N>())
 {
     if(opt.to_point != typename MultiArrayShape<N>::type())
@@ -1938,17 +2804,6 @@ laplacianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccesso
     typedef typename AccessorTraits<KernelType>::default_accessor DerivativeAccessor;
 
     static const int N = SrcShape::static_size;
-    typedef typename ConvolutionOptions<N>::ScaleIterator ParamType;
-    
-    ParamType params = opt.scaleParams();
-    ParamType params2(params);
-
-    ArrayVector<Kernel1D<KernelType> > plain_kernels(N);
-    for (int dim = 0; dim < N; ++dim, ++params)
-    {
-        double sigma = params.sigma_scaled("laplacianOfGaussianMultiArray");
-        plain_kernels[dim].initGaussian(sigma, 1.0, opt.window_ratio);
-    }
     
     SrcShape dshape(shape);
     if(opt.to_point != SrcShape())
@@ -1957,22 +2812,21 @@ laplacianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccesso
     MultiArray<N, KernelType> derivative(dshape);
 
     // compute 2nd derivatives and sum them up
-    for (int dim = 0; dim < N; ++dim, ++params2)
+    for (int dim = 0; dim < N; ++dim)
     {
-        ArrayVector<Kernel1D<KernelType> > kernels(plain_kernels);
-        kernels[dim].initGaussianDerivative(params2.sigma_scaled(), 2, 1.0, opt.window_ratio);
-        detail::scaleKernel(kernels[dim], 1.0 / sq(params2.step_size()));
+        SrcShape order;
+        order[dim] = 2;
 
         if (dim == 0)
         {
-            separableConvolveMultiArray( si, shape, src, 
-                                         di, dest, kernels.begin(), opt.from_point, opt.to_point);
+            detail::gaussianDerivativeMultiArray<KernelType>(si, shape, src, di, dest, opt, order,
+                                                             "laplacianOfGaussianMultiArray");
         }
         else
         {
-            separableConvolveMultiArray( si, shape, src, 
-                                         derivative.traverser_begin(), DerivativeAccessor(), 
-                                         kernels.begin(), opt.from_point, opt.to_point);
+            detail::gaussianDerivativeMultiArray<KernelType>(si, shape, src,
+                                                             derivative.traverser_begin(), DerivativeAccessor(),
+                                                             opt, order, "laplacianOfGaussianMultiArray");
             combineTwoMultiArrays(di, dshape, dest, derivative.traverser_begin(), DerivativeAccessor(), 
                                   di, dest, Arg1() + Arg2() );
         }
@@ -2053,6 +2907,46 @@ laplacianOfGaussianMultiArray(MultiArrayView<N, T1, S1> const & source,
 /*                                                      */
 /********************************************************/
 
+namespace detail {
+
+template <class TmpType, class KernelValue, class Iterator, 
+          unsigned int N, class T, class S>
+void 
+gaussianDivergenceMultiArrayImpl(Iterator vectorField,
+                                 MultiArrayView<N, T, S> divergence,
+                                 ConvolutionOptions<N> const & opt)
+{
+    typedef Kernel1D<KernelValue> Kernel;
+    
+    typename ConvolutionOptions<N>::ScaleIterator params = opt.scaleParams();
+    ArrayVector<double> sigmas(N);
+    ArrayVector<Kernel> kernels(N);
+    for(unsigned int k = 0; k < N; ++k, ++params)
+    {
+        sigmas[k] = params.sigma_scaled("gaussianDivergenceMultiArray");
+        kernels[k].initGaussian(sigmas[k], 1.0, opt.window_ratio);
+    }
+    
+    MultiArray<N, TmpType> tmpDeriv(divergence.shape());
+    
+    for(unsigned int k=0; k < N; ++k, ++vectorField)
+    {
+        kernels[k].initGaussianDerivative(sigmas[k], 1, 1.0, opt.window_ratio);
+        if(k == 0)
+        {
+            separableConvolveMultiArray(*vectorField, divergence, kernels.begin(), opt.from_point, opt.to_point);
+        }
+        else
+        {
+            separableConvolveMultiArray(*vectorField, tmpDeriv, kernels.begin(), opt.from_point, opt.to_point);
+            divergence += tmpDeriv;
+        }
+        kernels[k].initGaussian(sigmas[k], 1.0, opt.window_ratio);
+    }
+}
+
+} // namespace detail
+
 /** \brief Calculate the divergence of a vector field using Gaussian derivative filters.
 
     This function computes the divergence of the given N-dimensional vector field
@@ -2092,14 +2986,14 @@ laplacianOfGaussianMultiArray(MultiArrayView<N, T1, S1> const & source,
         template <unsigned int N, class T1, class S1,
                                   class T2, class S2>
         void 
-        gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, N>, S1> const & vectorField,
+        gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, int(N)>, S1> const & vectorField,
                                      MultiArrayView<N, T2, S2> divergence,
                                      ConvolutionOptions<N> const & opt);
                                      
         template <unsigned int N, class T1, class S1,
                                   class T2, class S2>
         void 
-        gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, N>, S1> const & vectorField,
+        gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, int(N)>, S1> const & vectorField,
                                      MultiArrayView<N, T2, S2> divergence,
                                      double sigma,
                                      ConvolutionOptions<N> opt = ConvolutionOptions<N>());
@@ -2142,41 +3036,19 @@ gaussianDivergenceMultiArray(Iterator vectorField, Iterator vectorFieldEnd,
                              MultiArrayView<N, T, S> divergence,
                              ConvolutionOptions<N> opt)
 {
-    typedef typename MultiArrayShape<N>::type                    Shape;
     typedef typename std::iterator_traits<Iterator>::value_type  ArrayType;
     typedef typename ArrayType::value_type                       SrcType;
     typedef typename NumericTraits<SrcType>::RealPromote         TmpType;
-    typedef Kernel1D<double>                                     Kernel;
+    typedef typename NumericTraits<T>::RealPromote               DestTmpType;
     
     vigra_precondition(std::distance(vectorField, vectorFieldEnd) == N,
         "gaussianDivergenceMultiArray(): wrong number of input arrays.");
     // more checks are performed in separableConvolveMultiArray()
     
-    typename ConvolutionOptions<N>::ScaleIterator params = opt.scaleParams();
-    ArrayVector<double> sigmas(N);
-    ArrayVector<Kernel> kernels(N);
-    for(unsigned int k = 0; k < N; ++k, ++params)
-    {
-        sigmas[k] = params.sigma_scaled("gaussianDivergenceMultiArray");
-        kernels[k].initGaussian(sigmas[k], 1.0, opt.window_ratio);
-    }
-    
-    MultiArray<N, TmpType> tmpDeriv(divergence.shape());
-    
-    for(unsigned int k=0; k < N; ++k, ++vectorField)
-    {
-        kernels[k].initGaussianDerivative(sigmas[k], 1, 1.0, opt.window_ratio);
-        if(k == 0)
-        {
-            separableConvolveMultiArray(*vectorField, divergence, kernels.begin(), opt.from_point, opt.to_point);
-        }
-        else
-        {
-            separableConvolveMultiArray(*vectorField, tmpDeriv, kernels.begin(), opt.from_point, opt.to_point);
-            divergence += tmpDeriv;
-        }
-        kernels[k].initGaussian(sigmas[k], 1.0, opt.window_ratio);
-    }
+    if(opt.float_arithmetic)
+        detail::gaussianDivergenceMultiArrayImpl<DestTmpType, DestTmpType>(vectorField, divergence, opt);
+    else
+        detail::gaussianDivergenceMultiArrayImpl<TmpType, double>(vectorField, divergence, opt);
 }
 
 template <class Iterator, 
@@ -2193,7 +3065,7 @@ gaussianDivergenceMultiArray(Iterator vectorField, Iterator vectorFieldEnd,
 template <unsigned int N, class T1, class S1,
                           class T2, class S2>
 inline void 
-gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, N>, S1> const & vectorField,
+gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, int(N)>, S1> const & vectorField,
                              MultiArrayView<N, T2, S2> divergence,
                              ConvolutionOptions<N> const & opt)
 {
@@ -2207,7 +3079,7 @@ gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, N>, S1> const & ve
 template <unsigned int N, class T1, class S1,
                           class T2, class S2>
 inline void 
-gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, N>, S1> const & vectorField,
+gaussianDivergenceMultiArray(MultiArrayView<N, TinyVector<T1, int(N)>, S1> const & vectorField,
                              MultiArrayView<N, T2, S2> divergence,
                              double sigma,
                              ConvolutionOptions<N> opt = ConvolutionOptions<N>())
@@ -2330,7 +3202,6 @@ hessianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor
 
     static const int N = SrcShape::static_size;
     static const int M = N*(N+1)/2;
-    typedef typename ConvolutionOptions<N>::ScaleIterator ParamType;
     
     for(int k=0; k<N; ++k)
         if(shape[k] <=0)
@@ -2339,41 +3210,20 @@ hessianOfGaussianMultiArray(SrcIterator si, SrcShape const & shape, SrcAccessor
     vigra_precondition(M == (int)dest.size(di),
         "hessianOfGaussianMultiArray(): Wrong number of channels in output array.");
 
-    ParamType params_init = opt.scaleParams();
-
-    ArrayVector<Kernel1D<KernelType> > plain_kernels(N);
-    ParamType params(params_init);
-    for (int dim = 0; dim < N; ++dim, ++params)
-    {
-        double sigma = params.sigma_scaled("hessianOfGaussianMultiArray");
-        plain_kernels[dim].initGaussian(sigma, 1.0, opt.window_ratio);
-    }
-
-    typedef VectorElementAccessor<DestAccessor> ElementAccessor;
-
     // compute elements of the Hessian matrix
-    ParamType params_i(params_init);
-    for (int b=0, i=0; i<N; ++i, ++params_i)
+    ArrayVector<SrcShape> orders;
+    for (int i=0; i<N; ++i)
     {
-        ParamType params_j(params_i);
-        for (int j=i; j<N; ++j, ++b, ++params_j)
+        for (int j=i; j<N; ++j)
         {
-            ArrayVector<Kernel1D<KernelType> > kernels(plain_kernels);
-            if(i == j)
-            {
-                kernels[i].initGaussianDerivative(params_i.sigma_scaled(), 2, 1.0, opt.window_ratio);
-            }
-            else
-            {
-                kernels[i].initGaussianDerivative(params_i.sigma_scaled(), 1, 1.0, opt.window_ratio);
-                kernels[j].initGaussianDerivative(params_j.sigma_scaled(), 1, 1.0, opt.window_ratio);
-            }
-            detail::scaleKernel(kernels[i], 1 / params_i.step_size());
-            detail::scaleKernel(kernels[j], 1 / params_j.step_size());
-            separableConvolveMultiArray(si, shape, src, di, ElementAccessor(b, dest),
-                                        kernels.begin(), opt.from_point, opt.to_point);
+            SrcShape order;
+            ++order[i];
+            ++order[j];
+            orders.push_back(order);
         }
     }
+    detail::gaussianDerivativesMultiArray<KernelType>(si, shape, src, di, dest, opt, orders,
+                                                      "hessianOfGaussianMultiArray");
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
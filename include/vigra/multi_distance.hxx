@@ -39,6 +39,8 @@
 
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <cstdlib>
 #include "array_vector.hxx"
 #include "multi_array.hxx"
 #include "accessor.hxx"
@@ -47,6 +49,8 @@
 #include "metaprogramming.hxx"
 #include "multi_pointoperators.hxx"
 #include "functorexpression.hxx"
+#include "static_assert.hxx"
+#include "threadpool.hxx"
 
 namespace vigra
 {
@@ -73,13 +77,16 @@ struct DistParabolaStackEntry
 /*                                                      */
 /********************************************************/
 
-template <class SrcIterator, class SrcAccessor,
-          class DestIterator, class DestAccessor >
-void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
-                  DestIterator id, DestAccessor da, double sigma )
+    // Compute the lower envelope of the parabolas centered at the line's
+    // elements. On return, '_stack' holds the parabolas of the envelope
+    // in the order of their (consecutive) areas of influence.
+template <class SrcIterator, class SrcAccessor>
+void distParabolaEnvelope(SrcIterator is, SrcIterator iend, SrcAccessor sa, double sigma,
+                          std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > & _stack)
 {
     // We assume that the data in the input is distance squared and treat it as such
     double w = iend - is;
+    _stack.clear();
     if(w <= 0)
         return;
         
@@ -88,7 +95,6 @@ void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
     
     typedef typename SrcAccessor::value_type SrcType;
     typedef DistParabolaStackEntry<SrcType> Influence;
-    std::vector<Influence> _stack;
     _stack.push_back(Influence(sa(is), 0.0, 0.0, w));
     
     ++is;
@@ -119,12 +125,25 @@ void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
         ++is;
         ++current;
     }
+}
+
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor >
+void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                  DestIterator id, DestAccessor da, double sigma,
+                  std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > & _stack)
+{
+    typedef DistParabolaStackEntry<typename SrcAccessor::value_type> Influence;
+
+    double w = iend - is;
+    distParabolaEnvelope(is, iend, sa, sigma, _stack);
 
     // Now we have the stack indicating which rows are influenced by (and therefore
     // closest to) which row. We can go through the stack and calculate the
     // distance squared for each element of the column.
+    double sigma2 = sigma * sigma;
     typename std::vector<Influence>::iterator it = _stack.begin();
-    for(current = 0.0; current < w; ++current, ++id)
+    for(double current = 0.0; current < w; ++current, ++id)
     {
         while( current >= it->right) 
             ++it; 
@@ -132,6 +151,75 @@ void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
     }
 }
 
+    // Like distParabola(), but additionally write the position of the 
+    // nearest parabola center (the argmin) relative to each element 
+    // to 'ii'.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor, class IndexIterator>
+void distParabolaArgMin(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                        DestIterator id, DestAccessor da, IndexIterator ii, double sigma,
+                        std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > & _stack)
+{
+    typedef DistParabolaStackEntry<typename SrcAccessor::value_type> Influence;
+
+    double w = iend - is;
+    distParabolaEnvelope(is, iend, sa, sigma, _stack);
+
+    double sigma2 = sigma * sigma;
+    typename std::vector<Influence>::iterator it = _stack.begin();
+    for(double current = 0.0; current < w; ++current, ++id, ++ii)
+    {
+        while( current >= it->right) 
+            ++it; 
+        da.set(sigma2 * sq(current - it->center) + it->prevVal, id);
+        *ii = (MultiArrayIndex)(it->center - current);
+    }
+}
+
+    // Like distParabola(), but the parabola centered at element y is offset by
+    // half an element towards each neighbor, i.e. element x receives
+    // min_y(src[y] + sigma^2 * max(0, |x-y| - 1/2)^2). This is the squared distance
+    // to the nearest cell (of width 1) rather than to the nearest center. It is
+    // computed as min(src[x], envelope(x - 1/2), envelope(x + 1/2)), because the
+    // envelope overestimates the terms it gets wrong at one of the two positions.
+    // 'id' may be equal to 'is'.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor >
+void distParabolaHalfCell(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                          DestIterator id, DestAccessor da, double sigma,
+                          std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > & _stack)
+{
+    typedef DistParabolaStackEntry<typename SrcAccessor::value_type> Influence;
+
+    double w = iend - is;
+    distParabolaEnvelope(is, iend, sa, sigma, _stack);
+
+    double sigma2 = sigma * sigma;
+    typename std::vector<Influence>::iterator left = _stack.begin(), 
+                                              right = _stack.begin();
+    for(double current = 0.0; current < w; ++current, ++is, ++id)
+    {
+        double l = current - 0.5, 
+               r = current + 0.5;
+        while( l >= left->right) 
+            ++left; 
+        while( r >= right->right) 
+            ++right; 
+        double v = std::min<double>(sigma2 * sq(l - left->center) + left->prevVal,
+                                    sigma2 * sq(r - right->center) + right->prevVal);
+        da.set(std::min<double>(sa(is), v), id);
+    }
+}
+
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor >
+inline void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                         DestIterator id, DestAccessor da, double sigma )
+{
+    std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > _stack;
+    distParabola(is, iend, sa, id, da, sigma, _stack);
+}
+
 template <class SrcIterator, class SrcAccessor,
           class DestIterator, class DestAccessor>
 inline void distParabola(triple<SrcIterator, SrcIterator, SrcAccessor> src,
@@ -141,6 +229,115 @@ inline void distParabola(triple<SrcIterator, SrcIterator, SrcAccessor> src,
                  dest.first, dest.second, sigma);
 }
 
+/********************************************************/
+/*                                                      */
+/*                  distParabolaLines                   */
+/*                                                      */
+/********************************************************/
+
+    // Apply distParabola() to all lines along 'axis'. The array is split into
+    // slabs along another axis, which are processed by the given number of
+    // threads. Each thread owns its line buffer and parabola stack.
+template <class TmpType, class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor>
+class DistParabolaLinesTask
+{
+  public:
+    typedef typename SrcIterator::multi_difference_type Shape;
+    typedef MultiArrayNavigator<SrcIterator, Shape::static_size> SNavigator;
+    typedef MultiArrayNavigator<DestIterator, Shape::static_size> DNavigator;
+    typedef std::vector<DistParabolaStackEntry<TmpType> > Stack;
+
+    DistParabolaLinesTask(SrcIterator si, SrcAccessor src,
+                          DestIterator di, DestAccessor dest, Shape const & shape,
+                          unsigned int axis, unsigned int split_axis, MultiArrayIndex slab_size,
+                          double sigma, bool invert,
+                          ArrayVector<ArrayVector<TmpType> > & buffers,
+                          ArrayVector<Stack> & stacks)
+    : si_(si), src_(src), di_(di), dest_(dest), shape_(shape),
+      axis_(axis), split_axis_(split_axis), slab_size_(slab_size),
+      sigma_(sigma), invert_(invert),
+      buffers_(buffers), stacks_(stacks)
+    {}
+
+    void operator()(int threadId, MultiArrayIndex slab) const
+    {
+        Shape start, stop(shape_);
+        start[split_axis_] = slab*slab_size_;
+        stop[split_axis_] = std::min(start[split_axis_] + slab_size_, shape_[split_axis_]);
+
+        SNavigator snav(si_, start, stop, axis_);
+        DNavigator dnav(di_, start, stop, axis_);
+        ArrayVector<TmpType> & tmp = buffers_[threadId];
+
+        using namespace vigra::functor;
+
+        for( ; snav.hasMore(); snav++, dnav++ )
+        {
+            // first copy source to temp for maximum cache efficiency
+            // Invert the values if necessary. Only needed for grayscale morphology
+            if(invert_)
+                transformLine( snav.begin(), snav.end(), src_, tmp.begin(),
+                               typename AccessorTraits<TmpType>::default_accessor(), 
+                               Param(NumericTraits<TmpType>::zero())-Arg1());
+            else
+                copyLine( snav.begin(), snav.end(), src_, tmp.begin(),
+                          typename AccessorTraits<TmpType>::default_accessor() );
+
+            detail::distParabola( tmp.begin(), tmp.end(),
+                                  typename AccessorTraits<TmpType>::default_const_accessor(),
+                                  dnav.begin(), dest_, sigma_, stacks_[threadId] );
+        }
+    }
+
+  private:
+    SrcIterator si_;
+    SrcAccessor src_;
+    DestIterator di_;
+    DestAccessor dest_;
+    Shape shape_;
+    unsigned int axis_, split_axis_;
+    MultiArrayIndex slab_size_;
+    double sigma_;
+    bool invert_;
+    ArrayVector<ArrayVector<TmpType> > & buffers_;
+    ArrayVector<Stack> & stacks_;
+};
+
+template <class TmpType, class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor>
+void
+distParabolaLines(SrcIterator si, SrcAccessor src,
+                  DestIterator di, DestAccessor dest,
+                  typename SrcIterator::multi_difference_type const & shape,
+                  unsigned int axis, double sigma, bool invert,
+                  ParallelOptions const & parallel)
+{
+    enum { N = SrcIterator::multi_difference_type::static_size };
+
+    // split along the largest axis perpendicular to the lines
+    unsigned int split_axis = axis == 0 ? N-1 : 0;
+    for(unsigned int k=0; k<N; ++k)
+        if(k != axis && shape[k] > shape[split_axis])
+            split_axis = k;
+
+    int threads = parallel.getActualNumThreads();
+    MultiArrayIndex slabs = 1;
+    if(threads > 1 && split_axis != axis)
+        slabs = std::min<MultiArrayIndex>(shape[split_axis], 4*threads);
+    MultiArrayIndex slab_size = (shape[split_axis] + slabs - 1) / slabs;
+    slabs = (shape[split_axis] + slab_size - 1) / slab_size;
+
+    typedef DistParabolaLinesTask<TmpType, SrcIterator, SrcAccessor, DestIterator, DestAccessor> Task;
+    int tasks = (int)std::min<MultiArrayIndex>(threads, slabs);
+    ArrayVector<ArrayVector<TmpType> > buffers(tasks, ArrayVector<TmpType>(shape[axis]));
+    ArrayVector<typename Task::Stack> stacks(tasks);
+
+    Task task(si, src, di, dest, shape, axis, split_axis, slab_size,
+              sigma, invert, buffers, stacks);
+    parallel_foreach(ParallelOptions(tasks), slabs, task);
+}
+
 /********************************************************/
 /*                                                      */
 /*        internalSeparableMultiArrayDistTmp            */
@@ -151,7 +348,8 @@ template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Array>
 void internalSeparableMultiArrayDistTmp(
                       SrcIterator si, SrcShape const & shape, SrcAccessor src,
-                      DestIterator di, DestAccessor dest, Array const & sigmas, bool invert)
+                      DestIterator di, DestAccessor dest, Array const & sigmas, bool invert,
+                      ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     // Sigma is the spread of the parabolas. It determines the structuring element size
     // for ND morphology. When calculating the distance transforms, sigma is usually set to 1,
@@ -161,64 +359,24 @@ void internalSeparableMultiArrayDistTmp(
     // we need the Promote type here if we want to invert the image (dilation)
     typedef typename NumericTraits<typename DestAccessor::value_type>::RealPromote TmpType;
     
-    // temporary array to hold the current line to enable in-place operation
-    ArrayVector<TmpType> tmp( shape[0] );
-
-    typedef MultiArrayNavigator<SrcIterator, N> SNavigator;
-    typedef MultiArrayNavigator<DestIterator, N> DNavigator;
-    
-    
     // only operate on first dimension here
-    SNavigator snav( si, shape, 0 );
-    DNavigator dnav( di, shape, 0 );
-
-    using namespace vigra::functor;
-
-    for( ; snav.hasMore(); snav++, dnav++ )
-    {
-            // first copy source to temp for maximum cache efficiency
-            // Invert the values if necessary. Only needed for grayscale morphology
-            if(invert)
-                transformLine( snav.begin(), snav.end(), src, tmp.begin(),
-                               typename AccessorTraits<TmpType>::default_accessor(), 
-                               Param(NumericTraits<TmpType>::zero())-Arg1());
-            else
-                copyLine( snav.begin(), snav.end(), src, tmp.begin(),
-                          typename AccessorTraits<TmpType>::default_accessor() );
-
-            detail::distParabola( srcIterRange(tmp.begin(), tmp.end(),
-                          typename AccessorTraits<TmpType>::default_const_accessor()),
-                          destIter( dnav.begin(), dest ), sigmas[0] );
-    }
+    distParabolaLines<TmpType>(si, src, di, dest, shape, 0, sigmas[0], invert, parallel);
     
     // operate on further dimensions
     for( int d = 1; d < N; ++d )
-    {
-        DNavigator dnav( di, shape, d );
-
-        tmp.resize( shape[d] );
-        
-
-        for( ; dnav.hasMore(); dnav++ )
-        {
-             // first copy source to temp for maximum cache efficiency
-             copyLine( dnav.begin(), dnav.end(), dest,
-                       tmp.begin(), typename AccessorTraits<TmpType>::default_accessor() );
+        distParabolaLines<TmpType>(di, dest, di, dest, shape, d, sigmas[d], false, parallel);
 
-             detail::distParabola( srcIterRange(tmp.begin(), tmp.end(),
-                           typename AccessorTraits<TmpType>::default_const_accessor()),
-                           destIter( dnav.begin(), dest ), sigmas[d] );
-        }
-    }
+    using namespace vigra::functor;
     if(invert) transformMultiArray( di, shape, dest, di, dest, -Arg1());
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Array>
 inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const & shape, SrcAccessor src,
-                                                DestIterator di, DestAccessor dest, Array const & sigmas)
+                                                DestIterator di, DestAccessor dest, Array const & sigmas,
+                                                ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
-    internalSeparableMultiArrayDistTmp( si, shape, src, di, dest, sigmas, false );
+    internalSeparableMultiArrayDistTmp( si, shape, src, di, dest, sigmas, false, parallel );
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -265,7 +423,8 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
         separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
                                   MultiArrayView<N, T2, S2> dest,
                                   bool background,
-                                  Array const & pixelPitch);
+                                  Array const & pixelPitch,
+                                  ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
 
         // use default pixel pitch = 1.0 for each coordinate
         template <unsigned int N, class T1, class S1,
@@ -288,7 +447,8 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
         separableMultiDistSquared( SrcIterator s, SrcShape const & shape, SrcAccessor src,
                                    DestIterator d, DestAccessor dest, 
                                    bool background,
-                                   Array const & pixelPitch);
+                                   Array const & pixelPitch,
+                                   ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
                                         
         // use default pixel pitch = 1.0 for each coordinate
         template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -310,7 +470,8 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
         separableMultiDistSquared( triple<SrcIterator, SrcShape, SrcAccessor> const & source,
                                    pair<DestIterator, DestAccessor> const & dest, 
                                    bool background,
-                                   Array const & pixelPitch);
+                                   Array const & pixelPitch,
+                                   ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
                                                
         // use default pixel pitch = 1.0 for each coordinate
         template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -339,6 +500,11 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
     This is necessary when the data have non-uniform resolution (as is common in confocal
     microscopy, for example). 
 
+    The lines along each axis are independent. When <tt>parallel</tt> requests more
+    than one thread (see \ref ParallelOptions), they are distributed over the threads
+    in slabs perpendicular to the current axis. Each thread uses its own line buffer and
+    parabola stack, so the results are identical to sequential execution.
+
     This function may work in-place, which means that <tt>siter == diter</tt> is allowed.
     A full-sized internal array is only allocated if working on the destination
     array directly would cause overflow errors (i.e. if
@@ -358,6 +524,10 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
 
     // Calculate Euclidean distance squared for all background pixels 
     separableMultiDistSquared(source, dest, true);
+
+    // the same with as many threads as there are cores
+    separableMultiDistSquared(source, dest, true, TinyVector<double, 3>(1.0),
+                              ParallelOptions(ParallelOptions::Auto));
     \endcode
 
     \see vigra::distanceTransform(), vigra::separableMultiDistance()
@@ -368,7 +538,8 @@ template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Array>
 void separableMultiDistSquared( SrcIterator s, SrcShape const & shape, SrcAccessor src,
                                 DestIterator d, DestAccessor dest, bool background,
-                                Array const & pixelPitch)
+                                Array const & pixelPitch,
+                                ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     int N = shape.size();
 
@@ -407,7 +578,7 @@ void separableMultiDistSquared( SrcIterator s, SrcShape const & shape, SrcAccess
         detail::internalSeparableMultiArrayDistTmp( tmpArray.traverser_begin(), 
                 shape, typename AccessorTraits<Real>::default_accessor(),
                 tmpArray.traverser_begin(), 
-                typename AccessorTraits<Real>::default_accessor(), pixelPitch);
+                typename AccessorTraits<Real>::default_accessor(), pixelPitch, parallel);
         
         copyMultiArray(srcMultiArrayRange(tmpArray), destIter(d, dest));
     }
@@ -422,7 +593,7 @@ void separableMultiDistSquared( SrcIterator s, SrcShape const & shape, SrcAccess
             transformMultiArray( s, shape, src, d, dest, 
                                  ifThenElse( Arg1() != Param(zero), Param(maxDist), Param(rzero) ));
      
-        detail::internalSeparableMultiArrayDistTmp( d, shape, dest, d, dest, pixelPitch);
+        detail::internalSeparableMultiArrayDistTmp( d, shape, dest, d, dest, pixelPitch, parallel);
     }
 }
 
@@ -440,10 +611,11 @@ template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Array>
 inline void separableMultiDistSquared( triple<SrcIterator, SrcShape, SrcAccessor> const & source,
                                        pair<DestIterator, DestAccessor> const & dest, bool background,
-                                       Array const & pixelPitch)
+                                       Array const & pixelPitch,
+                                       ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     separableMultiDistSquared( source.first, source.second, source.third,
-                               dest.first, dest.second, background, pixelPitch );
+                               dest.first, dest.second, background, pixelPitch, parallel );
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -461,12 +633,13 @@ template <unsigned int N, class T1, class S1,
 inline void
 separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
                           MultiArrayView<N, T2, S2> dest, bool background,
-                          Array const & pixelPitch)
+                          Array const & pixelPitch,
+                          ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     vigra_precondition(source.shape() == dest.shape(),
         "separableMultiDistSquared(): shape mismatch between input and output.");
     separableMultiDistSquared( srcMultiArrayRange(source),
-                               destMultiArray(dest), background, pixelPitch );
+                               destMultiArray(dest), background, pixelPitch, parallel );
 }
 
 template <unsigned int N, class T1, class S1,
@@ -501,7 +674,8 @@ separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
         separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
                                MultiArrayView<N, T2, S2> dest, 
                                bool background,
-                               Array const & pixelPitch);
+                               Array const & pixelPitch,
+                               ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
 
         // use default pixel pitch = 1.0 for each coordinate
         template <unsigned int N, class T1, class S1,
@@ -524,7 +698,8 @@ separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
         separableMultiDistance( SrcIterator s, SrcShape const & shape, SrcAccessor src,
                                 DestIterator d, DestAccessor dest, 
                                 bool background,
-                                Array const & pixelPitch);
+                                Array const & pixelPitch,
+                                ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
                                         
         // use default pixel pitch = 1.0 for each coordinate
         template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -546,7 +721,8 @@ separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
         separableMultiDistance( triple<SrcIterator, SrcShape, SrcAccessor> const & source,
                                 pair<DestIterator, DestAccessor> const & dest, 
                                 bool background,
-                                Array const & pixelPitch);
+                                Array const & pixelPitch,
+                                ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial));
                                                
         // use default pixel pitch = 1.0 for each coordinate
         template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -588,9 +764,10 @@ template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Array>
 void separableMultiDistance( SrcIterator s, SrcShape const & shape, SrcAccessor src,
                              DestIterator d, DestAccessor dest, bool background,
-                             Array const & pixelPitch)
+                             Array const & pixelPitch,
+                             ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
-    separableMultiDistSquared( s, shape, src, d, dest, background, pixelPitch);
+    separableMultiDistSquared( s, shape, src, d, dest, background, pixelPitch, parallel);
     
     // Finally, calculate the square root of the distances
     using namespace vigra::functor;
@@ -615,10 +792,11 @@ template <class SrcIterator, class SrcShape, class SrcAccessor,
           class DestIterator, class DestAccessor, class Array>
 inline void separableMultiDistance( triple<SrcIterator, SrcShape, SrcAccessor> const & source,
                                     pair<DestIterator, DestAccessor> const & dest, bool background,
-                                    Array const & pixelPitch)
+                                    Array const & pixelPitch,
+                                    ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     separableMultiDistance( source.first, source.second, source.third,
-                            dest.first, dest.second, background, pixelPitch );
+                            dest.first, dest.second, background, pixelPitch, parallel );
 }
 
 template <class SrcIterator, class SrcShape, class SrcAccessor,
@@ -636,12 +814,13 @@ inline void
 separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
                        MultiArrayView<N, T2, S2> dest, 
                        bool background,
-                       Array const & pixelPitch)
+                       Array const & pixelPitch,
+                       ParallelOptions const & parallel = ParallelOptions(ParallelOptions::Serial))
 {
     vigra_precondition(source.shape() == dest.shape(),
         "separableMultiDistance(): shape mismatch between input and output.");
     separableMultiDistance( srcMultiArrayRange(source),
-                            destMultiArray(dest), background, pixelPitch );
+                            destMultiArray(dest), background, pixelPitch, parallel );
 }
 
 template <unsigned int N, class T1, class S1,
@@ -657,6 +836,610 @@ separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
                             destMultiArray(dest), background );
 }
 
+namespace detail {
+
+template <unsigned int N, class T2, int M, class S2, class Array>
+void
+internalSeparableVectorDistance(MultiArrayView<N, double> dist,
+                                MultiArrayView<N, TinyVector<T2, M>, S2> dest,
+                                Array const & pixelPitch)
+{
+    typedef typename MultiArrayView<N, double>::traverser DistIterator;
+    typedef typename MultiArrayView<N, TinyVector<T2, M>, S2>::traverser VectorIterator;
+    typedef MultiArrayNavigator<DistIterator, N> DNavigator;
+    typedef MultiArrayNavigator<VectorIterator, N> VNavigator;
+
+    ArrayVector<double> tmp;
+    ArrayVector<TinyVector<T2, M> > vectors;
+    ArrayVector<MultiArrayIndex> argmin;
+    std::vector<DistParabolaStackEntry<double> > stack;
+
+    for( unsigned int d = 0; d < N; ++d )
+    {
+        MultiArrayIndex w = dist.shape(d);
+        tmp.resize(w);
+        vectors.resize(w);
+        argmin.resize(w);
+
+        DNavigator dnav(dist.traverser_begin(), dist.shape(), d);
+        VNavigator vnav(dest.traverser_begin(), dest.shape(), d);
+        for( ; dnav.hasMore(); dnav++, vnav++ )
+        {
+            std::copy(dnav.begin(), dnav.end(), tmp.begin());
+            std::copy(vnav.begin(), vnav.end(), vectors.begin());
+
+            distParabolaArgMin(tmp.begin(), tmp.end(), StandardConstValueAccessor<double>(),
+                               dnav.begin(), StandardValueAccessor<double>(),
+                               argmin.begin(), pixelPitch[d], stack);
+
+            // the nearest point of an element is the nearest point of
+            // the winning parabola's center
+            typename VNavigator::iterator v = vnav.begin();
+            for( MultiArrayIndex x = 0; x < w; ++x, ++v )
+            {
+                *v = vectors[x + argmin[x]];
+                (*v)[d] += (T2)argmin[x];
+            }
+        }
+    }
+}
+
+template <unsigned int N, int M>
+struct SeparableVectorDistance_error__vector_size_must_equal_the_array_dimension
+: staticAssert::AssertBool<(M == (int)N)>
+{};
+
+template <class T>
+struct SeparableVectorDistance_error__vector_type_must_be_signed
+: staticAssert::AssertBool<NumericTraits<T>::isSigned::value>
+{};
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*               separableVectorDistance                */
+/*                                                      */
+/********************************************************/
+
+/** \brief Euclidean feature transform on multi-dimensional arrays.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        // explicitly specify pixel pitch for each coordinate
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                  class Array>
+        void
+        separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                                MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                                bool background,
+                                Array const & pixelPitch);
+
+        // use default pixel pitch = 1.0 for each coordinate
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                                MultiArrayView<N, TinyVector<T2, N>, S2> dest,
+                                bool background);
+    }
+    \endcode
+
+    For every element <tt>p</tt>, this function computes the vector <tt>dest[p]</tt>
+    from <tt>p</tt> to the nearest feature element, so that the nearest feature
+    element is <tt>p + dest[p]</tt>. The features are defined as in \ref separableMultiDistSquared():
+    if <tt>background</tt> is true, the features are the non-zero elements of
+    <tt>source</tt> (i.e. the vectors of the background elements point to the nearest object),
+    otherwise the features are the zero elements (i.e. the vectors of the object
+    elements point to the nearest background element). The vectors of the features
+    themselves are zero. The vectors are given in units of array elements, but
+    "nearest" is measured with the given pixel pitch. If there are several
+    nearest features, one of them is chosen arbitrarily. If the array contains no
+    features at all, the result is undefined.
+
+    The algorithm is the same as in \ref separableMultiDistSquared(), but the
+    parabola envelopes also track their argmin, so that the squared
+    distance is <tt>squaredNorm(pixelPitch*dest[p])</tt>. The vector size must
+    equal <tt>N</tt>, and the vector type <tt>T2</tt> must be signed (both are
+    checked at compile time). Typical applications are the assignment of elements to the Voronoi
+    regions of seeds (e.g. <tt>labels[p] = seeds[p + dest[p]]</tt>) and skeleton-based
+    measurements.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_distance.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    Shape3 shape(width, height, depth);
+    MultiArray<3, UInt32> seeds(shape), voronoi(shape);
+    MultiArray<3, TinyVector<Int32, 3> > nearest(shape);
+    ...
+    // find the nearest seed of every element
+    separableVectorDistance(seeds, nearest, true);
+
+    // Voronoi tesselation of the array
+    for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+        voronoi[*p] = seeds[*p + nearest[*p]];
+    \endcode
+
+    \see vigra::separableMultiDistSquared()
+*/
+doxygen_overloaded_function(template <...> void separableVectorDistance)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, int M, class S2,
+          class Array>
+void
+separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, TinyVector<T2, M>, S2> dest,
+                        bool background,
+                        Array const & pixelPitch)
+{
+    VIGRA_STATIC_ASSERT((detail::SeparableVectorDistance_error__vector_size_must_equal_the_array_dimension<N, M>));
+    VIGRA_STATIC_ASSERT((detail::SeparableVectorDistance_error__vector_type_must_be_signed<T2>));
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "separableVectorDistance(): shape mismatch between input and output.");
+
+    double dmax = 0.0;
+    for( unsigned int k=0; k<N; ++k)
+        dmax += sq(pixelPitch[k]*source.shape(k));
+
+    // Threshold the values so all non-features have infinity value in the beginning
+    MultiArray<N, double> dist(source.shape());
+    using namespace vigra::functor;
+    T1 zero = NumericTraits<T1>::zero();
+    if(background == true)
+        transformMultiArray(source, dist, 
+                            ifThenElse( Arg1() == Param(zero), Param(dmax), Param(0.0) ));
+    else
+        transformMultiArray(source, dist, 
+                            ifThenElse( Arg1() != Param(zero), Param(dmax), Param(0.0) ));
+    dest.init(TinyVector<T2, M>());
+
+    detail::internalSeparableVectorDistance(dist, dest, pixelPitch);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, int M, class S2>
+inline void
+separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, TinyVector<T2, M>, S2> dest,
+                        bool background)
+{
+    separableVectorDistance(source, dest, background, TinyVector<double, N>(1.0));
+}
+
+namespace detail {
+
+    // L1 distance along a line: the exact 1D transform
+    // min_i (|x - i| + g(i)) is obtained by two propagation passes.
+struct DistL1Line
+{
+    void operator()(ArrayVector<MultiArrayIndex> & g) const
+    {
+        MultiArrayIndex w = (MultiArrayIndex)g.size();
+        for(MultiArrayIndex x = 1; x < w; ++x)
+            g[x] = std::min(g[x], g[x-1] + 1);
+        for(MultiArrayIndex x = w - 2; x >= 0; --x)
+            g[x] = std::min(g[x], g[x+1] + 1);
+    }
+};
+
+    // L-infinity distance along a line: the 1D transform
+    // min_i max(|x - i|, g(i)) in linear time, after A. Meijster, J. Roerdink,
+    // W. Hesselink: "A General Algorithm for Computing Distance Transforms
+    // in Linear Time", Mathematical Morphology and its Applications to Image
+    // and Signal Processing, 2000.
+struct DistLInfLine
+{
+    mutable ArrayVector<MultiArrayIndex> s_, t_, res_;
+
+    static MultiArrayIndex 
+    f(ArrayVector<MultiArrayIndex> const & g, MultiArrayIndex x, MultiArrayIndex i)
+    {
+        return std::max(std::abs(x - i), g[i]);
+    }
+
+    static MultiArrayIndex 
+    sep(ArrayVector<MultiArrayIndex> const & g, MultiArrayIndex i, MultiArrayIndex u)
+    {
+        return g[i] <= g[u]
+                   ? std::max(i + g[u], (i + u) / 2)
+                   : std::min(u - g[i], (i + u) / 2);
+    }
+
+    void operator()(ArrayVector<MultiArrayIndex> & g) const
+    {
+        MultiArrayIndex w = (MultiArrayIndex)g.size();
+        s_.resize(w);
+        t_.resize(w);
+        res_.resize(w);
+
+        MultiArrayIndex q = 0;
+        s_[0] = 0;
+        t_[0] = 0;
+        for(MultiArrayIndex u = 1; u < w; ++u)
+        {
+            while(q >= 0 && f(g, t_[q], s_[q]) > f(g, t_[q], u))
+                --q;
+            if(q < 0)
+            {
+                q = 0;
+                s_[0] = u;
+            }
+            else
+            {
+                MultiArrayIndex v = 1 + sep(g, s_[q], u);
+                if(v < w)
+                {
+                    ++q;
+                    s_[q] = u;
+                    t_[q] = v;
+                }
+            }
+        }
+        for(MultiArrayIndex u = w - 1; u >= 0; --u)
+        {
+            res_[u] = f(g, u, s_[q]);
+            if(u == t_[q])
+                --q;
+        }
+        g.swap(res_);
+    }
+};
+
+    // Initialize 'dist' with 0 at the features and a value larger than any
+    // distance elsewhere, and apply 'line' to all lines along all axes.
+template <unsigned int N, class T1, class S1, class LineFunctor>
+void
+internalSeparableMultiDistanceLines(MultiArrayView<N, T1, S1> const & source,
+                                    MultiArrayView<N, MultiArrayIndex> dist,
+                                    bool background, LineFunctor const & line)
+{
+    typedef typename MultiArrayView<N, MultiArrayIndex>::traverser DistIterator;
+    typedef MultiArrayNavigator<DistIterator, N> DNavigator;
+
+    MultiArrayIndex infinity = 1;
+    for(unsigned int k=0; k<N; ++k)
+        infinity += source.shape(k);
+
+    using namespace vigra::functor;
+    T1 zero = NumericTraits<T1>::zero();
+    if(background == true)
+        transformMultiArray(source, dist, 
+                            ifThenElse( Arg1() == Param(zero), Param(infinity), Param(MultiArrayIndex(0)) ));
+    else
+        transformMultiArray(source, dist, 
+                            ifThenElse( Arg1() != Param(zero), Param(infinity), Param(MultiArrayIndex(0)) ));
+
+    ArrayVector<MultiArrayIndex> tmp;
+    for( unsigned int d = 0; d < N; ++d )
+    {
+        tmp.resize(dist.shape(d));
+        for(DNavigator dnav(dist.traverser_begin(), dist.shape(), d); dnav.hasMore(); dnav++ )
+        {
+            std::copy(dnav.begin(), dnav.end(), tmp.begin());
+            line(tmp);
+            std::copy(tmp.begin(), tmp.end(), dnav.begin());
+        }
+    }
+}
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*               separableMultiDistanceL1               */
+/*                                                      */
+/********************************************************/
+
+/** \brief Manhattan (L1) and chessboard (L-infinity) distance on multi-dimensional arrays.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        separableMultiDistanceL1(MultiArrayView<N, T1, S1> const & source,
+                                 MultiArrayView<N, T2, S2> dest,
+                                 bool background);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        separableMultiDistanceLInf(MultiArrayView<N, T1, S1> const & source,
+                                   MultiArrayView<N, T2, S2> dest,
+                                   bool background);
+    }
+    \endcode
+
+    These functions are the counterparts of \ref separableMultiDistance() for the
+    L1 norm (sum of the coordinate differences) and the L-infinity norm (maximum of the
+    coordinate differences). The arguments <tt>source</tt> and <tt>background</tt> have the
+    same meaning as there. Both transforms are exact and separable, and take
+    linear time per axis: the L1 distance is propagated by a forward and a backward
+    pass along each line, and the L-infinity distance is computed with the
+    algorithm of Meijster et al. ("A General Algorithm for Computing Distance Transforms
+    in Linear Time", 2000). If the array contains no features at all, the result is a
+    value larger than any possible distance. The functions may work in-place.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_distance.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    Shape3 shape(width, height, depth);
+    MultiArray<3, unsigned char> source(shape);
+    MultiArray<3, UInt16> dest(shape);
+    ...
+
+    // Calculate the city-block distance of all background voxels to the nearest object
+    separableMultiDistanceL1(source, dest, true);
+    \endcode
+
+    \see vigra::distanceTransform(), vigra::separableMultiDistance()
+*/
+doxygen_overloaded_function(template <...> void separableMultiDistanceL1)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+separableMultiDistanceL1(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         bool background)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "separableMultiDistanceL1(): shape mismatch between input and output.");
+    MultiArray<N, MultiArrayIndex> dist(source.shape());
+    detail::internalSeparableMultiDistanceLines(source, dist, background, detail::DistL1Line());
+    dest = dist;
+}
+
+/********************************************************/
+/*                                                      */
+/*              separableMultiDistanceLInf              */
+/*                                                      */
+/********************************************************/
+
+    /** \brief Chessboard (L-infinity) distance on multi-dimensional arrays.
+
+        See \ref separableMultiDistanceL1() for the documentation.
+    */
+doxygen_overloaded_function(template <...> void separableMultiDistanceLInf)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+separableMultiDistanceLInf(MultiArrayView<N, T1, S1> const & source,
+                           MultiArrayView<N, T2, S2> dest,
+                           bool background)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "separableMultiDistanceLInf(): shape mismatch between input and output.");
+    MultiArray<N, MultiArrayIndex> dist(source.shape());
+    detail::internalSeparableMultiDistanceLines(source, dist, background, detail::DistLInfLine());
+    dest = dist;
+}
+
+namespace detail {
+
+    // Signed squared distance transform in a single array: inside elements
+    // hold the squared distance to the nearest outside cell (> 0), outside
+    // elements hold the negative squared distance to the nearest inside cell.
+    // Both envelopes of a line are computed from the same buffer.
+template <unsigned int N, class Real, class S, class Array>
+void
+internalSignedMultiDistSquared(MultiArrayView<N, Real, S> dist, Array const & pixelPitch)
+{
+    typedef typename MultiArrayView<N, Real, S>::traverser DistIterator;
+    typedef MultiArrayNavigator<DistIterator, N> DNavigator;
+    typedef typename AccessorTraits<Real>::default_accessor Accessor;
+    typedef typename AccessorTraits<Real>::default_const_accessor ConstAccessor;
+
+    ArrayVector<Real> line, inside, outside;
+    std::vector<DistParabolaStackEntry<Real> > stack;
+
+    for( unsigned int d = 0; d < N; ++d )
+    {
+        MultiArrayIndex w = dist.shape(d);
+        line.resize(w);
+        inside.resize(w);
+        outside.resize(w);
+
+        for(DNavigator dnav(dist.traverser_begin(), dist.shape(), d); dnav.hasMore(); dnav++ )
+        {
+            std::copy(dnav.begin(), dnav.end(), line.begin());
+
+            bool hasInside = false, hasOutside = false;
+            for( MultiArrayIndex x = 0; x < w; ++x )
+            {
+                if(line[x] > 0)
+                {
+                    hasInside = true;
+                    inside[x] = line[x];
+                    outside[x] = 0;
+                }
+                else
+                {
+                    hasOutside = true;
+                    inside[x] = 0;
+                    outside[x] = -line[x];
+                }
+            }
+
+            // the distances of one class are only needed if the line contains it
+            if(hasInside)
+                distParabolaHalfCell(inside.begin(), inside.end(), ConstAccessor(),
+                                     inside.begin(), Accessor(), pixelPitch[d], stack);
+            if(hasOutside)
+                distParabolaHalfCell(outside.begin(), outside.end(), ConstAccessor(),
+                                     outside.begin(), Accessor(), pixelPitch[d], stack);
+
+            typename DNavigator::iterator v = dnav.begin();
+            for( MultiArrayIndex x = 0; x < w; ++x, ++v )
+                *v = line[x] > 0
+                        ? inside[x]
+                        : -outside[x];
+        }
+    }
+}
+
+    // real-valued destination: work directly on the destination array
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Array>
+void
+signedMultiDistanceImpl(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        Array const & pixelPitch, T2 maxDist, VigraTrueType)
+{
+    using namespace vigra::functor;
+    T1 zero = NumericTraits<T1>::zero();
+    
+    transformMultiArray(source, dest, 
+                        ifThenElse( Arg1() != Param(zero), Param(maxDist), Param(-maxDist) ));
+    internalSignedMultiDistSquared(dest, pixelPitch);
+    transformMultiArray(dest, dest, 
+                        ifThenElse( Arg1() > Param(T2(0.0)), -sqrt(Arg1()), sqrt(-Arg1()) ));
+}
+
+    // other destinations: need a temporary array to avoid rounding errors
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Array, class Real>
+void
+signedMultiDistanceImpl(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        Array const & pixelPitch, Real maxDist, VigraFalseType)
+{
+    using namespace vigra::functor;
+    T1 zero = NumericTraits<T1>::zero();
+    
+    MultiArray<N, Real> tmp(source.shape());
+    transformMultiArray(source, tmp, 
+                        ifThenElse( Arg1() != Param(zero), Param(maxDist), Param(-maxDist) ));
+    internalSignedMultiDistSquared(MultiArrayView<N, Real>(tmp), pixelPitch);
+    transformMultiArray(tmp, dest, 
+                        ifThenElse( Arg1() > Param(Real(0.0)), -sqrt(Arg1()), sqrt(-Arg1()) ));
+}
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                  signedMultiDistance                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Signed Euclidean distance to the boundary of a region.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        // explicitly specify pixel pitch for each coordinate
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                  class Array>
+        void
+        signedMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, T2, S2> dest,
+                            Array const & pixelPitch);
+
+        // use default pixel pitch = 1.0 for each coordinate
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        signedMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, T2, S2> dest);
+    }
+    \endcode
+
+    The region is given by the non-zero elements of <tt>source</tt>. Each element
+    represents a cell of size <tt>pixelPitch</tt> around its center, and the boundary
+    of the region is the interface between the cells of the region and the cells of
+    the zero elements, which lies half way between the centers of neighboring
+    inside and outside elements. The function computes the exact Euclidean distance
+    (respecting <tt>pixelPitch</tt>) of every element's center to this interface, i.e.
+    to the nearest cell of the other class, negative inside the region and positive
+    outside (the usual convention for level sets). Thus, the elements next to the interface
+    get the distance <tt>+/-pixelPitch[k]/2</tt> when the interface is crossed along axis
+    <tt>k</tt> (e.g. <tt>+/-1.75</tt> along the z-axis in the example below), and the
+    distance never vanishes.
+
+    Both the inside and the outside distances are computed in a single call with the
+    algorithm of \ref separableMultiDistSquared(). They share the same temporary
+    array (or <tt>dest</tt> itself when it is real-valued), because the sign of
+    each element identifies the class whose distance must be propagated. If the
+    array contains only one class, the result is undefined.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_distance.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    Shape3 shape(width, height, depth);
+    MultiArray<3, UInt8> mask(shape);
+    MultiArray<3, float> levelset(shape);
+    ...
+    // initialize a level set from a segmentation with anisotropic resolution
+    signedMultiDistance(mask, levelset, TinyVector<double, 3>(1.0, 1.0, 3.5));
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    source.shape() == dest.shape()
+    pixelPitch[k] > 0
+    \endcode
+
+    \see vigra::separableMultiDistSquared(), vigra::separableMultiDistance()
+*/
+doxygen_overloaded_function(template <...> void signedMultiDistance)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Array>
+void
+signedMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                    MultiArrayView<N, T2, S2> dest,
+                    Array const & pixelPitch)
+{
+    typedef typename NumericTraits<T2>::RealPromote Real;
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "signedMultiDistance(): shape mismatch between input and output.");
+
+    double dmax = 0.0;
+    for( unsigned int k=0; k<N; ++k)
+    {
+        vigra_precondition(pixelPitch[k] > 0.0,
+            "signedMultiDistance(): pixel pitch must be positive.");
+        dmax += sq(pixelPitch[k]*source.shape(k));
+    }
+
+    detail::signedMultiDistanceImpl(source, dest, pixelPitch, (Real)dmax,
+                                    typename IsSameType<Real, T2>::type());
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+signedMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                    MultiArrayView<N, T2, S2> dest)
+{
+    signedMultiDistance(source, dest, TinyVector<double, N>(1.0));
+}
+
 //@}
 
 } //-- namespace vigra
@@ -0,0 +1,512 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_MULTI_FILTERBANK_HXX
+#define VIGRA_MULTI_FILTERBANK_HXX
+
+#include <algorithm>
+#include "multi_array.hxx"
+#include "multi_convolution.hxx"
+#include "multi_tensorutilities.hxx"
+#include "multi_math.hxx"
+#include "static_assert.hxx"
+
+namespace vigra {
+
+/********************************************************/
+/*                                                      */
+/*                      FilterBank                      */
+/*                                                      */
+/********************************************************/
+
+/** \brief List of (feature, scale) pairs to be computed by \ref filterBankMultiArray().
+
+  <b>\#include</b> \<vigra/multi_filterbank.hxx\><br/>
+  Namespace: vigra
+
+  Each feature results in one output channel, except for the eigenvalue
+  features, which result in <tt>N</tt> channels (for an <tt>N</tt>-dimensional
+  array, sorted in descending order). The channels are arranged in the order in
+  which the features were added.
+
+  \code
+  FilterBank bank;
+  double scales[] = { 0.7, 1.0, 1.6, 3.5, 5.0, 10.0 };
+  for(int k=0; k<6; ++k)
+      bank.add(FilterBank::GaussianSmoothing, scales[k])
+          .add(FilterBank::GradientMagnitude, scales[k])
+          .add(FilterBank::HessianEigenvalues, scales[k]);
+
+  MultiArray<4, float> features(Shape4(volume.shape(0), volume.shape(1), volume.shape(2),
+                                       bank.channelCount(3)));
+  filterBankMultiArray(volume, features, bank);
+  \endcode
+*/
+class FilterBank
+{
+  public:
+
+    enum Feature {
+        GaussianSmoothing,          ///< \ref gaussianSmoothMultiArray() (1 channel)
+        GradientMagnitude,          ///< \ref gaussianGradientMagnitude() (1 channel)
+        LaplacianOfGaussian,        ///< \ref laplacianOfGaussianMultiArray() (1 channel)
+        HessianEigenvalues,         ///< eigenvalues of \ref hessianOfGaussianMultiArray() (N channels)
+        StructureTensorEigenvalues  ///< eigenvalues of \ref structureTensorMultiArray() (N channels)
+    };
+
+    struct Item
+    {
+        Feature feature;
+        double scale, outer_scale;
+    };
+
+    FilterBank()
+    : cascade_(false)
+    {}
+
+        /** Add a feature at the given scale.
+
+            For <tt>StructureTensorEigenvalues</tt>, <tt>scale</tt> is the inner scale
+            (of the gradient), and <tt>outerScale</tt> the scale of the subsequent smoothing.
+            If <tt>outerScale</tt> is zero, half the inner scale is used. For the
+            other features, <tt>outerScale</tt> is ignored.
+        */
+    FilterBank & add(Feature feature, double scale, double outerScale = 0.0)
+    {
+        vigra_precondition(scale > 0.0 && outerScale >= 0.0,
+            "FilterBank::add(): scales must be positive.");
+        Item item = { feature, scale,
+                      outerScale > 0.0 ? outerScale : 0.5*scale };
+        items_.push_back(item);
+        return *this;
+    }
+
+        /** Compute larger scales from the smoothed results of the next smaller scale.
+
+            The Gaussian at scale <tt>s2</tt> is obtained by smoothing the result at
+            scale <tt>s1 < s2</tt> with a Gaussian of scale <tt>sqrt(s2*s2 - s1*s1)</tt>
+            (see \ref ConvolutionOptions::resolutionStdDev()). This reduces the kernel
+            sizes considerably, but the result differs from direct filtering,
+            because the sampled kernels do not compose exactly: for typical scale
+            sequences (e.g. 0.7, 1.0, 1.6, 3.5, 5.0, 10.0), the features deviate by 
+            up to about 3% of their maximum absolute value. Since sampled derivative
+            kernels are inaccurate for very small scales, a scale is only computed
+            incrementally when <tt>sqrt(s2*s2 - s1*s1) >= 1.0</tt>, and directly from
+            the source otherwise.
+
+            Default: <tt>false</tt> (i.e. filter all scales directly)
+        */
+    FilterBank & cascadeScales(bool cascade = true)
+    {
+        cascade_ = cascade;
+        return *this;
+    }
+
+    bool cascade() const
+    {
+        return cascade_;
+    }
+
+        /** Number of features.
+        */
+    unsigned int size() const
+    {
+        return items_.size();
+    }
+
+    Item const & operator[](unsigned int k) const
+    {
+        return items_[k];
+    }
+
+        /** Number of channels that feature <tt>k</tt> produces for
+            an array of dimension <tt>ndim</tt>.
+        */
+    unsigned int channelCount(unsigned int k, unsigned int ndim) const
+    {
+        return items_[k].feature == HessianEigenvalues ||
+               items_[k].feature == StructureTensorEigenvalues
+                   ? ndim
+                   : 1;
+    }
+
+        /** Total number of output channels for an array of dimension <tt>ndim</tt>.
+        */
+    unsigned int channelCount(unsigned int ndim) const
+    {
+        unsigned int res = 0;
+        for(unsigned int k=0; k<size(); ++k)
+            res += channelCount(k, ndim);
+        return res;
+    }
+
+  private:
+    ArrayVector<Item> items_;
+    bool cascade_;
+};
+
+namespace detail {
+
+template <unsigned int N>
+struct FilterBank_error__only_2D_and_3D_arrays_are_supported
+: staticAssert::AssertBool<(N == 2 || N == 3)>
+{};
+
+    // The Gaussian derivatives of one scale are identified by their index
+    // sum_k order[k]*3^k, i.e. the derivative order along each axis is at most 2.
+template <class Shape>
+int filterBankDerivativeIndex(Shape const & order)
+{
+    int res = 0;
+    for(int k=Shape::static_size-1; k>=0; --k)
+        res = 3*res + (int)order[k];
+    return res;
+}
+
+inline int filterBankPower3(int k)
+{
+    int res = 1;
+    for(; k>0; --k)
+        res *= 3;
+    return res;
+}
+
+    // Evaluate all needed Gaussian derivatives by a tree of 1D convolutions:
+    // the first level convolves 'src' along axis 0 with each of the required kernels
+    // (derivative order 0, 1, or 2), the next level convolves each of these results along
+    // axis 1 and so on. Thus, intermediate results are shared by all derivatives
+    // whose orders for the axes processed so far are identical. 'prefix' encodes the
+    // derivative orders along the axes before 'axis' (see filterBankDerivativeIndex()).
+template <unsigned int N, class T, class S, class TmpType>
+void
+filterBankDerivatives(MultiArrayView<N, T, S> const & src,
+                      unsigned int axis, int prefix,
+                      ArrayVector<bool> const & needed,
+                      ArrayVector<ArrayVector<Kernel1D<TmpType> > > const & kernels,
+                      ArrayVector<MultiArray<N, TmpType> > & results,
+                      ParallelOptions const & parallel)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    int stride = filterBankPower3(axis),
+        range  = 3*stride;
+    for(int order=0; order<3; ++order)
+    {
+        int index = prefix + order*stride;
+        bool required = false;
+        for(unsigned int k=index; k<needed.size(); k+=range)
+            required = required || needed[k];
+        if(!required)
+            continue;
+
+        MultiArray<N, TmpType> tmp(src.shape());
+        detail::convolveMultiArrayLines<TmpType>(src.traverser_begin(), typename AccessorTraits<T>::default_const_accessor(),
+                                                 Shape(), src.shape(),
+                                                 tmp.traverser_begin(), typename AccessorTraits<TmpType>::default_accessor(),
+                                                 Shape(), axis, kernels[axis][order], 0, 0, 0, parallel);
+        if(axis == N-1)
+            results[index].swap(tmp);
+        else
+            filterBankDerivatives(tmp, axis+1, index, needed, kernels, results, parallel);
+    }
+}
+
+    // Compute the features of filterBankMultiArray() with temporaries of type 'TmpType'.
+template <class TmpType, unsigned int N, class T1, class S1,
+                                         class T2, class S2>
+void
+filterBankMultiArrayImpl(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N+1, T2, S2> dest,
+                         FilterBank const & bank,
+                         ConvolutionOptions<N> const & opt)
+{
+    using namespace multi_math;
+
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef MultiArray<N, TmpType> TmpArray;
+    static const int M = N*(N+1)/2;
+
+    // process the scales in ascending order
+    ArrayVector<double> scales;
+    for(unsigned int k=0; k<bank.size(); ++k)
+        scales.push_back(bank[k].scale);
+    std::sort(scales.begin(), scales.end());
+    scales.erase(std::unique(scales.begin(), scales.end()), scales.end());
+
+    ArrayVector<int> channels(bank.size());
+    for(unsigned int k=0, c=0; k<bank.size(); c+=bank.channelCount(k, N), ++k)
+        channels[k] = c;
+
+    // Smaller increments are computed from the source, because the
+    // sampled derivative kernels are inaccurate for small scales.
+    static const double minimalIncrement = 1.0;
+
+    int derivativeCount = detail::filterBankPower3(N);
+    TmpArray presmoothed;
+    double presmoothing = 0.0;
+
+    for(unsigned int s=0; s<scales.size(); ++s)
+    {
+        double scale = scales[s];
+        bool cascade = bank.cascade() && s+1 < scales.size();
+
+        // determine the required derivatives
+        ArrayVector<bool> needed(derivativeCount, false);
+        needed[0] = cascade;
+        for(unsigned int k=0; k<bank.size(); ++k)
+        {
+            if(bank[k].scale != scale)
+                continue;
+            switch(bank[k].feature)
+            {
+              case FilterBank::GaussianSmoothing:
+                needed[0] = true;
+                break;
+              case FilterBank::GradientMagnitude:
+              case FilterBank::StructureTensorEigenvalues:
+                for(unsigned int i=0; i<N; ++i)
+                    needed[detail::filterBankPower3(i)] = true;
+                break;
+              case FilterBank::LaplacianOfGaussian:
+                for(unsigned int i=0; i<N; ++i)
+                    needed[2*detail::filterBankPower3(i)] = true;
+                break;
+              case FilterBank::HessianEigenvalues:
+                for(unsigned int i=0; i<N; ++i)
+                    for(unsigned int j=i; j<N; ++j)
+                        needed[detail::filterBankPower3(i) + detail::filterBankPower3(j)] = true;
+                break;
+            }
+        }
+
+        // create the kernels for derivative orders 0, 1, 2 along each axis
+        bool usePresmoothed = presmoothing > 0.0 &&
+                              sq(scale) - sq(presmoothing) >= sq(minimalIncrement);
+        ConvolutionOptions<N> scaleOptions(opt);
+        scaleOptions.stdDev(scale);
+        if(usePresmoothed)
+            scaleOptions.resolutionStdDev(presmoothing);
+        ArrayVector<ArrayVector<Kernel1D<TmpType> > > kernels(N, ArrayVector<Kernel1D<TmpType> >(3));
+        for(int order=0; order<3; ++order)
+        {
+            ArrayVector<Kernel1D<TmpType> > k;
+            detail::initGaussianDerivativeKernels(scaleOptions, Shape(order), k, "filterBankMultiArray");
+            for(unsigned int i=0; i<N; ++i)
+                kernels[i][order] = k[i];
+        }
+
+        ArrayVector<TmpArray> d(derivativeCount);
+        if(usePresmoothed)
+            detail::filterBankDerivatives(presmoothed, 0, 0, needed, kernels, d, opt.parallel_lines);
+        else
+            detail::filterBankDerivatives(source, 0, 0, needed, kernels, d, opt.parallel_lines);
+
+        // compute the features of this scale
+        for(unsigned int k=0; k<bank.size(); ++k)
+        {
+            if(bank[k].scale != scale)
+                continue;
+            switch(bank[k].feature)
+            {
+              case FilterBank::GaussianSmoothing:
+              {
+                dest.bindOuter(channels[k]) = d[0];
+                break;
+              }
+              case FilterBank::GradientMagnitude:
+              {
+                TmpArray res(sq(d[1]));
+                for(unsigned int i=1; i<N; ++i)
+                    res += sq(d[detail::filterBankPower3(i)]);
+                dest.bindOuter(channels[k]) = sqrt(res);
+                break;
+              }
+              case FilterBank::LaplacianOfGaussian:
+              {
+                TmpArray res(d[2]);
+                for(unsigned int i=1; i<N; ++i)
+                    res += d[2*detail::filterBankPower3(i)];
+                dest.bindOuter(channels[k]) = res;
+                break;
+              }
+              case FilterBank::HessianEigenvalues:
+              {
+                MultiArray<N, TinyVector<TmpType, M> > hessian(source.shape());
+                for(unsigned int i=0, b=0; i<N; ++i)
+                    for(unsigned int j=i; j<N; ++j, ++b)
+                        hessian.bindElementChannel(b) = d[detail::filterBankPower3(i) + detail::filterBankPower3(j)];
+                MultiArray<N, TinyVector<TmpType, N> > ev(source.shape());
+                tensorEigenvaluesMultiArray(hessian, ev);
+                for(unsigned int i=0; i<N; ++i)
+                    dest.bindOuter(channels[k]+i) = ev.bindElementChannel(i);
+                break;
+              }
+              case FilterBank::StructureTensorEigenvalues:
+              {
+                MultiArray<N, TinyVector<TmpType, M> > tensor(source.shape());
+                for(unsigned int i=0, b=0; i<N; ++i)
+                    for(unsigned int j=i; j<N; ++j, ++b)
+                        tensor.bindElementChannel(b) = d[detail::filterBankPower3(i)] *
+                                                       d[detail::filterBankPower3(j)];
+                ConvolutionOptions<N> outerOptions(opt);
+                outerOptions.stdDev(bank[k].outer_scale).resolutionStdDev(0.0)
+                            .recursiveFilter(false).convolutionMethod(CONVOLUTION_SPATIAL);
+                gaussianSmoothMultiArray(tensor, tensor, outerOptions);
+                MultiArray<N, TinyVector<TmpType, N> > ev(source.shape());
+                tensorEigenvaluesMultiArray(tensor, ev);
+                for(unsigned int i=0; i<N; ++i)
+                    dest.bindOuter(channels[k]+i) = ev.bindElementChannel(i);
+                break;
+              }
+            }
+        }
+
+        if(cascade)
+        {
+            presmoothed.swap(d[0]);
+            presmoothing = scale;
+        }
+    }
+}
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                 filterBankMultiArray                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Compute a list of Gaussian features at several scales.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        filterBankMultiArray(MultiArrayView<N, T1, S1> const & source,
+                             MultiArrayView<N+1, T2, S2> dest,
+                             FilterBank const & bank,
+                             ConvolutionOptions<N> const & opt = ConvolutionOptions<N>());
+    }
+    \endcode
+
+    The features listed in the \ref FilterBank are written to the channels of
+    <tt>dest</tt> (i.e. along its last axis), which must have
+    <tt>bank.channelCount(N)</tt> channels. By default, the result is equivalent 
+    (up to rounding errors) to calling the individual filter functions 
+    (\ref gaussianSmoothMultiArray(), \ref gaussianGradientMagnitude(), 
+    \ref laplacianOfGaussianMultiArray(), \ref hessianOfGaussianMultiArray() and 
+    \ref structureTensorMultiArray(), followed by \ref tensorEigenvaluesMultiArray()), 
+    but much faster, because intermediate results are shared:
+
+    <ul>
+    <li> All features of the same scale are computed from a common set of Gaussian
+         derivatives (up to second order), so that the gradient is computed only once
+         for the gradient magnitude, the Hessian, and the structure tensor, and the
+         Laplacian is just the trace of the Hessian.
+    <li> These derivatives are computed by a tree of 1D convolutions, such that the
+         partial results along the first axes are reused for all derivatives
+         with identical orders along these axes. In 3D, the 10 derivatives of up to
+         second order require 19 instead of 30 1D convolutions.
+    <li> Optionally, the scales are processed in ascending order, and the smoothed 
+         result of each scale serves as input for the next larger scale, which then 
+         requires smaller kernels, at the price of an approximation error 
+         (see \ref FilterBank::cascadeScales()).
+    </ul>
+
+    The options <tt>stepSize()</tt>, <tt>resolutionStdDev()</tt>, <tt>filterWindowSize()</tt>
+    and <tt>parallelLines()</tt> of <tt>opt</tt> are taken into account.
+    All convolutions are spatial, and an ROI is not supported.
+    Computations are done in double precision, unless
+    \ref ConvolutionOptions::floatArithmetic() is set, in which case
+    <tt>NumericTraits<T2>::RealPromote</tt> is used (i.e. <tt>float</tt>
+    when the destination is <tt>float</tt>).
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_filterbank.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt8> volume(Shape3(200, 200, 100));
+    ...
+    FilterBank bank;
+    bank.add(FilterBank::GaussianSmoothing, 1.0)
+        .add(FilterBank::LaplacianOfGaussian, 1.0)
+        .add(FilterBank::StructureTensorEigenvalues, 1.0, 2.0)
+        .add(FilterBank::GaussianSmoothing, 3.5);
+
+    MultiArray<4, float> features(Shape4(200, 200, 100, bank.channelCount(3)));
+    filterBankMultiArray(volume, features, bank);
+    \endcode
+
+    <b> Preconditions:</b>
+
+    <tt>N == 2</tt> or <tt>N == 3</tt>
+*/
+doxygen_overloaded_function(template <...> void filterBankMultiArray)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+filterBankMultiArray(MultiArrayView<N, T1, S1> const & source,
+                     MultiArrayView<N+1, T2, S2> dest,
+                     FilterBank const & bank,
+                     ConvolutionOptions<N> const & opt = ConvolutionOptions<N>())
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename NumericTraits<T2>::RealPromote FloatTmpType;
+    typedef typename PromoteTraits<FloatTmpType, double>::Promote DefaultTmpType;
+
+    VIGRA_STATIC_ASSERT((detail::FilterBank_error__only_2D_and_3D_arrays_are_supported<N>));
+
+    vigra_precondition(source.shape() == dest.bindOuter(0).shape() &&
+                       dest.shape(N) == (MultiArrayIndex)bank.channelCount(N),
+        "filterBankMultiArray(): shape mismatch between input and output.");
+    vigra_precondition(opt.to_point == Shape(),
+        "filterBankMultiArray(): ROI is not supported.");
+
+    if(opt.float_arithmetic)
+        detail::filterBankMultiArrayImpl<FloatTmpType>(source, dest, bank, opt);
+    else
+        detail::filterBankMultiArrayImpl<DefaultTmpType>(source, dest, bank, opt);
+}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_FILTERBANK_HXX
@@ -39,6 +39,9 @@
 #include "multi_array.hxx"
 #include "multi_gridgraph.hxx"
 #include "union_find.hxx"
+#include "threadpool.hxx"
+#include <utility>
+#include <vector>
 
 namespace vigra{
 
@@ -337,6 +340,494 @@ labelMultiArrayWithBackground(MultiArrayView<N, T, S1> const & data,
     return labelMultiArrayWithBackground(data, labels, neighborhood, backgroundValue, std::equal_to<T>());
 }
 
+/********************************************************/
+/*                                                      */
+/*               labelMultiArrayBlockwise               */
+/*                                                      */
+/********************************************************/
+
+/** \brief Options for \ref labelMultiArrayBlockwise() and \ref labelMultiArrayWithBackgroundBlockwise().
+
+    Besides the number of threads (inherited from \ref ParallelOptions),
+    this object holds the neighborhood type and the shape of the blocks
+    which are labeled independently.
+
+    <b>\#include</b> \<vigra/multi_labeling.hxx\><br>
+    Namespace: vigra
+*/
+template <unsigned int N>
+class BlockwiseLabelOptions
+: public ParallelOptions
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    BlockwiseLabelOptions()
+    : neighborhood_(DirectNeighborhood)
+    , block_shape_(defaultBlockShape())
+    {}
+
+        /** Connectivity of the components, <tt>DirectNeighborhood</tt> or
+            <tt>IndirectNeighborhood</tt>.
+
+            Default: <tt>DirectNeighborhood</tt>
+        */
+    BlockwiseLabelOptions & neighborhood(NeighborhoodType n)
+    {
+        neighborhood_ = n;
+        return *this;
+    }
+
+    NeighborhoodType getNeighborhood() const
+    {
+        return neighborhood_;
+    }
+
+        /** Shape of the blocks. Along each axis, a value
+            of zero or less means 'do not split this axis'.
+
+            Default: <tt>64</tt> along each axis for 3D and higher,
+            <tt>512</tt> for 2D, and <tt>65536</tt> for 1D.
+        */
+    BlockwiseLabelOptions & blockShape(Shape const & shape)
+    {
+        block_shape_ = shape;
+        return *this;
+    }
+
+    Shape const & getBlockShape() const
+    {
+        return block_shape_;
+    }
+
+        /** Set the number of threads (see \ref ParallelOptions::numThreads()).
+        */
+    BlockwiseLabelOptions & numThreads(const int n)
+    {
+        ParallelOptions::numThreads(n);
+        return *this;
+    }
+
+  private:
+    static Shape defaultBlockShape()
+    {
+        return Shape(N == 1
+                        ? 65536
+                        : N == 2
+                            ? 512
+                            : 64);
+    }
+
+    NeighborhoodType neighborhood_;
+    Shape block_shape_;
+};
+
+namespace detail {
+
+template <unsigned int N>
+struct LabelBlocking
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    LabelBlocking(Shape const & shape, Shape const & block_shape)
+    : shape_(shape)
+    , block_shape_(block_shape)
+    {
+        for(unsigned int k=0; k<N; ++k)
+        {
+            if(block_shape_[k] <= 0 || block_shape_[k] > shape_[k])
+                block_shape_[k] = shape_[k];
+            blocks_[k] = (shape_[k] + block_shape_[k] - 1) / block_shape_[k];
+        }
+    }
+
+    MultiArrayIndex size() const
+    {
+        return prod(blocks_);
+    }
+
+    void bounds(MultiArrayIndex index, Shape & start, Shape & stop) const
+    {
+        Shape block;
+        detail::ScanOrderToCoordinate<N>::exec(index, blocks_, block);
+        start = block * block_shape_;
+        stop = min(start + block_shape_, shape_);
+    }
+
+    MultiArrayIndex blockIndex(Shape const & p) const
+    {
+        return detail::CoordinateToScanOrder<N>::exec(blocks_, p / block_shape_);
+    }
+
+    Shape shape_, block_shape_, blocks_;
+};
+
+    // Pass 1: label each block independently. Block-local labels
+    // start at one (background stays zero).
+template <unsigned int N, class T, class S1, class Label, class S2, class Equal>
+class LabelBlocksTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    LabelBlocksTask(MultiArrayView<N, T, S1> const & data,
+                    MultiArrayView<N, Label, S2> const & labels,
+                    LabelBlocking<N> const & blocking,
+                    NeighborhoodType neighborhood,
+                    T const * background, Equal const & equal,
+                    ArrayVector<MultiArrayIndex> & counts)
+    : data_(data)
+    , labels_(labels)
+    , blocking_(blocking)
+    , neighborhood_(neighborhood)
+    , background_(background)
+    , equal_(equal)
+    , counts_(counts)
+    {}
+
+    void operator()(int, MultiArrayIndex b) const
+    {
+        Shape start, stop;
+        blocking_.bounds(b, start, stop);
+        MultiArrayView<N, T, StridedArrayTag> data = data_.subarray(start, stop);
+        MultiArrayView<N, Label, StridedArrayTag> labels = labels_.subarray(start, stop);
+        GridGraph<N, undirected_tag> graph(data.shape(), neighborhood_);
+        counts_[b] = background_
+                        ? lemon_graph::labelGraphWithBackground(graph, data, labels, *background_, equal_)
+                        : lemon_graph::labelGraph(graph, data, labels, equal_);
+    }
+
+  private:
+    MultiArrayView<N, T, S1> data_;
+    MultiArrayView<N, Label, S2> labels_;
+    LabelBlocking<N> const & blocking_;
+    NeighborhoodType neighborhood_;
+    T const * background_;
+    Equal equal_;
+    ArrayVector<MultiArrayIndex> & counts_;
+};
+
+    // Pass 2: collect the equivalences between labels of adjacent blocks.
+    // Every edge crossing a block border is a back arc of exactly one of its
+    // end points, and both end points lie on a face of their blocks, so it
+    // suffices to scan the back arcs of the face points.
+template <unsigned int N, class T, class S1, class Label, class S2, class Equal>
+class MergeBlockFacesTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef GridGraph<N, undirected_tag> Graph;
+    typedef std::vector<std::pair<MultiArrayIndex, MultiArrayIndex> > Pairs;
+
+    MergeBlockFacesTask(MultiArrayView<N, T, S1> const & data,
+                        MultiArrayView<N, Label, S2> const & labels,
+                        LabelBlocking<N> const & blocking,
+                        Graph const & graph,
+                        T const * background, Equal const & equal,
+                        ArrayVector<MultiArrayIndex> const & offsets,
+                        ArrayVector<Pairs> & pairs)
+    : data_(data)
+    , labels_(labels)
+    , blocking_(blocking)
+    , graph_(graph)
+    , background_(background)
+    , equal_(equal)
+    , offsets_(offsets)
+    , pairs_(pairs)
+    {}
+
+    void operator()(int, MultiArrayIndex b) const
+    {
+        Shape start, stop;
+        blocking_.bounds(b, start, stop);
+        Pairs & pairs = pairs_[b];
+
+        for(unsigned int d=0; d<N; ++d)
+        {
+            for(int side=0; side<2; ++side)
+            {
+                Shape face_start(start), face_stop(stop);
+                if(side == 0)
+                {
+                    if(start[d] == 0)
+                        continue;
+                    face_stop[d] = start[d] + 1;
+                }
+                else
+                {
+                    if(stop[d] == blocking_.shape_[d] || (stop[d] - 1 == start[d] && start[d] != 0))
+                        continue;
+                    face_start[d] = stop[d] - 1;
+                }
+
+                MultiCoordinateIterator<N> i(face_stop - face_start),
+                                           end = i.getEndIterator();
+                for(; i != end; ++i)
+                {
+                    Shape p = face_start + *i;
+                    T center = data_[p];
+                    if(background_ && equal_(center, *background_))
+                        continue;
+                    MultiArrayIndex label = offsets_[b] + labels_[p];
+                    for(typename Graph::OutBackArcIt arc(graph_, p); arc != lemon::INVALID; ++arc)
+                    {
+                        Shape q = graph_.target(*arc);
+                        MultiArrayIndex neighbor_block = blocking_.blockIndex(q);
+                        if(neighbor_block == b || !equal_(center, data_[q]))
+                            continue;
+                        std::pair<MultiArrayIndex, MultiArrayIndex>
+                            pair(label, offsets_[neighbor_block] + labels_[q]);
+                        if(pairs.empty() || pairs.back() != pair)
+                            pairs.push_back(pair);
+                    }
+                }
+            }
+        }
+    }
+
+  private:
+    MultiArrayView<N, T, S1> data_;
+    MultiArrayView<N, Label, S2> labels_;
+    LabelBlocking<N> const & blocking_;
+    Graph const & graph_;
+    T const * background_;
+    Equal equal_;
+    ArrayVector<MultiArrayIndex> const & offsets_;
+    ArrayVector<Pairs> & pairs_;
+};
+
+    // Pass 3: replace block-local labels with the final consecutive labels.
+template <unsigned int N, class Label, class S2>
+class RelabelBlocksTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    RelabelBlocksTask(MultiArrayView<N, Label, S2> const & labels,
+                      LabelBlocking<N> const & blocking,
+                      ArrayVector<MultiArrayIndex> const & offsets,
+                      UnionFindArray<MultiArrayIndex> const & regions)
+    : labels_(labels)
+    , blocking_(blocking)
+    , offsets_(offsets)
+    , regions_(regions)
+    {}
+
+    void operator()(int, MultiArrayIndex b) const
+    {
+        Shape start, stop;
+        blocking_.bounds(b, start, stop);
+        MultiArrayView<N, Label, StridedArrayTag> labels = labels_.subarray(start, stop);
+        typename MultiArrayView<N, Label, StridedArrayTag>::iterator i = labels.begin(),
+                                                                     end = labels.end();
+        for(; i != end; ++i)
+            if(*i != 0)
+                *i = (Label)regions_[offsets_[b] + *i];
+    }
+
+  private:
+    MultiArrayView<N, Label, S2> labels_;
+    LabelBlocking<N> const & blocking_;
+    ArrayVector<MultiArrayIndex> const & offsets_;
+    UnionFindArray<MultiArrayIndex> const & regions_;
+};
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2,
+          class Equal>
+Label
+labelMultiArrayBlockwiseImpl(MultiArrayView<N, T, S1> const & data,
+                             MultiArrayView<N, Label, S2> labels,
+                             BlockwiseLabelOptions<N> const & options,
+                             T const * background,
+                             Equal const & equal)
+{
+    typedef std::vector<std::pair<MultiArrayIndex, MultiArrayIndex> > Pairs;
+
+    LabelBlocking<N> blocking(data.shape(), options.getBlockShape());
+    MultiArrayIndex blocks = blocking.size();
+    ParallelOptions parallel(options.getNumThreads());
+
+    ArrayVector<MultiArrayIndex> counts(blocks);
+    LabelBlocksTask<N, T, S1, Label, S2, Equal>
+        label_task(data, labels, blocking, options.getNeighborhood(), background, equal, counts);
+    parallel_foreach(parallel, blocks, label_task);
+
+    // block b owns the global labels offsets[b]+1 ... offsets[b]+counts[b],
+    // global label 0 is the background
+    ArrayVector<MultiArrayIndex> offsets(blocks);
+    MultiArrayIndex total = 0;
+    for(MultiArrayIndex b=0; b<blocks; ++b)
+    {
+        offsets[b] = total;
+        total += counts[b];
+    }
+
+    GridGraph<N, undirected_tag> graph(data.shape(), options.getNeighborhood());
+    ArrayVector<Pairs> pairs(blocks);
+    MergeBlockFacesTask<N, T, S1, Label, S2, Equal>
+        merge_task(data, labels, blocking, graph, background, equal, offsets, pairs);
+    parallel_foreach(parallel, blocks, merge_task);
+
+    UnionFindArray<MultiArrayIndex> regions(total + 1);
+    for(MultiArrayIndex b=0; b<blocks; ++b)
+        for(std::size_t k=0; k<pairs[b].size(); ++k)
+            regions.makeUnion(pairs[b][k].first, pairs[b][k].second);
+    MultiArrayIndex count = regions.makeContiguous();
+    vigra_precondition(count <= (MultiArrayIndex)NumericTraits<Label>::max(),
+        "labelMultiArrayBlockwise(): Need more labels than can be represented in the destination type.");
+
+    RelabelBlocksTask<N, Label, S2> relabel_task(labels, blocking, offsets, regions);
+    parallel_foreach(parallel, blocks, relabel_task);
+    return (Label)count;
+}
+
+} // namespace detail
+
+/** \brief Find the connected components of a MultiArray in parallel.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+
+        template <unsigned int N, class T, class S1,
+                                  class Label, class S2,
+                  class EqualityFunctor = std::equal_to<T> >
+        Label
+        labelMultiArrayBlockwise(MultiArrayView<N, T, S1> const & data,
+                                 MultiArrayView<N, Label, S2> labels,
+                                 BlockwiseLabelOptions<N> const & options = BlockwiseLabelOptions<N>(),
+                                 EqualityFunctor equal = std::equal_to<T>());
+    }
+    \endcode
+
+    Computes the same segmentation as \ref labelMultiArray(), but splits
+    the array into blocks of <tt>options.getBlockShape()</tt> which are labeled
+    concurrently with <tt>options.getNumThreads()</tt> threads. The block
+    labelings are then stitched together by scanning the block faces for
+    equivalent labels and resolving them in a global union-find array.
+    Finally, all blocks are relabeled in parallel such that the region numbers
+    form a consecutive sequence starting at one. The numbering may differ
+    from the one produced by \ref labelMultiArray(), since regions are
+    numbered in the order of the blocks.
+
+    Intermediate labels are block-local, so the label type must be able to
+    represent the number of regions in a single block, and the final number
+    of regions.
+
+    Return:  the number of regions found (= highest region label)
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_labeling.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, int> src(Shape3(w,h,d));
+    MultiArray<3, UInt32> dest(Shape3(w,h,d));
+
+    // find 26-connected regions with 4 threads and 128^3 blocks
+    UInt32 max_region_label =
+        labelMultiArrayBlockwise(src, dest,
+                                 BlockwiseLabelOptions<3>().neighborhood(IndirectNeighborhood)
+                                                           .blockShape(Shape3(128))
+                                                           .numThreads(4));
+    \endcode
+*/
+doxygen_overloaded_function(template <...> unsigned int labelMultiArrayBlockwise)
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2,
+          class Equal>
+inline Label
+labelMultiArrayBlockwise(MultiArrayView<N, T, S1> const & data,
+                         MultiArrayView<N, Label, S2> labels,
+                         BlockwiseLabelOptions<N> const & options,
+                         Equal equal)
+{
+    vigra_precondition(data.shape() == labels.shape(),
+        "labelMultiArrayBlockwise(): shape mismatch between input and output.");
+    return detail::labelMultiArrayBlockwiseImpl(data, labels, options, (T const *)0, equal);
+}
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2>
+inline Label
+labelMultiArrayBlockwise(MultiArrayView<N, T, S1> const & data,
+                         MultiArrayView<N, Label, S2> labels,
+                         BlockwiseLabelOptions<N> const & options = BlockwiseLabelOptions<N>())
+{
+    return labelMultiArrayBlockwise(data, labels, options, std::equal_to<T>());
+}
+
+/** \brief Find the connected components of a MultiArray in parallel,
+     excluding the background from labeling.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+
+        template <unsigned int N, class T, class S1,
+                                  class Label, class S2,
+                  class EqualityFunctor = std::equal_to<T> >
+        Label
+        labelMultiArrayWithBackgroundBlockwise(MultiArrayView<N, T, S1> const & data,
+                                               MultiArrayView<N, Label, S2> labels,
+                                               BlockwiseLabelOptions<N> const & options = BlockwiseLabelOptions<N>(),
+                                               T backgroundValue = T(),
+                                               EqualityFunctor equal = std::equal_to<T>());
+    }
+    \endcode
+
+    This function is the same as \ref labelMultiArrayBlockwise(), except
+    that points with value \a backgroundValue are ignored and get label zero,
+    as in \ref labelMultiArrayWithBackground().
+
+    Return: the number of non-background regions found
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_labeling.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, int> src(Shape3(w,h,d));
+    MultiArray<3, UInt32> dest(Shape3(w,h,d));
+
+    // find 6-connected regions, ignoring background value zero
+    UInt32 max_region_label = labelMultiArrayWithBackgroundBlockwise(src, dest);
+    \endcode
+*/
+doxygen_overloaded_function(template <...> unsigned int labelMultiArrayWithBackgroundBlockwise)
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2,
+          class Equal>
+inline Label
+labelMultiArrayWithBackgroundBlockwise(MultiArrayView<N, T, S1> const & data,
+                                       MultiArrayView<N, Label, S2> labels,
+                                       BlockwiseLabelOptions<N> const & options,
+                                       T backgroundValue,
+                                       Equal equal)
+{
+    vigra_precondition(data.shape() == labels.shape(),
+        "labelMultiArrayWithBackgroundBlockwise(): shape mismatch between input and output.");
+    return detail::labelMultiArrayBlockwiseImpl(data, labels, options, &backgroundValue, equal);
+}
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2>
+inline Label
+labelMultiArrayWithBackgroundBlockwise(MultiArrayView<N, T, S1> const & data,
+                                       MultiArrayView<N, Label, S2> labels,
+                                       BlockwiseLabelOptions<N> const & options = BlockwiseLabelOptions<N>(),
+                                       T backgroundValue = T())
+{
+    return labelMultiArrayWithBackgroundBlockwise(data, labels, options, backgroundValue, std::equal_to<T>());
+}
+
 //@}
 
 } // namespace vigra
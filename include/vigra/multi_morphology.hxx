@@ -48,6 +48,7 @@
 #include "metaprogramming.hxx"
 #include "multi_pointoperators.hxx"
 #include "functorexpression.hxx"
+#include "multi_bit_array.hxx"
 
 namespace vigra
 {
@@ -131,6 +132,359 @@ struct MultiBinaryMorphologyImpl<bool, bool>
     }
 };
 
+struct MorphologyMinimum
+{
+    template <class T>
+    T operator()(T const & a, T const & b) const
+    {
+        return b < a ? b : a;
+    }
+};
+
+struct MorphologyMaximum
+{
+    template <class T>
+    T operator()(T const & a, T const & b) const
+    {
+        return a < b ? b : a;
+    }
+};
+
+    // Flat erosion or dilation of lines with a window of size w = 2*radius+1
+    // by the van Herk/Gil-Werman algorithm. The line (padded by 'radius'
+    // neutral elements on either side) is split into blocks of length w;
+    // g holds the running minima (resp. maxima) from the start of each block,
+    // h those from the end of each block. Every window [x, x+w) of the padded
+    // line covers exactly one block boundary, so that its result is
+    // best(h[x], g[x+w-1]), i.e. three comparisons per element, independent of w.
+    // Padding with the neutral element clips the window at the line ends.
+    // The lines are given as panels (see transformMultiArrayLines()).
+template <class T, class Best>
+class VanHerkGilWermanFunctor
+{
+  public:
+    VanHerkGilWermanFunctor(MultiArrayIndex radius, T neutral)
+    : radius_(radius),
+      neutral_(neutral)
+    {}
+
+    void operator()(T * in, T * out, MultiArrayIndex n, int panelWidth, int pw) const
+    {
+        MultiArrayIndex w = 2*radius_ + 1,
+                        blocks = (n + 2*radius_ + w - 1) / w,
+                        size = blocks*w*panelWidth;
+        if(g_.size() < (std::size_t)size)
+        {
+            g_.resize(size);
+            h_.resize(size);
+        }
+        if(neutralLine_.size() < (std::size_t)panelWidth)
+            neutralLine_.resize(panelWidth, neutral_);
+
+        T * g = g_.begin(),
+          * h = h_.begin();
+        for(MultiArrayIndex j0 = 0; j0 < blocks*w; j0 += w)
+        {
+            T const * v = value(in, n, j0, panelWidth);
+            for(int p = 0; p < pw; ++p)
+                g[j0*panelWidth + p] = v[p];
+            for(MultiArrayIndex j = j0 + 1; j < j0 + w; ++j)
+            {
+                T * gj = g + j*panelWidth;
+                v = value(in, n, j, panelWidth);
+                for(int p = 0; p < pw; ++p)
+                    gj[p] = best_(gj[p - panelWidth], v[p]);
+            }
+
+            v = value(in, n, j0 + w - 1, panelWidth);
+            for(int p = 0; p < pw; ++p)
+                h[(j0 + w - 1)*panelWidth + p] = v[p];
+            for(MultiArrayIndex j = j0 + w - 2; j >= j0; --j)
+            {
+                T * hj = h + j*panelWidth;
+                v = value(in, n, j, panelWidth);
+                for(int p = 0; p < pw; ++p)
+                    hj[p] = best_(hj[p + panelWidth], v[p]);
+            }
+        }
+
+        for(MultiArrayIndex x = 0; x < n; ++x)
+        {
+            T const * hx = h + x*panelWidth,
+                    * gx = g + (x + w - 1)*panelWidth;
+            T * o = out + x*panelWidth;
+            for(int p = 0; p < pw; ++p)
+                o[p] = best_(hx[p], gx[p]);
+        }
+    }
+
+  private:
+        // element j of the padded line
+    T const * value(T const * in, MultiArrayIndex n, MultiArrayIndex j, int panelWidth) const
+    {
+        return j >= radius_ && j < radius_ + n
+                   ? in + (j - radius_)*panelWidth
+                   : neutralLine_.begin();
+    }
+
+    MultiArrayIndex radius_;
+    T neutral_;
+    Best best_;
+    mutable ArrayVector<T> g_, h_, neutralLine_;
+};
+
+    // Apply 'f' (with the signature of transformMultiArrayLines()) to all lines
+    // of points {p + k*step} of the array. Lines along a coordinate axis are
+    // delegated to transformMultiArrayLines(), other directions are processed
+    // one line at a time.
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Functor>
+void
+transformMultiArrayAlongDirection(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> dest,
+                                  typename MultiArrayShape<N>::type const & step,
+                                  Functor const & f)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    int nonzero = 0, axis = 0;
+    for(unsigned int k=0; k<N; ++k)
+    {
+        if(step[k] != 0)
+        {
+            ++nonzero;
+            axis = k;
+        }
+    }
+    vigra_precondition(nonzero > 0,
+        "transformMultiArrayAlongDirection(): direction must be non-zero.");
+    if(nonzero == 1 && (step[axis] == 1 || step[axis] == -1))
+    {
+        transformMultiArrayLines(source, dest, axis, f);
+        return;
+    }
+
+    Shape shape(source.shape());
+    ArrayVector<T2> in, out;
+    ArrayVector<Shape> points;
+    MultiCoordinateIterator<N> i(shape), end = i.getEndIterator();
+    for(; i != end; ++i)
+    {
+        // each line starts at the point whose predecessor is outside the array
+        Shape p(*i - step);
+        bool isStart = false;
+        for(unsigned int k=0; k<N; ++k)
+            isStart = isStart || p[k] < 0 || p[k] >= shape[k];
+        if(!isStart)
+            continue;
+
+        points.clear();
+        in.clear();
+        for(p = *i; ; p += step)
+        {
+            bool inside = true;
+            for(unsigned int k=0; k<N; ++k)
+                inside = inside && p[k] >= 0 && p[k] < shape[k];
+            if(!inside)
+                break;
+            points.push_back(p);
+            in.push_back(detail::RequiresExplicitCast<T2>::cast(source[p]));
+        }
+        out.resize(in.size());
+        f(in.begin(), out.begin(), in.size(), 1, 1);
+        for(unsigned int k=0; k<points.size(); ++k)
+            dest[points[k]] = out[k];
+    }
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Best>
+void
+multiGrayscaleBoxMorphology(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, T2, S2> dest,
+                            typename MultiArrayShape<N>::type const & radius,
+                            T2 neutral, Best, const char * function_name)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        std::string(function_name) + "(): shape mismatch between input and output.");
+    vigra_precondition(radius.minimum() >= 0,
+        std::string(function_name) + "(): radius must be non-negative.");
+
+    transformMultiArrayLines(source, dest, 0,
+                             VanHerkGilWermanFunctor<T2, Best>(radius[0], neutral));
+    for(unsigned int d=1; d<N; ++d)
+        if(radius[d] > 0)
+            transformMultiArrayLines(dest, dest, d,
+                                     VanHerkGilWermanFunctor<T2, Best>(radius[d], neutral));
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Best>
+void
+multiGrayscaleLineMorphology(MultiArrayView<N, T1, S1> const & source,
+                             MultiArrayView<N, T2, S2> dest,
+                             typename MultiArrayShape<N>::type const & direction,
+                             MultiArrayIndex radius,
+                             T2 neutral, Best, const char * function_name)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        std::string(function_name) + "(): shape mismatch between input and output.");
+    vigra_precondition(radius >= 0,
+        std::string(function_name) + "(): radius must be non-negative.");
+    vigra_precondition(direction != typename MultiArrayShape<N>::type(),
+        std::string(function_name) + "(): direction must be non-zero.");
+
+    transformMultiArrayAlongDirection(source, dest, direction,
+                                      VanHerkGilWermanFunctor<T2, Best>(radius, neutral));
+}
+
+struct MorphologyBitAnd
+{
+    UInt64 operator()(UInt64 a, UInt64 b) const
+    {
+        return a & b;
+    }
+};
+
+struct MorphologyBitOr
+{
+    UInt64 operator()(UInt64 a, UInt64 b) const
+    {
+        return a | b;
+    }
+};
+
+    // Flat binary erosion or dilation of the bit lines of a MultiBitArray
+    // along dimension 0. The window [-c, c] grows to [-(2c+1), 2c+1] in each
+    // step by combining the line with copies of itself shifted by c+1 bits in
+    // either direction, so that a radius r takes O(log r) word operations per
+    // 64 elements. Bits outside the line (including the padding bits of the
+    // last word) are neutral, i.e. 1 for erosion and 0 for dilation.
+class BitLineMorphologyFunctor
+{
+  public:
+    BitLineMorphologyFunctor(MultiArrayIndex radius, UInt64 lastMask, bool dilation)
+    : radius_(radius),
+      last_mask_(lastMask),
+      dilation_(dilation)
+    {}
+
+    void operator()(UInt64 * in, UInt64 * out, MultiArrayIndex n, int, int) const
+    {
+        if(cur_.size() < (std::size_t)n)
+        {
+            cur_.resize(n);
+            up_.resize(n);
+            down_.resize(n);
+        }
+        UInt64 * cur = cur_.begin(),
+               * up = up_.begin(),
+               * down = down_.begin();
+        std::copy(in, in + n, cur);
+        if(!dilation_)
+            cur[n-1] |= ~last_mask_;
+
+        for(MultiArrayIndex c = 0; c < radius_; )
+        {
+            MultiArrayIndex s = std::min(c + 1, radius_ - c);
+            shiftBitLine(cur, up, n, s, !dilation_);
+            shiftBitLine(cur, down, n, -s, !dilation_);
+            if(dilation_)
+                for(MultiArrayIndex w = 0; w < n; ++w)
+                    cur[w] |= up[w] | down[w];
+            else
+                for(MultiArrayIndex w = 0; w < n; ++w)
+                    cur[w] &= up[w] & down[w];
+            c += s;
+        }
+
+        std::copy(cur, cur + n, out);
+        out[n-1] &= last_mask_;
+    }
+
+  private:
+    MultiArrayIndex radius_;
+    UInt64 last_mask_;
+    bool dilation_;
+    mutable ArrayVector<UInt64> cur_, up_, down_;
+};
+
+template <unsigned int N>
+void
+multiBinaryBoxMorphology(MultiBitArray<N> const & source,
+                         MultiBitArray<N> & dest,
+                         typename MultiArrayShape<N>::type const & radius,
+                         bool dilation, const char * function_name)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        std::string(function_name) + "(): shape mismatch between input and output.");
+    vigra_precondition(radius.minimum() >= 0,
+        std::string(function_name) + "(): radius must be non-negative.");
+
+    transformMultiArrayLines(source.words(), dest.words(), 0,
+                             BitLineMorphologyFunctor(radius[0], source.lastWordMask(), dilation));
+    // along the other dimensions, each word holds 64 independent lines
+    for(unsigned int d=1; d<N; ++d)
+    {
+        if(radius[d] == 0)
+            continue;
+        if(dilation)
+            transformMultiArrayLines(dest.words(), dest.words(), d,
+                  VanHerkGilWermanFunctor<UInt64, MorphologyBitOr>(radius[d], UInt64(0)));
+        else
+            transformMultiArrayLines(dest.words(), dest.words(), d,
+                  VanHerkGilWermanFunctor<UInt64, MorphologyBitAnd>(radius[d], ~UInt64(0)));
+    }
+}
+
+    // dest &= source shifted by -offset (resp. its complement), where
+    // elements outside of 'source' count as 0.
+template <unsigned int N>
+void
+andShiftedBits(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+               typename MultiArrayShape<N>::type const & offset, bool complement)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    typename MultiBitArray<N>::word_array_type const & words = source.words();
+    MultiArrayIndex n = words.shape(0);
+    Shape rows(words.shape());
+    rows[0] = 1;
+    MultiArrayIndex rowCount = prod(rows);
+    ArrayVector<UInt64> line(n);
+
+    for(MultiArrayIndex r = 0; r < rowCount; ++r)
+    {
+        Shape row;
+        detail::ScanOrderToCoordinate<N>::exec(r, rows, row);
+        UInt64 * d = &dest.words()[row];
+
+        Shape from(row + offset);
+        from[0] = 0;
+        bool inside = true;
+        for(unsigned int k=1; k<N; ++k)
+            inside = inside && from[k] >= 0 && from[k] < rows[k];
+        if(!inside)
+        {
+            if(!complement)
+                std::fill(d, d + n, UInt64(0));
+            continue;
+        }
+
+        shiftBitLine(&words[from], line.begin(), n, -offset[0], false);
+        if(complement)
+            for(MultiArrayIndex w = 0; w < n; ++w)
+                d[w] &= ~line[w];
+        else
+            for(MultiArrayIndex w = 0; w < n; ++w)
+                d[w] &= line[w];
+        d[n-1] &= source.lastWordMask();
+    }
+}
+
 } // namespace detail
 
 /** \addtogroup MultiArrayMorphology Morphological operators for multi-dimensional arrays.
@@ -678,6 +1032,448 @@ multiGrayscaleDilation(MultiArrayView<N, T1, S1> const & source,
                             destMultiArray(dest), sigma);
 }
 
+/********************************************************/
+/*                                                      */
+/*               multiGrayscaleBoxErosion               */
+/*                                                      */
+/********************************************************/
+/** \brief Flat grayscale erosion, dilation, opening and closing with a box.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiGrayscaleBoxErosion(MultiArrayView<N, T1, S1> const & source,
+                                 MultiArrayView<N, T2, S2> dest,
+                                 typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiGrayscaleBoxDilation(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> dest,
+                                  typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiGrayscaleBoxOpening(MultiArrayView<N, T1, S1> const & source,
+                                 MultiArrayView<N, T2, S2> dest,
+                                 typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiGrayscaleBoxClosing(MultiArrayView<N, T1, S1> const & source,
+                                 MultiArrayView<N, T2, S2> dest,
+                                 typename MultiArrayShape<N>::type const & radius);
+    }
+    \endcode
+
+    The structuring element is the box <tt>[-radius, radius]</tt>, i.e. it has size
+    <tt>2*radius[k]+1</tt> along dimension <tt>k</tt>. Each function is also available
+    with a scalar <tt>radius</tt>, which is then used for all dimensions. Erosion
+    (dilation) computes the minimum (maximum) over the box around each element,
+    where the box is clipped at the array border. Opening is erosion followed by
+    dilation, closing the reverse.
+
+    Since the box is separable, the operations are applied along each dimension in turn,
+    using the van Herk/Gil-Werman algorithm: it requires three comparisons per element,
+    regardless of the size of the box. The computations are done in the value type of
+    <tt>dest</tt>. The functions may work in-place (<tt>source</tt> and <tt>dest</tt>
+    referring to the same data).
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt16> volume(Shape3(width, height, depth)),
+                          background(volume.shape());
+    ...
+    // background subtraction by a top-hat with a 31x31x31 box
+    multiGrayscaleBoxOpening(volume, background, 15);
+    volume -= background;
+    \endcode
+
+    \see multiGrayscaleLineErosion(), multiGrayscaleErosion(), vigra::discErosion()
+*/
+doxygen_overloaded_function(template <...> void multiGrayscaleBoxErosion)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxErosion(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & radius)
+{
+    detail::multiGrayscaleBoxMorphology(source, dest, radius, NumericTraits<T2>::max(),
+                                        detail::MorphologyMinimum(), "multiGrayscaleBoxErosion");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxErosion(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         MultiArrayIndex radius)
+{
+    multiGrayscaleBoxErosion(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void multiGrayscaleBoxDilation)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxDilation(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest,
+                          typename MultiArrayShape<N>::type const & radius)
+{
+    detail::multiGrayscaleBoxMorphology(source, dest, radius, NumericTraits<T2>::min(),
+                                        detail::MorphologyMaximum(), "multiGrayscaleBoxDilation");
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxDilation(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest,
+                          MultiArrayIndex radius)
+{
+    multiGrayscaleBoxDilation(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void multiGrayscaleBoxOpening)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxOpening(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & radius)
+{
+    multiGrayscaleBoxErosion(source, dest, radius);
+    multiGrayscaleBoxDilation(dest, dest, radius);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxOpening(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         MultiArrayIndex radius)
+{
+    multiGrayscaleBoxOpening(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void multiGrayscaleBoxClosing)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxClosing(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & radius)
+{
+    multiGrayscaleBoxDilation(source, dest, radius);
+    multiGrayscaleBoxErosion(dest, dest, radius);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleBoxClosing(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         MultiArrayIndex radius)
+{
+    multiGrayscaleBoxClosing(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+/********************************************************/
+/*                                                      */
+/*              multiGrayscaleLineErosion               */
+/*                                                      */
+/********************************************************/
+/** \brief Flat grayscale erosion and dilation with a line segment.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiGrayscaleLineErosion(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> dest,
+                                  typename MultiArrayShape<N>::type const & direction,
+                                  MultiArrayIndex radius);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiGrayscaleLineDilation(MultiArrayView<N, T1, S1> const & source,
+                                   MultiArrayView<N, T2, S2> dest,
+                                   typename MultiArrayShape<N>::type const & direction,
+                                   MultiArrayIndex radius);
+    }
+    \endcode
+
+    The structuring element consists of the <tt>2*radius+1</tt> points
+    <tt>k*direction</tt> with <tt>-radius <= k <= radius</tt>. For example,
+    <tt>direction = Shape3(1,0,0)</tt> gives a line along the x-axis, and
+    <tt>Shape3(1,1,0)</tt> a diagonal line in the x-y-plane. When
+    <tt>direction</tt> has components larger than 1, the line has gaps
+    (a "periodic line"). Erosion (dilation) computes the minimum (maximum) over
+    the line around each element, where the line is clipped at the array border.
+
+    The van Herk/Gil-Werman algorithm is applied along the discrete lines
+    <tt>{p + k*direction}</tt> of the array, requiring three comparisons per element
+    regardless of <tt>radius</tt>. Lines along a coordinate axis are processed
+    most efficiently. The computations are done in the value type of <tt>dest</tt>.
+    The functions may work in-place.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, float> image(Shape2(width, height)), eroded(image.shape());
+    ...
+    // erosion with a diagonal line of 21 pixels
+    multiGrayscaleLineErosion(image, eroded, Shape2(1, 1), 10);
+    \endcode
+
+    \see multiGrayscaleBoxErosion()
+*/
+doxygen_overloaded_function(template <...> void multiGrayscaleLineErosion)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleLineErosion(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest,
+                          typename MultiArrayShape<N>::type const & direction,
+                          MultiArrayIndex radius)
+{
+    detail::multiGrayscaleLineMorphology(source, dest, direction, radius, NumericTraits<T2>::max(),
+                                         detail::MorphologyMinimum(), "multiGrayscaleLineErosion");
+}
+
+doxygen_overloaded_function(template <...> void multiGrayscaleLineDilation)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiGrayscaleLineDilation(MultiArrayView<N, T1, S1> const & source,
+                           MultiArrayView<N, T2, S2> dest,
+                           typename MultiArrayShape<N>::type const & direction,
+                           MultiArrayIndex radius)
+{
+    detail::multiGrayscaleLineMorphology(source, dest, direction, radius, NumericTraits<T2>::min(),
+                                         detail::MorphologyMaximum(), "multiGrayscaleLineDilation");
+}
+
+/********************************************************/
+/*                                                      */
+/*                multiBinaryBoxErosion                 */
+/*                                                      */
+/********************************************************/
+/** \brief Binary erosion, dilation, opening and closing with a box on bit-packed arrays.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N>
+        void
+        multiBinaryBoxErosion(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                              typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N>
+        void
+        multiBinaryBoxDilation(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                               typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N>
+        void
+        multiBinaryBoxOpening(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                              typename MultiArrayShape<N>::type const & radius);
+
+        template <unsigned int N>
+        void
+        multiBinaryBoxClosing(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                              typename MultiArrayShape<N>::type const & radius);
+    }
+    \endcode
+
+    These are the binary counterparts of \ref multiGrayscaleBoxErosion() and friends:
+    the structuring element is the box <tt>[-radius, radius]</tt>, which is clipped
+    at the array border. Each function is also available with a scalar <tt>radius</tt>.
+
+    The arrays are stored as \ref vigra::MultiBitArray, and all operations work on
+    64 elements at a time: along dimension 0, the box is built from O(log radius)
+    shifted copies of each bit line, along the other dimensions each word is
+    processed by the van Herk/Gil-Werman algorithm (three bitwise operations per word,
+    regardless of the radius). The functions may work in-place.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt8> mask(Shape3(width, height, depth));
+    ...
+    MultiBitArray<3> bits(mask);
+    // remove structures thinner than 5 voxels
+    multiBinaryBoxOpening(bits, bits, 2);
+    bits.unpack(mask);
+    \endcode
+
+    \see multiBinaryErosion(), multiBinaryHitOrMiss()
+*/
+doxygen_overloaded_function(template <...> void multiBinaryBoxErosion)
+
+template <unsigned int N>
+inline void
+multiBinaryBoxErosion(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                      typename MultiArrayShape<N>::type const & radius)
+{
+    detail::multiBinaryBoxMorphology(source, dest, radius, false, "multiBinaryBoxErosion");
+}
+
+template <unsigned int N>
+inline void
+multiBinaryBoxErosion(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                      MultiArrayIndex radius)
+{
+    multiBinaryBoxErosion(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void multiBinaryBoxDilation)
+
+template <unsigned int N>
+inline void
+multiBinaryBoxDilation(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                       typename MultiArrayShape<N>::type const & radius)
+{
+    detail::multiBinaryBoxMorphology(source, dest, radius, true, "multiBinaryBoxDilation");
+}
+
+template <unsigned int N>
+inline void
+multiBinaryBoxDilation(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                       MultiArrayIndex radius)
+{
+    multiBinaryBoxDilation(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void multiBinaryBoxOpening)
+
+template <unsigned int N>
+inline void
+multiBinaryBoxOpening(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                      typename MultiArrayShape<N>::type const & radius)
+{
+    multiBinaryBoxErosion(source, dest, radius);
+    multiBinaryBoxDilation(dest, dest, radius);
+}
+
+template <unsigned int N>
+inline void
+multiBinaryBoxOpening(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                      MultiArrayIndex radius)
+{
+    multiBinaryBoxOpening(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+doxygen_overloaded_function(template <...> void multiBinaryBoxClosing)
+
+template <unsigned int N>
+inline void
+multiBinaryBoxClosing(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                      typename MultiArrayShape<N>::type const & radius)
+{
+    multiBinaryBoxDilation(source, dest, radius);
+    multiBinaryBoxErosion(dest, dest, radius);
+}
+
+template <unsigned int N>
+inline void
+multiBinaryBoxClosing(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                      MultiArrayIndex radius)
+{
+    multiBinaryBoxClosing(source, dest, typename MultiArrayShape<N>::type(radius));
+}
+
+/********************************************************/
+/*                                                      */
+/*                 multiBinaryHitOrMiss                 */
+/*                                                      */
+/********************************************************/
+/** \brief Hit-or-miss transform on bit-packed arrays.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N>
+        void
+        multiBinaryHitOrMiss(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                             ArrayVector<typename MultiArrayShape<N>::type> const & hits,
+                             ArrayVector<typename MultiArrayShape<N>::type> const & misses);
+    }
+    \endcode
+
+    An element <tt>p</tt> of <tt>dest</tt> is set if and only if <tt>source[p + h]</tt>
+    is set for all offsets <tt>h</tt> in <tt>hits</tt>, and <tt>source[p + m]</tt>
+    is not set for all offsets <tt>m</tt> in <tt>misses</tt>. Elements outside of
+    <tt>source</tt> count as not set. Each offset is applied to 64 elements at a time.
+    The function may work in-place.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiBitArray<2> bits(mask), isolated(mask.shape());
+
+    // find isolated pixels (no foreground in the 4-neighborhood)
+    ArrayVector<Shape2> hits, misses;
+    hits.push_back(Shape2(0, 0));
+    misses.push_back(Shape2(-1, 0));
+    misses.push_back(Shape2(1, 0));
+    misses.push_back(Shape2(0, -1));
+    misses.push_back(Shape2(0, 1));
+    multiBinaryHitOrMiss(bits, isolated, hits, misses);
+    \endcode
+
+    \see multiBinaryBoxErosion()
+*/
+template <unsigned int N>
+void
+multiBinaryHitOrMiss(MultiBitArray<N> const & source, MultiBitArray<N> & dest,
+                     ArrayVector<typename MultiArrayShape<N>::type> const & hits,
+                     ArrayVector<typename MultiArrayShape<N>::type> const & misses)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBinaryHitOrMiss(): shape mismatch between input and output.");
+
+    MultiBitArray<N> res(source.shape(), true);
+    for(unsigned int k=0; k<hits.size(); ++k)
+        detail::andShiftedBits(source, res, hits[k], false);
+    for(unsigned int k=0; k<misses.size(); ++k)
+        detail::andShiftedBits(source, res, misses[k], true);
+    dest.swap(res);
+}
+
 //@}
 
 } //-- namespace vigra
@@ -2024,6 +2024,73 @@ inspectTwoMultiArrays(MultiArrayView<N, T1, S1> const & s1,
     
 //@}
 
+namespace detail {
+
+    // Apply 'f' to all lines of 'source' along 'axis' and write the results to the
+    // corresponding lines of 'dest' (which may be identical to 'source'). When
+    // the lines are strided in memory (axis > 0), they are processed in panels of
+    // up to 64 adjacent lines which are copied into a buffer of the destination's
+    // value type, such that position k of line p is at buffer[k*panelWidth + p]
+    // and all memory accesses have unit stride. 'f' is called as
+    // f(in, out, lineLength, panelWidth, linesInPanel), receives the panel in
+    // 'in' (which it may overwrite) and writes the results to 'out'.
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Functor>
+void
+transformMultiArrayLines(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         unsigned int axis, Functor const & f)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    vigra_precondition(source.shape() == dest.shape(),
+        "transformMultiArrayLines(): shape mismatch between input and output.");
+    if(source.size() == 0)
+        return;
+
+    MultiArrayIndex n = source.shape(axis),
+                    panelLength = axis == 0 ? 1 : source.shape(0);
+    int panelWidth = axis == 0 ? 1 : 64;
+    ArrayVector<T2> in(n*panelWidth), out(n*panelWidth);
+
+    Shape rows(source.shape());
+    rows[0] = 1;
+    rows[axis] = 1;
+    MultiArrayIndex rowCount = prod(rows);
+
+    for(MultiArrayIndex r = 0; r < rowCount; ++r)
+    {
+        Shape row;
+        detail::ScanOrderToCoordinate<N>::exec(r, rows, row);
+        T1 const * s = &source[row];
+        T2 * d = &dest[row];
+
+        for(MultiArrayIndex p0 = 0; p0 < panelLength; p0 += panelWidth)
+        {
+            int pw = (int)std::min<MultiArrayIndex>(panelWidth, panelLength - p0);
+
+            for(MultiArrayIndex k = 0; k < n; ++k)
+            {
+                T1 const * sk = s + p0*source.stride(0) + k*source.stride(axis);
+                for(int p = 0; p < pw; ++p)
+                    in[k*panelWidth + p] = detail::RequiresExplicitCast<T2>::cast(sk[p*source.stride(0)]);
+            }
+
+            f(in.begin(), out.begin(), n, panelWidth, pw);
+
+            for(MultiArrayIndex k = 0; k < n; ++k)
+            {
+                T2 * dk = d + p0*dest.stride(0) + k*dest.stride(axis);
+                for(int p = 0; p < pw; ++p)
+                    dk[p*dest.stride(0)] = out[k*panelWidth + p];
+            }
+        }
+    }
+}
+
+} // namespace detail
+
 }  //-- namespace vigra
 
 
@@ -0,0 +1,464 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_RANK_FILTER_HXX
+#define VIGRA_MULTI_RANK_FILTER_HXX
+
+#include <algorithm>
+#include <cmath>
+#include "multi_array.hxx"
+#include "array_vector.hxx"
+#include "sized_int.hxx"
+
+namespace vigra {
+
+namespace detail {
+
+    // Histogram layout of the rank filters: the bins are grouped into
+    // coarse bins of 2^fineBits fine bins each. Only the listed
+    // types are supported.
+template <class T>
+struct RankFilterHistogram;
+
+template <>
+struct RankFilterHistogram<UInt8>
+{
+    enum { fineBits = 4, binCount = 256 };
+};
+
+template <>
+struct RankFilterHistogram<UInt16>
+{
+    enum { fineBits = 8, binCount = 65536 };
+};
+
+    // Address range [first, last) occupied by the elements of 'a'. Strides
+    // may be negative, so the extreme elements are not necessarily the first
+    // and last element in scan order.
+template <unsigned int N, class T, class S>
+void
+rankFilterMemoryRange(MultiArrayView<N, T, S> const & a, char const * & first, char const * & last)
+{
+    MultiArrayIndex low = 0, high = 0;
+    for(unsigned int k = 0; k < N; ++k)
+    {
+        MultiArrayIndex d = (a.shape(k) - 1)*a.stride(k);
+        if(d < 0)
+            low += d;
+        else
+            high += d;
+    }
+    first = (char const *)(a.data() + low);
+    last  = (char const *)(a.data() + high + 1);
+}
+
+    // Add the elements of a row (resp. its cross section given by 'offsets')
+    // to the column histograms, or remove them.
+template <class T>
+void
+rankFilterUpdateColumns(T const * row, MultiArrayIndex stride, MultiArrayIndex columnCount,
+                        ArrayVector<MultiArrayIndex> const & offsets,
+                        UInt32 * fine, UInt32 * coarse, bool add)
+{
+    const int fineBits = RankFilterHistogram<T>::fineBits,
+              binCount = RankFilterHistogram<T>::binCount,
+              coarseCount = binCount >> fineBits;
+    UInt32 inc = add ? 1 : UInt32(-1);
+    for(unsigned int k = 0; k < offsets.size(); ++k)
+    {
+        T const * p = row + offsets[k];
+        for(MultiArrayIndex c = 0; c < columnCount; ++c, p += stride)
+        {
+            fine[c*binCount + *p] += inc;
+            coarse[c*coarseCount + (*p >> fineBits)] += inc;
+        }
+    }
+}
+
+    // Constant-time rank filter with a box window after
+    // S. Perreault and P. Hebert: "Median Filtering in Constant Time",
+    // IEEE Trans. Image Processing 16(9), 2007.
+    //
+    // Every "column" x holds the histogram of the elements with this x
+    // inside the window in dimensions 1...N-1. When the window moves to the
+    // next row, one row of elements is added to and removed from each column.
+    // The window histogram is the sum of 2*radius[0]+1 column histograms and is
+    // moved along the row by adding one column and subtracting another. To
+    // make this cheap, only the coarse window histogram is updated
+    // at every step, and the fine bins of a coarse bin are brought up to date
+    // when the search for the rank reaches that coarse bin.
+    //
+    // Since the column histograms of 16-bit data are large, the array is
+    // processed in vertical strips, so that only the columns of one strip
+    // must be kept in memory.
+template <unsigned int N>
+struct MultiRankOrderFilterImpl
+{
+    template <class T1, class S1, class T2, class S2>
+    static void
+    exec(MultiArrayView<N, T1, S1> const & src,
+         MultiArrayView<N, T2, S2> dest,
+         typename MultiArrayShape<N>::type const & radius, double rank)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+        typedef RankFilterHistogram<T1> Histogram;
+
+        const int fineBits = Histogram::fineBits,
+                  fineCount = 1 << fineBits,
+                  binCount = Histogram::binCount,
+                  coarseCount = binCount >> fineBits;
+
+        Shape shape(src.shape());
+        if(prod(shape) == 0)
+            return;
+        MultiArrayIndex w = shape[0], h = shape[1],
+                        r0 = radius[0], r1 = radius[1],
+                        s0 = src.stride(0), s1 = src.stride(1);
+
+        MultiArrayIndex stripWidth = binCount <= 256
+                                         ? w
+                                         : std::max<MultiArrayIndex>(64, 2*r0 + 1),
+                        maxColumns = std::min(w, stripWidth + 2*r0);
+        ArrayVector<UInt32> columnFine(maxColumns*binCount),
+                            columnCoarse(maxColumns*coarseCount),
+                            fine(binCount), coarse(coarseCount);
+        ArrayVector<MultiArrayIndex> fineX(coarseCount), boxOffsets;
+
+        Shape planes(shape);
+        planes[0] = 1;
+        planes[1] = 1;
+        MultiArrayIndex planeCount = prod(planes);
+
+        for(MultiArrayIndex pl = 0; pl < planeCount; ++pl)
+        {
+            Shape plane;
+            detail::ScanOrderToCoordinate<N>::exec(pl, planes, plane);
+
+            // memory offsets of the window in dimensions 2...N-1, clipped at the border
+            Shape boxStart(plane - radius), boxStop(plane + radius + Shape(1));
+            boxStart[0] = boxStart[1] = 0;
+            boxStop[0] = boxStop[1] = 1;
+            boxStart = max(boxStart, Shape());
+            boxStop = min(boxStop, planes);
+            boxOffsets.clear();
+            MultiCoordinateIterator<N> b(boxStop - boxStart), bend = b.getEndIterator();
+            for(; b != bend; ++b)
+                boxOffsets.push_back(dot(boxStart + *b, src.stride()));
+
+            T1 const * planeStart = src.data();
+            T2 * destPlane = &dest[plane];
+
+            for(MultiArrayIndex x0 = 0; x0 < w; x0 += stripWidth)
+            {
+                MultiArrayIndex x1 = std::min(w, x0 + stripWidth),
+                                columnStart = std::max<MultiArrayIndex>(0, x0 - r0),
+                                columnCount = std::min(w, x1 + r0) - columnStart;
+
+                std::fill(columnFine.begin(), columnFine.begin() + columnCount*binCount, 0);
+                std::fill(columnCoarse.begin(), columnCoarse.begin() + columnCount*coarseCount, 0);
+
+                UInt32 * cf = columnFine.begin(),
+                       * cc = columnCoarse.begin();
+                T1 const * stripStart = planeStart + columnStart*s0;
+                for(MultiArrayIndex y = 0; y < std::min(h, r1); ++y)
+                    rankFilterUpdateColumns(stripStart + y*s1, s0, columnCount, boxOffsets, cf, cc, true);
+
+                for(MultiArrayIndex y = 0; y < h; ++y)
+                {
+                    if(y + r1 < h)
+                        rankFilterUpdateColumns(stripStart + (y + r1)*s1, s0, columnCount, boxOffsets, cf, cc, true);
+                    if(y - r1 - 1 >= 0)
+                        rankFilterUpdateColumns(stripStart + (y - r1 - 1)*s1, s0, columnCount, boxOffsets, cf, cc, false);
+
+                    MultiArrayIndex rowCount = (std::min(h - 1, y + r1) - std::max<MultiArrayIndex>(0, y - r1) + 1)
+                                                 * (MultiArrayIndex)boxOffsets.size();
+
+                    // coarse window histogram at the start of the strip
+                    std::fill(coarse.begin(), coarse.end(), 0);
+                    for(MultiArrayIndex c = std::max<MultiArrayIndex>(0, x0 - r0); c < std::min(w, x0 + r0 + 1); ++c)
+                    {
+                        UInt32 const * cc = columnCoarse.begin() + (c - columnStart)*coarseCount;
+                        for(int i = 0; i < coarseCount; ++i)
+                            coarse[i] += cc[i];
+                    }
+                    std::fill(fineX.begin(), fineX.end(), x0 - 1);
+
+                    T2 * d = destPlane + y*dest.stride(1);
+                    for(MultiArrayIndex x = x0; x < x1; ++x)
+                    {
+                        if(x > x0)
+                        {
+                            if(x + r0 < w)
+                            {
+                                UInt32 const * cc = columnCoarse.begin() + (x + r0 - columnStart)*coarseCount;
+                                for(int i = 0; i < coarseCount; ++i)
+                                    coarse[i] += cc[i];
+                            }
+                            if(x - r0 - 1 >= 0)
+                            {
+                                UInt32 const * cc = columnCoarse.begin() + (x - r0 - 1 - columnStart)*coarseCount;
+                                for(int i = 0; i < coarseCount; ++i)
+                                    coarse[i] -= cc[i];
+                            }
+                        }
+
+                        MultiArrayIndex count = (std::min(w - 1, x + r0) - std::max<MultiArrayIndex>(0, x - r0) + 1)
+                                                  * rowCount,
+                                        target = std::max<MultiArrayIndex>(1, (MultiArrayIndex)std::ceil(rank*count)),
+                                        sum = 0;
+
+                        int c = 0;
+                        for(; sum + coarse[c] < target; ++c)
+                            sum += coarse[c];
+
+                        // bring the fine bins of coarse bin c up to date
+                        UInt32 * f = fine.begin() + c*fineCount;
+                        if(fineX[c] < x0 || x - fineX[c] > r0)
+                        {
+                            std::fill(f, f + fineCount, 0);
+                            for(MultiArrayIndex k = std::max<MultiArrayIndex>(0, x - r0); k < std::min(w, x + r0 + 1); ++k)
+                            {
+                                UInt32 const * cf = columnFine.begin() + (k - columnStart)*binCount + c*fineCount;
+                                for(int i = 0; i < fineCount; ++i)
+                                    f[i] += cf[i];
+                            }
+                        }
+                        else
+                        {
+                            for(MultiArrayIndex k = fineX[c] + 1; k <= x; ++k)
+                            {
+                                if(k + r0 < w)
+                                {
+                                    UInt32 const * cf = columnFine.begin() + (k + r0 - columnStart)*binCount + c*fineCount;
+                                    for(int i = 0; i < fineCount; ++i)
+                                        f[i] += cf[i];
+                                }
+                                if(k - r0 - 1 >= 0)
+                                {
+                                    UInt32 const * cf = columnFine.begin() + (k - r0 - 1 - columnStart)*binCount + c*fineCount;
+                                    for(int i = 0; i < fineCount; ++i)
+                                        f[i] -= cf[i];
+                                }
+                            }
+                        }
+                        fineX[c] = x;
+
+                        int i = 0;
+                        for(; sum + f[i] < target; ++i)
+                            sum += f[i];
+
+                        d[x*dest.stride(0)] = detail::RequiresExplicitCast<T2>::cast(c*fineCount + i);
+                    }
+                }
+            }
+        }
+    }
+};
+
+template <>
+struct MultiRankOrderFilterImpl<1>
+{
+    template <class T1, class S1, class T2, class S2>
+    static void
+    exec(MultiArrayView<1, T1, S1> const & src,
+         MultiArrayView<1, T2, S2> dest,
+         MultiArrayShape<1>::type const & radius, double rank)
+    {
+        MultiRankOrderFilterImpl<2>::exec(src.insertSingletonDimension(1),
+                                          dest.insertSingletonDimension(1),
+                                          Shape2(radius[0], 0), rank);
+    }
+};
+
+} // namespace detail
+
+/** \addtogroup MultiArrayMorphology
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                 multiRankOrderFilter                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Rank order and median filters with a box window in constant time per element.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiRankOrderFilter(MultiArrayView<N, T1, S1> const & src,
+                             MultiArrayView<N, T2, S2> dest,
+                             typename MultiArrayShape<N>::type const & radius,
+                             double rank);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiMedianFilter(MultiArrayView<N, T1, S1> const & src,
+                          MultiArrayView<N, T2, S2> dest,
+                          typename MultiArrayShape<N>::type const & radius);
+    }
+    \endcode
+
+    The window is the box <tt>[-radius, radius]</tt>, clipped at the array border.
+    Each function is also available with a scalar <tt>radius</tt>, which is then used
+    for all dimensions. The result is the smallest value <tt>v</tt> in the window such
+    that at least the fraction <tt>rank</tt> of the window's elements is <tt>&lt;= v</tt>
+    (but at least one element). Thus, the filter computes the minimum if
+    <tt>rank = 0.0</tt>, the median if <tt>rank = 0.5</tt>, and the maximum if
+    <tt>rank = 1.0</tt>. <tt>multiMedianFilter()</tt> is the same as
+    <tt>multiRankOrderFilter()</tt> with <tt>rank = 0.5</tt>.
+
+    The value type of <tt>src</tt> must be <tt>UInt8</tt> or <tt>UInt16</tt>.
+    The implementation follows Perreault and H&eacute;bert ("Median Filtering
+    in Constant Time", IEEE Trans. Image Processing 16(9), 2007): in 2D, the cost
+    per element is independent of the radius. In higher dimensions, the cost grows
+    with the size of the window's cross section in dimensions 2...N-1, but not with
+    <tt>radius[0]</tt> and <tt>radius[1]</tt>. The functions may work in-place 
+    (source and destination may overlap in any way, including transposed or 
+    reversed views).
+
+    Each column along dimension 0 keeps a histogram with one bin per possible value.
+    For <tt>UInt8</tt>, these need 1 kB per column, i.e. 
+    <tt>shape[0]</tt> kB in total. For <tt>UInt16</tt>, they need 256 kB 
+    per column, and the array is processed in strips of 
+    <tt>max(64, 2*radius[0]+1)</tt> columns, which require 
+    <tt>(max(64, 2*radius[0]+1) + 2*radius[0]) * 256</tt> kB (e.g. 21 MB for 
+    <tt>radius[0] = 10</tt> and 100 MB for <tt>radius[0] = 100</tt>). When the
+    radius is anisotropic, memory can therefore be saved by passing transposed views
+    such that the smallest radius belongs to dimension 0.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_rank_filter.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt16> volume(Shape3(width, height, depth)),
+                          denoised(volume.shape());
+    ...
+    // median of a 21x21x5 window
+    multiMedianFilter(volume, denoised, Shape3(10, 10, 2));
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    0.0 <= rank <= 1.0
+    radius >= 0
+    \endcode
+
+    \see discRankOrderFilter(), multiGrayscaleBoxErosion()
+*/
+doxygen_overloaded_function(template <...> void multiRankOrderFilter)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+multiRankOrderFilter(MultiArrayView<N, T1, S1> const & src,
+                     MultiArrayView<N, T2, S2> dest,
+                     typename MultiArrayShape<N>::type const & radius,
+                     double rank)
+{
+    vigra_precondition(src.shape() == dest.shape(),
+        "multiRankOrderFilter(): shape mismatch between input and output.");
+    vigra_precondition(rank >= 0.0 && rank <= 1.0,
+        "multiRankOrderFilter(): rank must be between 0 and 1 (inclusive).");
+    vigra_precondition(radius.minimum() >= 0,
+        "multiRankOrderFilter(): radius must be non-negative.");
+
+    // rows are removed from the window after their results have been written
+    bool overlap = false;
+    if(src.size() > 0)
+    {
+        char const * srcFirst, * srcLast, * destFirst, * destLast;
+        detail::rankFilterMemoryRange(src, srcFirst, srcLast);
+        detail::rankFilterMemoryRange(dest, destFirst, destLast);
+        overlap = srcFirst < destLast && destFirst < srcLast;
+    }
+    if(overlap)
+    {
+        MultiArray<N, T1> tmp(src);
+        detail::MultiRankOrderFilterImpl<N>::exec(tmp, dest, radius, rank);
+    }
+    else
+    {
+        detail::MultiRankOrderFilterImpl<N>::exec(src, dest, radius, rank);
+    }
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiRankOrderFilter(MultiArrayView<N, T1, S1> const & src,
+                     MultiArrayView<N, T2, S2> dest,
+                     MultiArrayIndex radius, double rank)
+{
+    multiRankOrderFilter(src, dest, typename MultiArrayShape<N>::type(radius), rank);
+}
+
+doxygen_overloaded_function(template <...> void multiMedianFilter)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiMedianFilter(MultiArrayView<N, T1, S1> const & src,
+                  MultiArrayView<N, T2, S2> dest,
+                  typename MultiArrayShape<N>::type const & radius)
+{
+    multiRankOrderFilter(src, dest, radius, 0.5);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiMedianFilter(MultiArrayView<N, T1, S1> const & src,
+                  MultiArrayView<N, T2, S2> dest,
+                  MultiArrayIndex radius)
+{
+    multiRankOrderFilter(src, dest, typename MultiArrayShape<N>::type(radius), 0.5);
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_RANK_FILTER_HXX
@@ -0,0 +1,280 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef VIGRA_MULTI_RECONSTRUCTION_HXX
+#define VIGRA_MULTI_RECONSTRUCTION_HXX
+
+#include <deque>
+#include <functional>
+#include "multi_array.hxx"
+#include "multi_gridgraph.hxx"
+
+namespace vigra {
+
+namespace lemon_graph {
+
+    // Morphological reconstruction after L. Vincent: "Morphological Grayscale
+    // Reconstruction in Image Analysis: Applications and Efficient Algorithms",
+    // IEEE Trans. Image Processing 2(2), 1993 (the "hybrid" algorithm).
+    //
+    // On entry, 'dest' holds the marker, on exit the reconstruction of the marker
+    // under 'mask'. 'compare(a, b)' defines the order in which values are propagated:
+    // std::less reconstructs by dilation (dest <= mask), std::greater by erosion
+    // (dest >= mask). A forward and a backward raster scan propagate the values
+    // along the back and forward neighbors respectively. The backward scan puts
+    // all nodes into the FIFO that can still propagate to a neighbor, and the
+    // FIFO phase then completes the propagation in time linear in the number
+    // of changes.
+template <class Graph, class T1Map, class T2Map, class Compare>
+void
+morphologicalReconstructionGraph(Graph const & g,
+                                 T1Map const & mask,
+                                 T2Map & dest,
+                                 Compare const & compare)
+{
+    typedef typename Graph::Node          Node;
+    typedef typename Graph::NodeIt        graph_scanner;
+    typedef typename Graph::OutBackArcIt  back_neighbor_iterator;
+    typedef typename Graph::OutArcIt      neighbor_iterator;
+    typedef typename T2Map::value_type    DestType;
+
+    // the marker must lie below the mask
+    for (graph_scanner node(g); node != INVALID; ++node) 
+    {
+        if(compare(mask[*node], dest[*node]))
+            dest[*node] = mask[*node];
+    }
+
+    // forward scan: propagate from the back neighbors
+    for (graph_scanner node(g); node != INVALID; ++node) 
+    {
+        DestType v = dest[*node];
+        for (back_neighbor_iterator arc(g, node); arc != INVALID; ++arc)
+        {
+            if(compare(v, dest[g.target(*arc)]))
+                v = dest[g.target(*arc)];
+        }
+        if(compare(mask[*node], v))
+            v = mask[*node];
+        dest[*node] = v;
+    }
+
+    // backward scan: propagate from the forward neighbors and 
+    // initialize the queue
+    std::deque<Node> queue;
+    graph_scanner node(g);
+    node += g.maxNodeId();
+    for (MultiArrayIndex k = g.maxNodeId(); k >= 0; --k, --node) 
+    {
+        DestType v = dest[*node];
+        for (neighbor_iterator arc(g, *node); arc != INVALID; ++arc)
+        {
+            if(g.id(g.target(*arc)) > k && compare(v, dest[g.target(*arc)]))
+                v = dest[g.target(*arc)];
+        }
+        if(compare(mask[*node], v))
+            v = mask[*node];
+        dest[*node] = v;
+
+        for (neighbor_iterator arc(g, *node); arc != INVALID; ++arc)
+        {
+            Node t = g.target(*arc);
+            if(g.id(t) > k && compare(dest[t], v) && compare(dest[t], mask[t]))
+            {
+                queue.push_back(*node);
+                break;
+            }
+        }
+    }
+
+    // FIFO phase
+    while(!queue.empty())
+    {
+        Node current = queue.front();
+        queue.pop_front();
+        DestType v = dest[current];
+        for (neighbor_iterator arc(g, current); arc != INVALID; ++arc)
+        {
+            Node t = g.target(*arc);
+            if(compare(dest[t], v) && compare(dest[t], mask[t]))
+            {
+                dest[t] = compare(mask[t], v)
+                              ? DestType(mask[t])
+                              : v;
+                queue.push_back(t);
+            }
+        }
+    }
+}
+
+} // namespace lemon_graph
+
+/** \addtogroup MultiArrayMorphology
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*              multiReconstructionByDilation           */
+/*                                                      */
+/********************************************************/
+
+/** \brief Morphological reconstruction of a marker under a mask.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                                  class T3, class S3>
+        void
+        multiReconstructionByDilation(MultiArrayView<N, T1, S1> const & marker,
+                                      MultiArrayView<N, T2, S2> const & mask,
+                                      MultiArrayView<N, T3, S3> dest,
+                                      NeighborhoodType neighborhood = DirectNeighborhood);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                                  class T3, class S3>
+        void
+        multiReconstructionByErosion(MultiArrayView<N, T1, S1> const & marker,
+                                     MultiArrayView<N, T2, S2> const & mask,
+                                     MultiArrayView<N, T3, S3> dest,
+                                     NeighborhoodType neighborhood = DirectNeighborhood);
+    }
+    \endcode
+
+    Reconstruction by dilation repeats the geodesic dilation of <tt>marker</tt>
+    under <tt>mask</tt> (i.e. a dilation with the smallest structuring element,
+    followed by the pointwise minimum with <tt>mask</tt>) until stability.
+    Reconstruction by erosion is the dual operation: geodesic erosion above
+    <tt>mask</tt> until stability. The result is written to <tt>dest</tt>.
+    A marker that does not lie completely below (resp. above) the mask is
+    clipped to the mask first.
+
+    Argument \a neighborhood specifies the connectivity, <tt>DirectNeighborhood</tt>
+    (4-neighborhood in 2D, 6-neighborhood in 3D) or <tt>IndirectNeighborhood</tt>
+    (8-neighborhood in 2D, 26-neighborhood in 3D). The implementation uses
+    Vincent's hybrid algorithm (raster scans followed by a FIFO queue) on a
+    \ref vigra::GridGraph, so that the cost is independent of the number of
+    geodesic steps. The functions may work in-place, i.e. <tt>dest</tt> may
+    be the same array as <tt>marker</tt>. The corresponding graph algorithm is
+    <tt>lemon_graph::morphologicalReconstructionGraph()</tt>.
+
+    Many classical operations are special cases: the regional maxima of
+    <tt>f</tt> are <tt>f - multiReconstructionByDilation(f - 1, f)</tt>,
+    the h-maxima transform is <tt>multiReconstructionByDilation(f - h, f)</tt>, and
+    holes are filled by reconstruction by erosion from a marker that equals
+    <tt>f</tt> at the array border and the maximum elsewhere.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_reconstruction.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, float> volume(Shape3(width, height, depth)),
+                         marker(volume.shape()), hmax(volume.shape());
+    ...
+    // h-maxima transform: suppress all maxima with a dynamic below h
+    marker = volume;
+    marker -= h;
+    multiReconstructionByDilation(marker, volume, hmax, IndirectNeighborhood);
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    marker.shape() == mask.shape() && mask.shape() == dest.shape()
+    \endcode
+
+    \see multiGrayscaleDilation(), localMaxima()
+*/
+doxygen_overloaded_function(template <...> void multiReconstructionByDilation)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3>
+void
+multiReconstructionByDilation(MultiArrayView<N, T1, S1> const & marker,
+                              MultiArrayView<N, T2, S2> const & mask,
+                              MultiArrayView<N, T3, S3> dest,
+                              NeighborhoodType neighborhood = DirectNeighborhood)
+{
+    vigra_precondition(marker.shape() == mask.shape() && mask.shape() == dest.shape(),
+        "multiReconstructionByDilation(): shape mismatch between input and output.");
+
+    dest = marker;
+    GridGraph<N, undirected_tag> graph(mask.shape(), neighborhood);
+    lemon_graph::morphologicalReconstructionGraph(graph, mask, dest, std::less<T3>());
+}
+
+/********************************************************/
+/*                                                      */
+/*              multiReconstructionByErosion            */
+/*                                                      */
+/********************************************************/
+
+    /** \brief Morphological reconstruction by erosion.
+
+        See \ref multiReconstructionByDilation() for the documentation.
+    */
+doxygen_overloaded_function(template <...> void multiReconstructionByErosion)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+                          class T3, class S3>
+void
+multiReconstructionByErosion(MultiArrayView<N, T1, S1> const & marker,
+                             MultiArrayView<N, T2, S2> const & mask,
+                             MultiArrayView<N, T3, S3> dest,
+                             NeighborhoodType neighborhood = DirectNeighborhood)
+{
+    vigra_precondition(marker.shape() == mask.shape() && mask.shape() == dest.shape(),
+        "multiReconstructionByErosion(): shape mismatch between input and output.");
+
+    dest = marker;
+    GridGraph<N, undirected_tag> graph(mask.shape(), neighborhood);
+    lemon_graph::morphologicalReconstructionGraph(graph, mask, dest, std::greater<T3>());
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_RECONSTRUCTION_HXX
@@ -37,6 +37,7 @@
 #define VIGRA_MULTI_WATERSHEDS_HXX
 
 #include <functional>
+#include <algorithm>
 #include "mathutil.hxx"
 #include "multi_array.hxx"
 #include "multi_math.hxx"
@@ -505,6 +506,288 @@ watershedsMultiArray(MultiArrayView<N, T, S1> const & data,
     return lemon_graph::watershedsGraph(graph, data, labels, options);
 }
 
+namespace detail {
+
+    // Flood one block of a blockwise watershed. The flooding starts from
+    // all labeled points of the block and its one-pixel halo. An unlabeled
+    // point accepts any priority (including NumericTraits<T>::max()). A
+    // labeled point is reassigned when a neighbor offers a strictly lower
+    // priority than the point's current 'key' (the priority of the neighbor
+    // it was discovered from), which reproduces the serial flooding order. When
+    // a point changes its label at unchanged priority, the points discovered
+    // from it (recorded in 'parents' as the index of the discovering arc)
+    // inherit the new label. A block is reported as changed when one of
+    // its face points changed.
+template <unsigned int N, class T, class S1, class Label, class S2>
+class BlockwiseWatershedsTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef GridGraph<N, undirected_tag> Graph;
+
+    BlockwiseWatershedsTask(MultiArrayView<N, T, S1> const & data,
+                            MultiArrayView<N, Label, S2> const & labels,
+                            MultiArrayView<N, T> const & keys,
+                            MultiArrayView<N, UInt16> const & parents,
+                            LabelBlocking<N> const & blocking,
+                            Graph const & graph,
+                            WatershedOptions const & options,
+                            ArrayVector<MultiArrayIndex> const & active,
+                            ArrayVector<UInt8> & changed)
+    : data_(data)
+    , labels_(labels)
+    , keys_(keys)
+    , parents_(parents)
+    , blocking_(blocking)
+    , graph_(graph)
+    , options_(options)
+    , active_(active)
+    , changed_(changed)
+    {}
+
+    T priority(Shape const & p) const
+    {
+        T cost = (labels_[p] == options_.biased_label)
+                     ? data_[p] * options_.bias
+                     : data_[p];
+        return std::max(cost, keys_[p]);
+    }
+
+    void operator()(int, MultiArrayIndex k)
+    {
+        MultiArrayIndex b = active_[k];
+        Shape start, stop;
+        blocking_.bounds(b, start, stop);
+
+        bool stopAtThreshold = (options_.terminate & StopAtThreshold) != 0;
+        PriorityQueue<Shape, T, true> pqueue;
+
+        Shape halo_start = max(start - Shape(1), Shape()),
+              halo_stop  = min(stop + Shape(1), blocking_.shape_);
+        MultiCoordinateIterator<N> i(halo_stop - halo_start),
+                                   end = i.getEndIterator();
+        for(; i != end; ++i)
+        {
+            Shape p = halo_start + *i;
+            if(labels_[p] != 0)
+                pqueue.push(p, priority(p));
+        }
+
+        bool changed = false;
+        while(!pqueue.empty())
+        {
+            Shape node = pqueue.top();
+            T cost = pqueue.topPriority();
+            pqueue.pop();
+
+            if(stopAtThreshold && cost > options_.max_cost)
+                break;
+            if(cost != priority(node)) // outdated queue entry
+                continue;
+
+            Label label = labels_[node];
+            for(typename Graph::OutArcIt arc(graph_, node); arc != lemon::INVALID; ++arc)
+            {
+                Shape target = graph_.target(*arc);
+                if(blocking_.blockIndex(target) != b)
+                    continue;
+                if(labels_[target] == 0 || cost < keys_[target] ||
+                   (cost == keys_[target] && parents_[target] == arc.neighborIndex() &&
+                    labels_[target] != label))
+                {
+                    keys_[target] = cost;
+                    labels_[target] = label;
+                    parents_[target] = (UInt16)arc.neighborIndex();
+                    pqueue.push(target, priority(target));
+                    // only the face points are visible to the neighbors
+                    if(!changed)
+                        for(unsigned int d=0; d<N; ++d)
+                            if(target[d] == start[d] || target[d] == stop[d]-1)
+                                changed = true;
+                }
+            }
+        }
+        changed_[b] = changed;
+    }
+
+  private:
+    MultiArrayView<N, T, S1> data_;
+    MultiArrayView<N, Label, S2> labels_;
+    MultiArrayView<N, T> keys_;
+    MultiArrayView<N, UInt16> parents_;
+    LabelBlocking<N> const & blocking_;
+    Graph const & graph_;
+    WatershedOptions const & options_;
+    ArrayVector<MultiArrayIndex> const & active_;
+    ArrayVector<UInt8> & changed_;
+};
+
+} // namespace detail
+
+/** \brief Parallel watershed segmentation of an arbitrary-dimensional array.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T, class S1,
+                                  class Label, class S2>
+        Label
+        watershedsMultiArrayBlockwise(MultiArrayView<N, T, S1> const & data,
+                                      MultiArrayView<N, Label, S2> labels,  // may also hold input seeds
+                                      BlockwiseLabelOptions<N> const & blockwise_options = BlockwiseLabelOptions<N>(),
+                                      WatershedOptions const & options = WatershedOptions());
+    }
+    \endcode
+
+    This is a parallel version of the region growing algorithm of
+    \ref watershedsMultiArray(). The neighborhood, block shape and number
+    of threads are taken from \a blockwise_options. Seeds are handled as in
+    \ref watershedsMultiArray(), i.e. they are either given in \a labels or
+    computed by generateWatershedSeeds().
+
+    The array is split into blocks which are flooded independently, each
+    from the seeds in the block and the labeled points in its one-pixel halo.
+    Blocks are processed in 2<sup>N</sup> phases such that no two blocks
+    flooded concurrently are adjacent. Whenever a block changes, its neighbors
+    are flooded again, so that labels arriving across a block face can
+    replace labels reached by a more expensive path. This is repeated until
+    no block changes. Each point finally carries the label of the neighbor
+    that reaches it with the lowest flooding priority, exactly like in the
+    serial algorithm. Only ties between equal priorities on different sides
+    of a block face may be broken differently than in watershedsMultiArray().
+
+    The options <tt>stopAtThreshold()</tt> and <tt>biasLabel()</tt> are
+    supported, <tt>keepContours()</tt> and <tt>unionFind()</tt> are not.
+
+    Return: the number of regions found (= the highest region label)
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_watersheds.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, float> gradMag(Shape3(w, h, d));
+    ... // compute boundary indicator
+
+    MultiArray<3, UInt32> labeling(gradMag.shape());
+
+    // flood 128^3 blocks with 8 threads from automatically computed seeds
+    watershedsMultiArrayBlockwise(gradMag, labeling,
+                                  BlockwiseLabelOptions<3>().blockShape(Shape3(128)).numThreads(8),
+                                  WatershedOptions().seedOptions(SeedOptions().minima()));
+    \endcode
+*/
+doxygen_overloaded_function(template <...> Label watershedsMultiArrayBlockwise)
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2>
+Label
+watershedsMultiArrayBlockwise(MultiArrayView<N, T, S1> const & data,
+                              MultiArrayView<N, Label, S2> labels,  // may also hold input seeds
+                              BlockwiseLabelOptions<N> const & blockwise_options = BlockwiseLabelOptions<N>(),
+                              WatershedOptions const & options = WatershedOptions())
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    vigra_precondition(data.shape() == labels.shape(),
+        "watershedsMultiArrayBlockwise(): Shape mismatch between input and output.");
+    vigra_precondition(options.method == WatershedOptions::RegionGrowing,
+        "watershedsMultiArrayBlockwise(): only the region growing method is supported.");
+    vigra_precondition((options.terminate & KeepContours) == 0,
+        "watershedsMultiArrayBlockwise(): 'KeepContours' is not supported, sorry.");
+
+    GridGraph<N, undirected_tag> graph(data.shape(), blockwise_options.getNeighborhood());
+    vigra_precondition(graph.maxDegree() < NumericTraits<UInt16>::max(),
+        "watershedsMultiArrayBlockwise(): cannot handle nodes with degree > 65534.");
+
+    SeedOptions seed_options;
+    if(options.seed_options.mini != SeedOptions::Unspecified)
+        seed_options = options.seed_options;
+    else if(labels.any())
+        seed_options.mini = SeedOptions::Unspecified;
+    if(seed_options.mini != SeedOptions::Unspecified)
+        lemon_graph::graph_detail::generateWatershedSeeds(graph, data, labels, seed_options);
+
+    // seeds are never reassigned, unlabeled points accept any label
+    Label maxRegionLabel = 0;
+    MultiArray<N, T> keys(data.shape(), NumericTraits<T>::max());
+    MultiArray<N, UInt16> parents(data.shape(), (UInt16)graph.maxDegree());
+    for(MultiArrayIndex k=0; k<labels.size(); ++k)
+    {
+        if(labels[k] != 0)
+        {
+            keys[k] = NumericTraits<T>::min();
+            if(maxRegionLabel < labels[k])
+                maxRegionLabel = labels[k];
+        }
+    }
+
+    detail::LabelBlocking<N> blocking(data.shape(), blockwise_options.getBlockShape());
+    MultiArrayIndex blocks = blocking.size();
+    ParallelOptions parallel(blockwise_options.getNumThreads());
+
+    // color the blocks such that blocks of equal color are not adjacent
+    ArrayVector<int> colors(blocks);
+    for(MultiArrayIndex b=0; b<blocks; ++b)
+    {
+        Shape block;
+        detail::ScanOrderToCoordinate<N>::exec(b, blocking.blocks_, block);
+        for(unsigned int d=0; d<N; ++d)
+            colors[b] |= (block[d] & 1) << d;
+    }
+
+    ArrayVector<UInt8> dirty(blocks, 1), changed(blocks, 0);
+    ArrayVector<MultiArrayIndex> active;
+    detail::BlockwiseWatershedsTask<N, T, S1, Label, S2>
+        task(data, labels, keys, parents, blocking, graph, options, active, changed);
+
+    bool done = false;
+    while(!done)
+    {
+        done = true;
+        for(int color=0; color < (1 << N); ++color)
+        {
+            active.clear();
+            for(MultiArrayIndex b=0; b<blocks; ++b)
+            {
+                if(colors[b] == color && dirty[b])
+                {
+                    active.push_back(b);
+                    dirty[b] = 0;
+                }
+            }
+            if(active.size() == 0)
+                continue;
+            parallel_foreach(parallel, active.size(), task);
+
+            // changed blocks invalidate the floodings of their neighbors
+            for(std::size_t k=0; k<active.size(); ++k)
+            {
+                if(!changed[active[k]])
+                    continue;
+                done = false;
+                Shape block;
+                detail::ScanOrderToCoordinate<N>::exec(active[k], blocking.blocks_, block);
+                Shape neighbor_start = max(block - Shape(1), Shape()),
+                      neighbor_stop  = min(block + Shape(2), blocking.blocks_);
+                MultiCoordinateIterator<N> i(neighbor_stop - neighbor_start),
+                                           end = i.getEndIterator();
+                for(; i != end; ++i)
+                {
+                    MultiArrayIndex neighbor =
+                        detail::CoordinateToScanOrder<N>::exec(blocking.blocks_, neighbor_start + *i);
+                    if(neighbor != active[k])
+                        dirty[neighbor] = 1;
+                }
+            }
+        }
+    }
+
+    return maxRegionLabel;
+}
+
 //@}
 
 } // namespace vigra
@@ -366,6 +366,29 @@ void recursiveFilterLine(SrcIterator is, SrcIterator isend, SrcAccessor as,
 /*                                                      */
 /********************************************************/
 
+namespace detail {
+
+    // Coefficients of the third order recursive Gaussian filter of Young and van Vliet.
+struct RecursiveGaussianCoefficients
+{
+    double b1, b2, b3, B;
+
+    explicit RecursiveGaussianCoefficients(double sigma)
+    {
+        //coefficients taken out Luigi Rosa's implementation for Matlab
+        double q = 1.31564 * (std::sqrt(1.0 + 0.490811 * sigma*sigma) - 1.0);
+        double qq = q*q;
+        double qqq = qq*q;
+        double b0 = 1.0/(1.57825 + 2.44413*q + 1.4281*qq + 0.422205*qqq);
+        b1 = (2.44413*q + 2.85619*qq + 1.26661*qqq)*b0;
+        b2 = (-1.4281*qq - 1.26661*qqq)*b0;
+        b3 = 0.422205*qqq*b0;
+        B = 1.0 - (b1 + b2 + b3);
+    }
+};
+
+} // namespace detail
+
 // AUTHOR: Sebastian Boppel
 
 /** \brief Compute a 1-dimensional recursive approximation of Gaussian smoothing.
@@ -449,15 +472,8 @@ recursiveGaussianFilterLine(SrcIterator is, SrcIterator isend, SrcAccessor as,
                             DestIterator id, DestAccessor ad, 
                             double sigma)
 {
-    //coefficients taken out Luigi Rosa's implementation for Matlab
-    double q = 1.31564 * (std::sqrt(1.0 + 0.490811 * sigma*sigma) - 1.0);
-    double qq = q*q;
-    double qqq = qq*q;
-    double b0 = 1.0/(1.57825 + 2.44413*q + 1.4281*qq + 0.422205*qqq);
-    double b1 = (2.44413*q + 2.85619*qq + 1.26661*qqq)*b0;
-    double b2 = (-1.4281*qq - 1.26661*qqq)*b0;
-    double b3 = 0.422205*qqq*b0;
-    double B = 1.0 - (b1 + b2 + b3);
+    detail::RecursiveGaussianCoefficients c(sigma);
+    double b1 = c.b1, b2 = c.b2, b3 = c.b3, B = c.B;
     
     int w = isend - is;
     vigra_precondition(w >= 4,
@@ -474,7 +490,7 @@ recursiveGaussianFilterLine(SrcIterator is, SrcIterator isend, SrcAccessor as,
     // speichert das Ergebnis der linkseitigen Filterung.
     std::vector<TempType> yforward(w);
     
-    std::vector<TempType> ybackward(w, 0.0);
+    std::vector<TempType> ybackward(w, NumericTraits<TempType>::zero());
     
     // initialise the filter for reflective boundary conditions
     for(x=kernelw; x>=0; --x)
@@ -0,0 +1,447 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_REGION_ADJACENCY_GRAPH_HXX
+#define VIGRA_REGION_ADJACENCY_GRAPH_HXX
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "multi_array.hxx"
+#include "multi_gridgraph.hxx"
+#include "numerictraits.hxx"
+#include "threadpool.hxx"
+
+namespace vigra {
+
+/** \addtogroup Labeling
+*/
+//@{
+
+namespace detail {
+
+template <class Value>
+struct RagBoundarySample
+{
+    MultiArrayIndex u, v;
+    Value value;
+
+    bool operator<(RagBoundarySample const & o) const
+    {
+        return u < o.u || (u == o.u && v < o.v);
+    }
+};
+
+    // Scan one slab of the label array (a range of the last coordinate)
+    // and record a sample for every pair of adjacent points with different
+    // labels. Each pair is a back arc of exactly one of its points.
+template <unsigned int N, class Label, class S1, class T, class S2, class Value>
+class RagScanTask
+{
+  public:
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef GridGraph<N, undirected_tag> Graph;
+    typedef RagBoundarySample<Value> Sample;
+
+    RagScanTask(MultiArrayView<N, Label, S1> const & labels,
+                MultiArrayView<N, T, S2> const & data,
+                Graph const & graph, MultiArrayIndex slab_size,
+                ArrayVector<std::vector<Sample> > & samples,
+                ArrayVector<MultiArrayIndex> & max_labels)
+    : labels_(labels)
+    , data_(data)
+    , graph_(graph)
+    , slab_size_(slab_size)
+    , samples_(samples)
+    , max_labels_(max_labels)
+    {}
+
+    void operator()(int, MultiArrayIndex slab)
+    {
+        Shape start, stop(labels_.shape());
+        start[N-1] = slab*slab_size_;
+        stop[N-1] = std::min(start[N-1] + slab_size_, stop[N-1]);
+
+        std::vector<Sample> & samples = samples_[slab];
+        MultiArrayIndex max_label = 0;
+
+        MultiCoordinateIterator<N> i(stop - start),
+                                   end = i.getEndIterator();
+        for(; i != end; ++i)
+        {
+            Shape p = start + *i;
+            MultiArrayIndex label = (MultiArrayIndex)labels_[p];
+            vigra_precondition(label >= 0,
+                "RegionAdjacencyGraph(): labels must be non-negative.");
+            if(max_label < label)
+                max_label = label;
+
+            for(typename Graph::OutBackArcIt arc(graph_, p); arc != lemon::INVALID; ++arc)
+            {
+                Shape q = graph_.target(*arc);
+                MultiArrayIndex other = (MultiArrayIndex)labels_[q];
+                if(other == label)
+                    continue;
+                Sample s;
+                s.u = std::min(label, other);
+                s.v = std::max(label, other);
+                s.value = 0.5*((Value)data_[p] + (Value)data_[q]);
+                samples.push_back(s);
+            }
+        }
+        std::stable_sort(samples.begin(), samples.end());
+        max_labels_[slab] = max_label;
+    }
+
+  private:
+    MultiArrayView<N, Label, S1> labels_;
+    MultiArrayView<N, T, S2> data_;
+    Graph const & graph_;
+    MultiArrayIndex slab_size_;
+    ArrayVector<std::vector<Sample> > & samples_;
+    ArrayVector<MultiArrayIndex> & max_labels_;
+};
+
+    // Feed the samples of a range of edges into their accumulators.
+template <class EdgeFeatures, class Value>
+class RagAccumulateTask
+{
+  public:
+    RagAccumulateTask(ArrayVector<Value> const & values,
+                      ArrayVector<MultiArrayIndex> const & offsets,
+                      ArrayVector<EdgeFeatures> & features,
+                      MultiArrayIndex chunk_size)
+    : values_(values)
+    , offsets_(offsets)
+    , features_(features)
+    , chunk_size_(chunk_size)
+    {}
+
+    void operator()(int, MultiArrayIndex chunk)
+    {
+        MultiArrayIndex begin = chunk*chunk_size_,
+                        end = std::min(begin + chunk_size_, (MultiArrayIndex)features_.size());
+        for(MultiArrayIndex e=begin; e<end; ++e)
+        {
+            EdgeFeatures & f = features_[e];
+            unsigned int passes = f.passesRequired();
+            for(unsigned int pass=1; pass <= passes; ++pass)
+                for(MultiArrayIndex k=offsets_[e]; k<offsets_[e+1]; ++k)
+                    f.updatePassN(values_[k], pass);
+        }
+    }
+
+  private:
+    ArrayVector<Value> const & values_;
+    ArrayVector<MultiArrayIndex> const & offsets_;
+    ArrayVector<EdgeFeatures> & features_;
+    MultiArrayIndex chunk_size_;
+};
+
+} // namespace detail
+
+/** \brief Region adjacency graph of a label array with per-edge statistics.
+
+    The nodes of the graph are the label values <tt>0 ... maxLabel</tt> of a
+    label array (e.g. the result of \ref watershedsMultiArray() or
+    \ref slicSuperpixels()), and there is an edge between two labels whenever
+    two points carrying these labels are neighbors in the
+    <tt>GridGraph</tt> defined by the given neighborhood. Labels that do not
+    occur in the array become isolated nodes.
+
+    Each edge owns an accumulator chain of type <tt>EdgeFeatures</tt>
+    (see \ref FeatureAccumulators), e.g.
+    <tt>acc::AccumulatorChain<double, acc::Select<acc::Count, acc::Mean, acc::StandardQuantiles<acc::UserRangeHistogram<64> > > ></tt>.
+    The chains are copies of an optional prototype chain, so that options
+    such as the histogram range can be set once for all edges.
+    Every pair of adjacent points <tt>p, q</tt> with different labels
+    contributes one sample <tt>(data[p] + data[q]) / 2</tt> to the chain of
+    the corresponding edge, so that <tt>Count</tt> is the boundary length
+    (in point pairs) and <tt>Mean</tt> the mean boundary intensity. Chains
+    requiring several passes (such as quantiles) are supported. Do not use
+    <tt>AutoRangeHistogram</tt>: it throws on edges whose samples are all
+    equal, which is common for short boundaries. Use a
+    <tt>UserRangeHistogram</tt> with the data range set in the prototype instead.
+
+    The graph is stored compactly: the edges are sorted by their end nodes
+    <tt>u < v</tt>, and the adjacency of each node is a contiguous sorted
+    range. The label array is scanned in parallel slabs, and the edge
+    statistics are accumulated in parallel over the edges.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/region_adjacency_graph.hxx\><br>
+    Namespace: vigra
+
+    \code
+    using namespace vigra::acc;
+
+    MultiArray<3, float>  gradMag(shape);
+    MultiArray<3, UInt32> labels(shape);
+    ... // compute superpixels
+
+    typedef AccumulatorChain<double, Select<Count, Mean, StandardQuantiles<UserRangeHistogram<64> > > > EdgeFeatures;
+    float mi, ma;
+    gradMag.minmax(&mi, &ma);
+    EdgeFeatures prototype;
+    prototype.setHistogramOptions(HistogramOptions().setMinMax(mi, ma));
+
+    RegionAdjacencyGraph<EdgeFeatures> rag(labels, gradMag, DirectNeighborhood,
+                                           ParallelOptions(), prototype);
+
+    for(MultiArrayIndex e=0; e<rag.edgeCount(); ++e)
+        std::cout << rag.u(e) << " - " << rag.v(e) << ": mean boundary strength "
+                  << get<Mean>(rag.edgeFeatures(e)) << ", median "
+                  << get<StandardQuantiles<UserRangeHistogram<64> > >(rag.edgeFeatures(e))[3] << "\n";
+    \endcode
+*/
+template <class EdgeFeatures>
+class RegionAdjacencyGraph
+{
+  public:
+    typedef MultiArrayIndex index_type;
+    typedef EdgeFeatures    edge_features_type;
+
+        /** Create an empty graph.
+        */
+    RegionAdjacencyGraph()
+    : node_count_(0)
+    {}
+
+        /** Build the graph from the label array \a labels and feed the
+            boundary samples of \a data into the edge accumulators (see
+            \ref build()).
+        */
+    template <unsigned int N, class Label, class S1, class T, class S2>
+    RegionAdjacencyGraph(MultiArrayView<N, Label, S1> const & labels,
+                         MultiArrayView<N, T, S2> const & data,
+                         NeighborhoodType neighborhood = DirectNeighborhood,
+                         ParallelOptions const & parallel = ParallelOptions(),
+                         EdgeFeatures const & prototype = EdgeFeatures())
+    : node_count_(0)
+    {
+        build(labels, data, neighborhood, parallel, prototype);
+    }
+
+        /** (Re-)build the graph from the label array \a labels using the
+            given \a neighborhood (<tt>DirectNeighborhood</tt> or
+            <tt>IndirectNeighborhood</tt>) and accumulate the boundary
+            statistics of \a data. Labels must be non-negative integers.
+            The accumulator chain of each edge starts as a copy of \a prototype,
+            which must not have seen any data yet.
+        */
+    template <unsigned int N, class Label, class S1, class T, class S2>
+    void build(MultiArrayView<N, Label, S1> const & labels,
+               MultiArrayView<N, T, S2> const & data,
+               NeighborhoodType neighborhood = DirectNeighborhood,
+               ParallelOptions const & parallel = ParallelOptions(),
+               EdgeFeatures const & prototype = EdgeFeatures());
+
+        /** Number of nodes (= largest label + 1).
+        */
+    index_type nodeCount() const
+    {
+        return node_count_;
+    }
+
+        /** Number of edges.
+        */
+    index_type edgeCount() const
+    {
+        return (index_type)edges_.size();
+    }
+
+        /** Smaller end node of edge \a e.
+        */
+    index_type u(index_type e) const
+    {
+        return edges_[e].first;
+    }
+
+        /** Larger end node of edge \a e.
+        */
+    index_type v(index_type e) const
+    {
+        return edges_[e].second;
+    }
+
+        /** Number of neighbors of \a node.
+        */
+    index_type degree(index_type node) const
+    {
+        return adjacency_offsets_[node+1] - adjacency_offsets_[node];
+    }
+
+        /** The <tt>k</tt>-th neighbor of \a node (neighbors are sorted
+            in ascending order).
+        */
+    index_type neighbor(index_type node, index_type k) const
+    {
+        return adjacency_[adjacency_offsets_[node] + k].first;
+    }
+
+        /** The edge connecting \a node with its <tt>k</tt>-th neighbor.
+        */
+    index_type neighborEdge(index_type node, index_type k) const
+    {
+        return adjacency_[adjacency_offsets_[node] + k].second;
+    }
+
+        /** The edge between nodes \a a and \a b, or <tt>-1</tt> if
+            they are not adjacent.
+        */
+    index_type findEdge(index_type a, index_type b) const
+    {
+        typedef std::pair<index_type, index_type> Entry;
+        typename ArrayVector<Entry>::const_iterator
+            begin = adjacency_.begin() + adjacency_offsets_[a],
+            end   = adjacency_.begin() + adjacency_offsets_[a+1],
+            i     = std::lower_bound(begin, end, Entry(b, 0));
+        return (i != end && i->first == b)
+                   ? i->second
+                   : -1;
+    }
+
+        /** Accumulator chain of edge \a e.
+        */
+    EdgeFeatures const & edgeFeatures(index_type e) const
+    {
+        return edge_features_[e];
+    }
+
+    EdgeFeatures & edgeFeatures(index_type e)
+    {
+        return edge_features_[e];
+    }
+
+  private:
+    index_type node_count_;
+    ArrayVector<std::pair<index_type, index_type> > edges_;
+    ArrayVector<index_type> adjacency_offsets_;
+    ArrayVector<std::pair<index_type, index_type> > adjacency_;
+    ArrayVector<EdgeFeatures> edge_features_;
+};
+
+template <class EdgeFeatures>
+template <unsigned int N, class Label, class S1, class T, class S2>
+void
+RegionAdjacencyGraph<EdgeFeatures>::build(MultiArrayView<N, Label, S1> const & labels,
+                                          MultiArrayView<N, T, S2> const & data,
+                                          NeighborhoodType neighborhood,
+                                          ParallelOptions const & parallel,
+                                          EdgeFeatures const & prototype)
+{
+    typedef typename NumericTraits<T>::RealPromote Value;
+    typedef detail::RagBoundarySample<Value> Sample;
+
+    vigra_precondition(labels.shape() == data.shape(),
+        "RegionAdjacencyGraph::build(): shape mismatch between labels and data.");
+
+    // pass 1: collect the boundary samples in parallel slabs
+    GridGraph<N, undirected_tag> graph(labels.shape(), neighborhood);
+    int threads = parallel.getActualNumThreads();
+    MultiArrayIndex length = labels.shape(N-1),
+                    slabs = std::max<MultiArrayIndex>(std::min<MultiArrayIndex>(length, 4*threads), 1),
+                    slab_size = std::max<MultiArrayIndex>((length + slabs - 1) / slabs, 1);
+    slabs = (length + slab_size - 1) / slab_size;
+
+    ArrayVector<std::vector<Sample> > samples(slabs);
+    ArrayVector<index_type> max_labels(slabs);
+    detail::RagScanTask<N, Label, S1, T, S2, Value>
+        scan_task(labels, data, graph, slab_size, samples, max_labels);
+    parallel_foreach(parallel, slabs, scan_task);
+
+    node_count_ = labels.size() > 0
+                      ? *std::max_element(max_labels.begin(), max_labels.end()) + 1
+                      : 0;
+
+    // pass 2: merge the sorted slabs into the edge list and group the samples by edge
+    std::vector<Sample> all;
+    for(MultiArrayIndex s=0; s<slabs; ++s)
+    {
+        std::size_t middle = all.size();
+        all.insert(all.end(), samples[s].begin(), samples[s].end());
+        std::vector<Sample>().swap(samples[s]);
+        std::inplace_merge(all.begin(), all.begin() + middle, all.end());
+    }
+
+    edges_.clear();
+    ArrayVector<index_type> offsets;
+    ArrayVector<Value> values(all.size());
+    for(std::size_t k=0; k<all.size(); ++k)
+    {
+        if(k == 0 || all[k].u != all[k-1].u || all[k].v != all[k-1].v)
+        {
+            edges_.push_back(std::make_pair(all[k].u, all[k].v));
+            offsets.push_back((index_type)k);
+        }
+        values[k] = all[k].value;
+    }
+    offsets.push_back((index_type)all.size());
+    std::vector<Sample>().swap(all);
+
+    // build the adjacency ranges of the nodes
+    adjacency_offsets_ = ArrayVector<index_type>(node_count_ + 1, 0);
+    for(index_type e=0; e<edgeCount(); ++e)
+    {
+        ++adjacency_offsets_[u(e)+1];
+        ++adjacency_offsets_[v(e)+1];
+    }
+    for(index_type n=0; n<node_count_; ++n)
+        adjacency_offsets_[n+1] += adjacency_offsets_[n];
+    adjacency_ = ArrayVector<std::pair<index_type, index_type> >(2*edgeCount());
+    ArrayVector<index_type> fill(adjacency_offsets_.begin(), adjacency_offsets_.end()-1);
+    for(index_type e=0; e<edgeCount(); ++e)
+    {
+        // edges are sorted by (u, v), so the neighbors come out sorted
+        adjacency_[fill[u(e)]++] = std::make_pair(v(e), e);
+        adjacency_[fill[v(e)]++] = std::make_pair(u(e), e);
+    }
+
+    // pass 3: accumulate the edge statistics in parallel
+    edge_features_ = ArrayVector<EdgeFeatures>(edgeCount(), prototype);
+    MultiArrayIndex chunk_size = std::max<MultiArrayIndex>((edgeCount() + 4*threads - 1) / (4*threads), 1),
+                    chunks = (edgeCount() + chunk_size - 1) / chunk_size;
+    detail::RagAccumulateTask<EdgeFeatures, Value>
+        accumulate_task(values, offsets, edge_features_, chunk_size);
+    parallel_foreach(parallel, chunks, accumulate_task);
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_REGION_ADJACENCY_GRAPH_HXX
@@ -37,8 +37,8 @@
 #define VIGRA_SEEDEDREGIONGROWING_HXX
 
 #include <vector>
-#include <stack>
 #include <queue>
+#include <algorithm>
 #include "utilities.hxx"
 #include "stdimage.hxx"
 #include "stdimagefunctions.hxx"
@@ -74,20 +74,6 @@ public:
         dist_ = dx * dx + dy * dy;
     }
 
-    void set(Point2D const & location, Point2D const & nearest,
-             COST const & cost, int const & count, int const & label)
-    {
-        location_ = location;
-        nearest_ = nearest;
-        cost_ = cost;
-        count_ = count;
-        label_ = label;
-
-        int dx = location_.x - nearest_.x;
-        int dy = location_.y - nearest_.y;
-        dist_ = dx * dx + dy * dy;
-    }
-
     struct Compare
     {
         // must implement > since priority_queue looks for largest element
@@ -103,53 +89,92 @@ public:
 
             return r.cost_ < l.cost_;
         }
-        bool operator()(SeedRgPixel const * l,
-                        SeedRgPixel const * r) const
-        {
-            if(r->cost_ == l->cost_)
-            {
-                if(r->dist_ == l->dist_) return r->count_ < l->count_;
+    };
+};
 
-                return r->dist_ < l->dist_;
-            }
+    // Candidate queue of seeded region growing. Candidates are stored by value
+    // and ordered by cost, then by distance to their seed, then by insertion order.
+template <class Pixel, class Cost>
+class SeedRgQueue
+: public std::priority_queue<Pixel, std::vector<Pixel>, typename Pixel::Compare>
+{};
+
+    // Bucket queue for small integral costs. In contrast to vigra::BucketQueue,
+    // each bucket is a heap, because candidates with equal cost must still
+    // be ordered by distance and insertion order.
+template <class Pixel>
+class SeedRgBucketQueue
+{
+    ArrayVector<std::vector<Pixel> > buckets_;
+    std::size_t size_;
+    std::ptrdiff_t top_;
+    typename Pixel::Compare compare_;
 
-            return r->cost_ < l->cost_;
-        }
-    };
+  public:
+    typedef std::size_t size_type;
+
+    SeedRgBucketQueue(size_type bucket_count)
+    : buckets_(bucket_count),
+      size_(0), top_((std::ptrdiff_t)bucket_count)
+    {}
 
-    struct Allocator
+    size_type size() const
     {
-        ~Allocator()
-        {
-            while(!freelist_.empty())
-            {
-                delete freelist_.top();
-                freelist_.pop();
-            }
-        }
+        return size_;
+    }
 
-        SeedRgPixel *
-        create(Point2D const & location, Point2D const & nearest,
-               COST const & cost, int const & count, int const & label)
-        {
-            if(!freelist_.empty())
-            {
-                SeedRgPixel * res = freelist_.top();
-                freelist_.pop();
-                res->set(location, nearest, cost, count, label);
-                return res;
-            }
+    bool empty() const
+    {
+        return size() == 0;
+    }
 
-            return new SeedRgPixel(location, nearest, cost, count, label);
-        }
+    Pixel const & top() const
+    {
+        return buckets_[top_].front();
+    }
 
-        void dismiss(SeedRgPixel * p)
-        {
-            freelist_.push(p);
-        }
+    void pop()
+    {
+        std::vector<Pixel> & bucket = buckets_[top_];
+        std::pop_heap(bucket.begin(), bucket.end(), compare_);
+        bucket.pop_back();
+        --size_;
 
-        std::stack<SeedRgPixel<COST> *> freelist_;
-    };
+        while(top_ < (std::ptrdiff_t)buckets_.size() && buckets_[top_].empty())
+            ++top_;
+    }
+
+    void push(Pixel const & p)
+    {
+        std::ptrdiff_t priority = (std::ptrdiff_t)p.cost_;
+        std::vector<Pixel> & bucket = buckets_[priority];
+        bucket.push_back(p);
+        std::push_heap(bucket.begin(), bucket.end(), compare_);
+        ++size_;
+
+        if(priority < top_)
+            top_ = priority;
+    }
+};
+
+template <class Pixel>
+class SeedRgQueue<Pixel, unsigned char>
+: public SeedRgBucketQueue<Pixel>
+{
+  public:
+    SeedRgQueue()
+    : SeedRgBucketQueue<Pixel>(NumericTraits<unsigned char>::max()+1)
+    {}
+};
+
+template <class Pixel>
+class SeedRgQueue<Pixel, unsigned short>
+: public SeedRgBucketQueue<Pixel>
+{
+  public:
+    SeedRgQueue()
+    : SeedRgBucketQueue<Pixel>(NumericTraits<unsigned short>::max()+1)
+    {}
 };
 
 struct UnlabelWatersheds
@@ -437,10 +462,7 @@ seededRegionGrowing(SrcIterator srcul,
     typedef typename RegionStatistics::cost_type CostType;
     typedef detail::SeedRgPixel<CostType> Pixel;
 
-    typename Pixel::Allocator allocator;
-
-    typedef std::priority_queue<Pixel *, std::vector<Pixel *>,
-                                typename Pixel::Compare>  SeedRgPixelHeap;
+    typedef detail::SeedRgQueue<Pixel, CostType> SeedRgPixelHeap;
 
     // copy seed image in an image with border
     IImage regions(w+2, h+2);
@@ -476,9 +498,7 @@ seededRegionGrowing(SrcIterator srcul,
                     {
                         CostType cost = stats[cneighbor].cost(as(isx));
 
-                        Pixel * pixel =
-                            allocator.create(pos, pos+Neighborhood::diff((Direction)i), cost, count++, cneighbor);
-                        pheap.push(pixel);
+                        pheap.push(Pixel(pos, pos+Neighborhood::diff((Direction)i), cost, count++, cneighbor));
                     }
                 }
             }
@@ -495,16 +515,13 @@ seededRegionGrowing(SrcIterator srcul,
     // perform region growing
     while(pheap.size() != 0)
     {
-        Pixel * pixel = pheap.top();
+        Pixel const & pixel = pheap.top();
+        Point2D pos = pixel.location_;
+        Point2D nearest = pixel.nearest_;
+        int lab = pixel.label_;
+        CostType cost = pixel.cost_;
         pheap.pop();
 
-        Point2D pos = pixel->location_;
-        Point2D nearest = pixel->nearest_;
-        int lab = pixel->label_;
-        CostType cost = pixel->cost_;
-
-        allocator.dismiss(pixel);
-
         if((srgType & StopAtThreshold) != 0 && cost > max_cost)
             break;
 
@@ -542,21 +559,12 @@ seededRegionGrowing(SrcIterator srcul,
                 {
                     CostType cost = stats[lab].cost(as(isx, Neighborhood::diff((Direction)i)));
 
-                    Pixel * new_pixel =
-                        allocator.create(pos+Neighborhood::diff((Direction)i), nearest, cost, count++, lab);
-                    pheap.push(new_pixel);
+                    pheap.push(Pixel(pos+Neighborhood::diff((Direction)i), nearest, cost, count++, lab));
                 }
             }
         }
     }
     
-    // free temporary memory
-    while(pheap.size() != 0)
-    {
-        allocator.dismiss(pheap.top());
-        pheap.pop();
-    }
-
     // write result
     transformImage(ir, ir+Point2D(w,h), regions.accessor(), destul, ad,
                    detail::UnlabelWatersheds());
@@ -38,7 +38,6 @@
 #define VIGRA_SEEDEDREGIONGROWING_3D_HXX
 
 #include <vector>
-#include <stack>
 #include <queue>
 #include "utilities.hxx"
 #include "stdimage.hxx"
@@ -83,21 +82,6 @@ public:
         dist_ = dx * dx + dy * dy + dz * dz;
     }
 
-    void set(Diff_type const & location, Diff_type const & nearest,
-             COST const & cost, int const & count, int const & label)
-    {
-        location_ = location;
-        nearest_ = nearest;
-        cost_ = cost;
-        count_ = count;
-        label_ = label;
-
-        int dx = location_[0] - nearest_[0];
-        int dy = location_[1] - nearest_[1];
-        int dz = location_[2] - nearest_[2];
-        dist_ = dx * dx + dy * dy + dz * dz;
-    }
-
     struct Compare
     {
         // must implement > since priority_queue looks for largest element
@@ -113,51 +97,6 @@ public:
 
             return r.cost_ < l.cost_;
         }
-        bool operator()(SeedRgVoxel const * l,
-                        SeedRgVoxel const * r) const
-        {
-            if(r->cost_ == l->cost_)
-            {
-                if(r->dist_ == l->dist_) return r->count_ < l->count_;
-
-                return r->dist_ < l->dist_;
-            }
-
-            return r->cost_ < l->cost_;
-        }
-    };
-
-    struct Allocator
-    {
-        ~Allocator()
-        {
-            while(!freelist_.empty())
-            {
-                delete freelist_.top();
-                freelist_.pop();
-            }
-        }
-
-        SeedRgVoxel * create(Diff_type const & location, Diff_type const & nearest,
-                             COST const & cost, int const & count, int const & label)
-        {
-            if(!freelist_.empty())
-            {
-                SeedRgVoxel * res = freelist_.top();
-                freelist_.pop();
-                res->set(location, nearest, cost, count, label);
-                return res;
-            }
-
-            return new SeedRgVoxel(location, nearest, cost, count, label);
-        }
-
-        void dismiss(SeedRgVoxel * p)
-        {
-            freelist_.push(p);
-        }
-
-        std::stack<SeedRgVoxel<COST,Diff_type> *> freelist_;
     };
 };
 
@@ -343,11 +282,9 @@ seededRegionGrowing3D(SrcImageIterator srcul, Diff_type shape, SrcAccessor as,
     typedef typename PromoteTraits<typename RegionStatistics::cost_type, double>::Promote CostType;
     typedef detail::SeedRgVoxel<CostType, Diff_type> Voxel;
 
-    typename Voxel::Allocator allocator;
-
-    typedef std::priority_queue< Voxel *,
-                                 std::vector<Voxel *>,
-                                 typename Voxel::Compare >  SeedRgVoxelHeap;
+    // select the queue by the original cost type, so that small integral
+    // costs are sorted into buckets
+    typedef detail::SeedRgQueue<Voxel, typename RegionStatistics::cost_type> SeedRgVoxelHeap;
     typedef MultiArray<3, int> IVolume;
     typedef IVolume::traverser Traverser;
 
@@ -400,9 +337,7 @@ seededRegionGrowing3D(SrcImageIterator srcul, Diff_type shape, SrcAccessor as,
                         {
                             CostType cost = stats[cneighbor].cost(as(isx));
 
-                            Voxel * voxel =
-                                allocator.create(pos, pos+Neighborhood::diff((Direction)i), cost, count++, cneighbor);
-                            pheap.push(voxel);
+                            pheap.push(Voxel(pos, pos+Neighborhood::diff((Direction)i), cost, count++, cneighbor));
                         }
                     }
                 }
@@ -413,16 +348,13 @@ seededRegionGrowing3D(SrcImageIterator srcul, Diff_type shape, SrcAccessor as,
     // perform region growing
     while(pheap.size() != 0)
     {
-        Voxel * voxel = pheap.top();
+        Voxel const & voxel = pheap.top();
+        Diff_type pos = voxel.location_;
+        Diff_type nearest = voxel.nearest_;
+        int lab = voxel.label_;
+        CostType cost = voxel.cost_;
         pheap.pop();
 
-        Diff_type pos = voxel->location_;
-        Diff_type nearest = voxel->nearest_;
-        int lab = voxel->label_;
-        CostType cost = voxel->cost_;
-
-        allocator.dismiss(voxel);
-
         if((srgType & StopAtThreshold) != 0 && cost > max_cost)
             break;
 
@@ -460,21 +392,12 @@ seededRegionGrowing3D(SrcImageIterator srcul, Diff_type shape, SrcAccessor as,
                 {
                     CostType cost = stats[lab].cost(as(isx, Neighborhood::diff((Direction)i)));
 
-                    Voxel * new_voxel =
-                        allocator.create(pos+Neighborhood::diff((Direction)i), nearest, cost, count++, lab);
-                    pheap.push(new_voxel);
+                    pheap.push(Voxel(pos+Neighborhood::diff((Direction)i), nearest, cost, count++, lab));
                 }
             }
         }
     }
     
-    // free temporary memory
-    while(pheap.size() != 0)
-    {
-        allocator.dismiss(pheap.top());
-        pheap.pop();
-    }
-
     // write result
     transformMultiArray(ir, Diff_type(w,h,d), AccessorTraits<int>::default_accessor(), 
                         destul, ad, detail::UnlabelWatersheds());
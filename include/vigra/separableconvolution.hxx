@@ -211,6 +211,119 @@ copyLineWithBorderTreatment(SrcIterator is, SrcIterator iend, SrcAccessor sa,
     }
 }
 
+/********************************************************/
+/*                                                      */
+/*             internalConvolveLineVectorized           */
+/*                                                      */
+/********************************************************/
+
+// Lines of these types are convolved by internalConvolveLineVectorized().
+template <class T>
+struct ConvolveLineVectorizable
+{
+    static const bool value = false;
+};
+
+template <>
+struct ConvolveLineVectorizable<float>
+{
+    static const bool value = true;
+};
+
+template <>
+struct ConvolveLineVectorizable<double>
+{
+    static const bool value = true;
+};
+
+template <>
+struct ConvolveLineVectorizable<UInt8>
+{
+    static const bool value = true;
+};
+
+template <class SrcValue, class KernelValue>
+struct UseVectorizedConvolveLine
+{
+    typedef typename PromoteTraits<SrcValue, KernelValue>::Promote SumType;
+    static const bool value = ConvolveLineVectorizable<SrcValue>::value &&
+                              (IsSameType<KernelValue, float>::value ||
+                               IsSameType<KernelValue, double>::value) &&
+                              (IsSameType<SumType, float>::value ||
+                               IsSameType<SumType, double>::value);
+    typedef typename IfBool<value, VigraTrueType, VigraFalseType>::type type;
+};
+
+// Scratch memory of internalConvolveLineVectorized(). Functions that convolve
+// many lines allocate it once (per thread) and pass it to convolveLineWithBuffer().
+template <class SrcValue, class KernelValue>
+struct ConvolveLineBuffer
+{
+    typedef ArrayVector<typename PromoteTraits<SrcValue, KernelValue>::Promote> type;
+};
+
+// Fallback for types without a vectorized implementation.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor, class Buffer>
+inline bool
+internalConvolveLineVectorized(SrcIterator, SrcIterator, SrcAccessor,
+                               DestIterator, DestAccessor,
+                               KernelIterator, KernelAccessor,
+                               int, int, BorderTreatmentMode,
+                               int, int, Buffer &, VigraFalseType)
+{
+    return false;
+}
+
+// Convolve a line of scalar float, double, or UInt8 values. The line is first
+// copied into a contiguous buffer of SumType, with the border handled while
+// copying, so that the inner loop has no branches and operates on two
+// contiguous arrays. The loop over the kernel taps is the outer loop, which
+// allows the compiler to vectorize the inner loop over the pixels.
+// The summation order is identical to internalConvolveLineOptimistic().
+// 'buffer' holds the copied line and the sums, and only grows when needed.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor, class SumType>
+bool
+internalConvolveLineVectorized(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                               DestIterator id, DestAccessor da,
+                               KernelIterator ik, KernelAccessor ka,
+                               int kleft, int kright, BorderTreatmentMode border,
+                               int start, int stop, ArrayVector<SumType> & buffer,
+                               VigraTrueType)
+{
+    typedef typename AccessorTraits<SumType>::default_accessor TmpAccessor;
+
+    if(stop == 0)
+        stop = std::distance(is, iend);
+
+    int w  = stop - start,
+        kw = kright - kleft + 1;
+
+    if(buffer.size() < (std::size_t)(2*w + kw - 1))
+        buffer.resize(2*w + kw - 1);
+    SumType * line = buffer.begin(),
+            * s    = line + w + kw - 1;
+    copyLineWithBorderTreatment(is, iend, sa, line, TmpAccessor(),
+                                start, stop, kleft, kright, border);
+    std::fill(s, s + w, NumericTraits<SumType>::zero());
+
+    for(int k = 0; k < kw; ++k)
+    {
+        SumType const   c = ka(ik + (kright - k));
+        SumType const * l = line + k;
+        for(int x = 0; x < w; ++x)
+            s[x] += c * l[x];
+    }
+
+    for(int x = 0; x < w; ++x, ++id)
+        da.set(detail::RequiresExplicitCast<typename
+                      DestAccessor::value_type>::cast(s[x]), id);
+    return true;
+}
+
 } // namespace detail
 
 /********************************************************/
@@ -757,6 +870,100 @@ void internalConvolveLineAvoid(SrcIterator is, SrcIterator iend, SrcAccessor sa,
 /*                                                      */
 /********************************************************/
 
+namespace detail {
+
+// Implementation of convolveLine(). 'buffer' is scratch memory for the
+// vectorized code path (see ConvolveLineBuffer), which can be reused
+// for many lines.
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor,
+          class KernelIterator, class KernelAccessor, class Buffer>
+void convolveLineWithBuffer(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                            DestIterator id, DestAccessor da,
+                            KernelIterator ik, KernelAccessor ka,
+                            int kleft, int kright, BorderTreatmentMode border,
+                            int start, int stop, Buffer & buffer)
+{
+    vigra_precondition(kleft <= 0,
+                 "convolveLine(): kleft must be <= 0.\n");
+    vigra_precondition(kright >= 0,
+                 "convolveLine(): kright must be >= 0.\n");
+
+    //    int w = iend - is;
+    int w = std::distance( is, iend );
+
+    vigra_precondition(w >= std::max(kright, -kleft) + 1,
+                 "convolveLine(): kernel longer than line.\n");
+                 
+    if(stop != 0)
+        vigra_precondition(0 <= start && start < stop && stop <= w,
+                        "convolveLine(): invalid subrange (start, stop).\n");
+
+    typedef typename detail::UseVectorizedConvolveLine<
+            typename SrcAccessor::value_type,
+            typename KernelAccessor::value_type>::type UseVectorized;
+
+    if(border == BORDER_TREATMENT_WRAP || border == BORDER_TREATMENT_REFLECT ||
+       border == BORDER_TREATMENT_REPEAT || border == BORDER_TREATMENT_ZEROPAD)
+    {
+        if(detail::internalConvolveLineVectorized(is, iend, sa, id, da, ik, ka,
+                                  kleft, kright, border, start, stop, buffer, UseVectorized()))
+            return;
+    }
+
+    switch(border)
+    {
+      case BORDER_TREATMENT_WRAP:
+      {
+        internalConvolveLineWrap(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_AVOID:
+      {
+        internalConvolveLineAvoid(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_REFLECT:
+      {
+        internalConvolveLineReflect(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_REPEAT:
+      {
+        internalConvolveLineRepeat(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_CLIP:
+      {
+        // find norm of kernel
+        typedef typename KernelAccessor::value_type KT;
+        KT norm = NumericTraits<KT>::zero();
+        KernelIterator iik = ik + kleft;
+        for(int i=kleft; i<=kright; ++i, ++iik)
+            norm += ka(iik);
+
+        vigra_precondition(norm != NumericTraits<KT>::zero(),
+                     "convolveLine(): Norm of kernel must be != 0"
+                     " in mode BORDER_TREATMENT_CLIP.\n");
+
+        internalConvolveLineClip(is, iend, sa, id, da, ik, ka, kleft, kright, norm, start, stop);
+        break;
+      }
+      case BORDER_TREATMENT_ZEROPAD:
+      {
+        internalConvolveLineZeropad(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
+        break;
+      }
+      default:
+      {
+        vigra_precondition(0,
+                     "convolveLine(): Unknown border treatment mode.\n");
+      }
+    }
+}
+
+} // namespace detail
+
 /** \addtogroup SeparableConvolution One-dimensional and separable convolution functions
 
     Perform 1D convolution and separable filtering in 2 dimensions.
@@ -902,76 +1109,10 @@ void convolveLine(SrcIterator is, SrcIterator iend, SrcAccessor sa,
                   int kleft, int kright, BorderTreatmentMode border,
                   int start = 0, int stop = 0)
 {
-    typedef typename KernelAccessor::value_type KernelValue;
-
-    vigra_precondition(kleft <= 0,
-                 "convolveLine(): kleft must be <= 0.\n");
-    vigra_precondition(kright >= 0,
-                 "convolveLine(): kright must be >= 0.\n");
-
-    //    int w = iend - is;
-    int w = std::distance( is, iend );
-
-    vigra_precondition(w >= std::max(kright, -kleft) + 1,
-                 "convolveLine(): kernel longer than line.\n");
-                 
-    if(stop != 0)
-        vigra_precondition(0 <= start && start < stop && stop <= w,
-                        "convolveLine(): invalid subrange (start, stop).\n");
-
-    typedef typename PromoteTraits<
-            typename SrcAccessor::value_type,
-            typename KernelAccessor::value_type>::Promote SumType;
-    ArrayVector<SumType> a(iend - is); 
-    switch(border)
-    {
-      case BORDER_TREATMENT_WRAP:
-      {
-        internalConvolveLineWrap(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_AVOID:
-      {
-        internalConvolveLineAvoid(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_REFLECT:
-      {
-        internalConvolveLineReflect(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_REPEAT:
-      {
-        internalConvolveLineRepeat(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_CLIP:
-      {
-        // find norm of kernel
-        typedef typename KernelAccessor::value_type KT;
-        KT norm = NumericTraits<KT>::zero();
-        KernelIterator iik = ik + kleft;
-        for(int i=kleft; i<=kright; ++i, ++iik)
-            norm += ka(iik);
-
-        vigra_precondition(norm != NumericTraits<KT>::zero(),
-                     "convolveLine(): Norm of kernel must be != 0"
-                     " in mode BORDER_TREATMENT_CLIP.\n");
-
-        internalConvolveLineClip(is, iend, sa, id, da, ik, ka, kleft, kright, norm, start, stop);
-        break;
-      }
-      case BORDER_TREATMENT_ZEROPAD:
-      {
-        internalConvolveLineZeropad(is, iend, sa, id, da, ik, ka, kleft, kright, start, stop);
-        break;
-      }
-      default:
-      {
-        vigra_precondition(0,
-                     "convolveLine(): Unknown border treatment mode.\n");
-      }
-    }
+    typename detail::ConvolveLineBuffer<typename SrcAccessor::value_type,
+                                        typename KernelAccessor::value_type>::type buffer;
+    detail::convolveLineWithBuffer(is, iend, sa, id, da, ik, ka, kleft, kright, border,
+                                   start, stop, buffer);
 }
 
 template <class SrcIterator, class SrcAccessor,
@@ -1107,14 +1248,16 @@ void separableConvolveX(SrcIterator supperleft,
                  "separableConvolveX(): kernel longer than line\n");
 
     int y;
+    typename detail::ConvolveLineBuffer<typename SrcAccessor::value_type,
+                                        KernelValue>::type buffer;
 
     for(y=0; y<h; ++y, ++supperleft.y, ++dupperleft.y)
     {
         typename SrcIterator::row_iterator rs = supperleft.rowIterator();
         typename DestIterator::row_iterator rd = dupperleft.rowIterator();
 
-        convolveLine(rs, rs+w, sa, rd, da,
-                     ik, ka, kleft, kright, border);
+        detail::convolveLineWithBuffer(rs, rs+w, sa, rd, da,
+                                       ik, ka, kleft, kright, border, 0, 0, buffer);
     }
 }
 
@@ -1264,14 +1407,16 @@ void separableConvolveY(SrcIterator supperleft,
                  "separableConvolveY(): kernel longer than line\n");
 
     int x;
+    typename detail::ConvolveLineBuffer<typename SrcAccessor::value_type,
+                                        KernelValue>::type buffer;
 
     for(x=0; x<w; ++x, ++supperleft.x, ++dupperleft.x)
     {
         typename SrcIterator::column_iterator cs = supperleft.columnIterator();
         typename DestIterator::column_iterator cd = dupperleft.columnIterator();
 
-        convolveLine(cs, cs+h, sa, cd, da,
-                     ik, ka, kleft, kright, border);
+        detail::convolveLineWithBuffer(cs, cs+h, sa, cd, da,
+                                       ik, ka, kleft, kright, border, 0, 0, buffer);
     }
 }
 
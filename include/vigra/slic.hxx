@@ -42,6 +42,7 @@
 #include "numerictraits.hxx"
 #include "accumulator.hxx"
 #include "array_vector.hxx"
+#include "threadpool.hxx"
 
 namespace vigra {
 
@@ -150,15 +151,20 @@ generateSlicSeeds(MultiArrayView<N, T, S1> const & boundaryIndicatorImage,
 
 /** \brief Options object for slicSuperpixels().
 
+    Besides the number of threads (inherited from \ref ParallelOptions),
+    this object holds the number of iterations and the minimal superpixel size.
+
     <b> Usage:</b>
 
     see slicSuperpixels() for detailed examples.
 */
 struct SlicOptions
+: public ParallelOptions
 {
         /** \brief Create options object with default settings.
 
-            Defaults are: perform 10 iterations, determine a size limit for superpixels automatically.
+            Defaults are: perform 10 iterations, determine a size limit for superpixels automatically,
+            use as many threads as the hardware supports.
         */
     SlicOptions()
     : iter(10),
@@ -187,6 +193,18 @@ struct SlicOptions
         return *this;
     }
     
+        /** \brief Set the number of threads (see \ref ParallelOptions::numThreads()).
+        
+            The result doesn't depend on the number of threads.
+
+            Default: <tt>ParallelOptions::Auto</tt>
+        */
+    SlicOptions & numThreads(const int n)
+    {
+        ParallelOptions::numThreads(n);
+        return *this;
+    }
+    
     unsigned int iter;
     unsigned int sizeLimit;
 };
@@ -215,7 +233,9 @@ class Slic
     unsigned int execute();
 
   private:
+    void updateStatistics();
     void updateAssigments();
+    void updateAssigments(MultiArrayIndex begin, MultiArrayIndex end);
     unsigned int postProcessing();
     
     typedef MultiArray<N,DistanceType>  DistanceImageType;
@@ -227,10 +247,48 @@ class Slic
     int                             max_radius_;
     DistanceType                    normalization_;
     SlicOptions                     options_;
+    Label                           max_label_;
     
     typedef acc::Select<acc::DataArg<1>, acc::LabelArg<2>, acc::Mean, acc::RegionCenter> Statistics;
     typedef acc::AccumulatorChainArray<CoupledArrays<N, T, Label>, Statistics> RegionFeatures;
     RegionFeatures clusters_;
+    
+        // plain copies of the cluster statistics for the assignment threads
+        // (the accumulators compute Mean and RegionCenter lazily and are not thread-safe)
+    typedef typename acc::LookupTag<acc::RegionCenter, RegionFeatures>::value_type CenterType;
+    typedef typename acc::LookupTag<acc::Mean, RegionFeatures>::value_type MeanType;
+    ArrayVector<bool>               active_;
+    ArrayVector<CenterType>         centers_;
+    ArrayVector<MeanType>           means_;
+    
+        // accumulate the statistics of a contiguous range of points (in scan order)
+    struct StatisticsTask
+    {
+        Slic & slic;
+        ArrayVector<RegionFeatures> & features;
+        
+        void operator()(int, MultiArrayIndex chunk)
+        {
+            MultiArrayIndex size   = slic.labelImage_.size(),
+                            chunks = (MultiArrayIndex)features.size();
+            typename CoupledArrays<N, T, Label>::IteratorType 
+                iter = createCoupledIterator(slic.dataImage_, slic.labelImage_);
+            extractFeatures(iter + chunk*size/chunks, iter + (chunk+1)*size/chunks, features[chunk]);
+        }
+    };
+    
+        // assign the points of a slab (a range of the last coordinate)
+    struct AssignmentTask
+    {
+        Slic & slic;
+        MultiArrayIndex slab_size;
+        
+        void operator()(int, MultiArrayIndex slab)
+        {
+            slic.updateAssigments(slab*slab_size, 
+                                  std::min(slab*slab_size + slab_size, slic.shape_[N-1]));
+        }
+    };
 };
 
 
@@ -248,7 +306,8 @@ Slic<N, T, Label>::Slic(
     distance_(shape_),
     max_radius_(maxRadius),
     normalization_(sq(intensityScaling) / sq(max_radius_)),
-    options_(options)
+    options_(options),
+    max_label_(0)
 {
     clusters_.ignoreLabel(0);
 }
@@ -256,12 +315,15 @@ Slic<N, T, Label>::Slic(
 template <unsigned int N, class T, class Label>
 unsigned int Slic<N, T, Label>::execute()
 {
+    // labels are only reassigned to existing clusters, so the maximum can't grow
+    Label minimum;
+    labelImage_.minmax(&minimum, &max_label_);
+    
     // Do SLIC
     for(size_t i=0; i<options_.iter; ++i)
     {
         // update mean for each cluster
-        clusters_.reset();
-        extractFeatures(dataImage_, labelImage_, clusters_);
+        updateStatistics();
         
         // update which pixels get assigned to which cluster
         updateAssigments();
@@ -270,19 +332,78 @@ unsigned int Slic<N, T, Label>::execute()
     return postProcessing();
 }
 
+template <unsigned int N, class T, class Label>
+void
+Slic<N, T, Label>::updateStatistics()
+{
+    // the threads accumulate a fixed number of contiguous parts of the image,
+    // and the partial results are merged in a fixed order, so that the summation
+    // order (and thus the result) doesn't depend on the number of threads
+    static const MultiArrayIndex statisticsChunks = 16;
+    MultiArrayIndex chunks = std::max<MultiArrayIndex>(
+                                 std::min<MultiArrayIndex>(statisticsChunks, labelImage_.size()), 1);
+    ArrayVector<RegionFeatures> features(chunks);
+    for(MultiArrayIndex k=0; k<chunks; ++k)
+    {
+        features[k].ignoreLabel(0);
+        features[k].setMaxRegionLabel(max_label_);
+    }
+    
+    StatisticsTask task = { *this, features };
+    parallel_foreach(options_, chunks, task);
+    
+    clusters_.reset();
+    for(MultiArrayIndex k=0; k<chunks; ++k)
+        clusters_.merge(features[k]);
+}
+
 template <unsigned int N, class T, class Label>
 void
 Slic<N, T, Label>::updateAssigments()
 {
     using namespace acc;
-    distance_.init(NumericTraits<DistanceType>::max());
-    for(unsigned int c=1; c<=clusters_.maxRegionLabel(); ++c)
+    MultiArrayIndex clusterCount = clusters_.maxRegionLabel() + 1;
+    active_.resize(clusterCount);
+    centers_.resize(clusterCount);
+    means_.resize(clusterCount);
+    for(MultiArrayIndex c=1; c<clusterCount; ++c)
     {
-        if(get<Count>(clusters_, c) == 0) // label doesn't exist
+        active_[c] = get<Count>(clusters_, c) != 0; // label doesn't exist otherwise
+        if(!active_[c])
+            continue;
+        centers_[c] = get<RegionCenter>(clusters_, c);
+        means_[c]   = get<Mean>(clusters_, c);
+    }
+
+    // the threads own disjoint slabs of the image and update the labels and
+    // distances of their points only
+    MultiArrayIndex length    = shape_[N-1],
+                    slabs     = std::max<MultiArrayIndex>(
+                                    std::min<MultiArrayIndex>(length, 4*options_.getActualNumThreads()), 1),
+                    slab_size = std::max<MultiArrayIndex>((length + slabs - 1) / slabs, 1);
+    slabs = (length + slab_size - 1) / slab_size;
+    
+    AssignmentTask task = { *this, slab_size };
+    parallel_foreach(options_, slabs, task);
+}
+
+template <unsigned int N, class T, class Label>
+void
+Slic<N, T, Label>::updateAssigments(MultiArrayIndex begin, MultiArrayIndex end)
+{
+    ShapeType slabStart, slabEnd(shape_);
+    slabStart[N-1] = begin;
+    slabEnd[N-1]   = end;
+    distance_.subarray(slabStart, slabEnd).init(NumericTraits<DistanceType>::max());
+    
+    // since clusters are visited in the same order in every slab, the result 
+    // is independent of the slab decomposition
+    for(unsigned int c=1; c<active_.size(); ++c)
+    {
+        if(!active_[c])
             continue;
             
-        typedef typename LookupTag<RegionCenter, RegionFeatures>::value_type CenterType;
-        CenterType center = get<RegionCenter>(clusters_, c);
+        CenterType center = centers_[c];
 
         // get ROI limits around region center
         ShapeType pixelCenter(round(center)), 
@@ -290,18 +411,25 @@ Slic<N, T, Label>::updateAssigments()
                   endCoord(min(shape_, pixelCenter + ShapeType(max_radius_+1)));
         center -= startCoord; // need center relative to ROI
         
+        // restrict ROI to the current slab
+        ShapeType roiStart(max(startCoord, slabStart)),
+                  roiEnd(min(endCoord, slabEnd)),
+                  roiOffset(roiStart - startCoord);
+        if(roiStart[N-1] >= roiEnd[N-1])
+            continue;
+        
         // setup iterators for ROI
         typedef typename CoupledArrays<N, T, Label, DistanceType>::IteratorType Iterator;
         Iterator iter = createCoupledIterator(dataImage_, labelImage_, distance_).
-                            restrictToSubarray(startCoord, endCoord),
+                            restrictToSubarray(roiStart, roiEnd),
                  end = iter.getEndIterator();
         
         // only pixels within the ROI can be assigned to a cluster
         for(; iter != end; ++iter)
         {
             // compute distance between cluster center and pixel
-            DistanceType spatialDist   = squaredNorm(center-iter.point());
-            DistanceType colorDist     = squaredNorm(get<Mean>(clusters_, c)-iter.template get<1>());
+            DistanceType spatialDist   = squaredNorm(center-(iter.point()+roiOffset));
+            DistanceType colorDist     = squaredNorm(means_[c]-iter.template get<1>());
             DistanceType dist =  colorDist + normalization_*spatialDist;
             // update label?
             if(dist < iter.template get<3>())
@@ -413,9 +541,12 @@ Slic<N, T, Label>::postProcessing()
     before it is compared with the spatial distance. This corresponds to parameter <i>m</i> in equation
     (2) of the paper.
     
-    The options object can be used to specify the number of iterations (<tt>SlicOptions::iterations()</tt>)
-    and an explicit minimal superpixel size (<tt>SlicOptions::minSize()</tt>). By default, the algorithm 
-    merges all regions that are smaller than 1/4 of the average superpixel size.
+    The options object can be used to specify the number of iterations (<tt>SlicOptions::iterations()</tt>),
+    an explicit minimal superpixel size (<tt>SlicOptions::minSize()</tt>), and the number of threads
+    (<tt>SlicOptions::numThreads()</tt>). By default, the algorithm merges all regions that are smaller 
+    than 1/4 of the average superpixel size. In each iteration, the region statistics are accumulated 
+    in parallel over disjoint parts of the array and then merged, and the points are reassigned in 
+    parallel slabs whose owner thread considers all clusters whose search window intersects the slab.
     
     The function returns the number of superpixels, which equals the largest label 
     because labeling starts at 1.
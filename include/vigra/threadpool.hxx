@@ -0,0 +1,287 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef VIGRA_THREADPOOL_HXX
+#define VIGRA_THREADPOOL_HXX
+
+#include <algorithm>
+#include "config.hxx"
+#include "error.hxx"
+#include "multi_shape.hxx"
+
+#ifdef VIGRA_HAS_STD_THREADS
+# include <thread>
+# include <mutex>
+# include <atomic>
+# include <exception>
+# include <vector>
+#endif
+
+namespace vigra {
+
+/** \addtogroup ParallelProcessing Functions and classes for parallel processing.
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                    ParallelOptions                   */
+/*                                                      */
+/********************************************************/
+
+    /** \brief Option base class for parallel algorithms.
+
+        The number of threads can be given explicitly or by one of the
+        special values <tt>ParallelOptions::Auto</tt> (use as many threads
+        as there are cores, the default), <tt>ParallelOptions::Nice</tt>
+        (use half as many threads as there are cores) and
+        <tt>ParallelOptions::Serial</tt> (run in the calling thread only).
+        When VIGRA is compiled without support for <tt>std::thread</tt>
+        (i.e. <tt>VIGRA_HAS_STD_THREADS</tt> is undefined), all algorithms
+        run serially regardless of this setting.
+
+        <b>\#include</b> \<vigra/threadpool.hxx\><br>
+        Namespace: vigra
+    */
+class ParallelOptions
+{
+  public:
+
+    enum {
+        Auto       = -1, ///< Determine number of threads automatically (from <tt>std::thread::hardware_concurrency()</tt>)
+        Nice       = -2, ///< Use half as many threads as <tt>Auto</tt> would.
+        Serial     =  0  ///< Switch off multi-threading (i.e. execute tasks sequentially)
+    };
+
+    ParallelOptions()
+    :  numThreads_(actualNumThreads(Auto))
+    {}
+
+        /** Construct with the given number of threads or one of the constants
+            <tt>Auto</tt>, <tt>Nice</tt> and <tt>Serial</tt>.
+        */
+    explicit ParallelOptions(const int n)
+    :  numThreads_(actualNumThreads(n))
+    {}
+
+        /** \brief Get desired number of threads.
+
+            <b>Note:</b> This function may return 0, which means that multi-threading
+            shall be switched off entirely. If an algorithm receives this value,
+            it should revert to a sequential implementation.
+        */
+    int getNumThreads() const
+    {
+        return numThreads_;
+    }
+
+        /** \brief Get desired number of threads.
+
+            In contrast to <tt>getNumThreads()</tt>, this will always return a value <tt>>=1</tt>.
+        */
+    int getActualNumThreads() const
+    {
+        return std::max(1, numThreads_);
+    }
+
+        /** \brief Set the number of threads or one of the constants <tt>Auto</tt>,
+                   <tt>Nice</tt> and <tt>Serial</tt>.
+
+            Default: <tt>Auto</tt>
+        */
+    ParallelOptions & numThreads(const int n)
+    {
+        numThreads_ = actualNumThreads(n);
+        return *this;
+    }
+
+  private:
+    static int actualNumThreads(const int userNThreads)
+    {
+#ifdef VIGRA_HAS_STD_THREADS
+        int cores = (int)std::thread::hardware_concurrency();
+        return userNThreads >= 0
+                   ? userNThreads
+                   : userNThreads == Nice
+                           ? cores / 2
+                           : cores;
+#else
+        return 0;
+#endif
+    }
+
+    int numThreads_;
+};
+
+namespace detail {
+
+#ifdef VIGRA_HAS_STD_THREADS
+
+template <class FUNCTOR>
+class ParallelForeachWorker
+{
+  public:
+    ParallelForeachWorker(FUNCTOR & f, MultiArrayIndex count,
+                          std::atomic<MultiArrayIndex> & next,
+                          std::exception_ptr & error, std::mutex & error_lock)
+    : f_(f)
+    , count_(count)
+    , next_(next)
+    , error_(error)
+    , error_lock_(error_lock)
+    {}
+
+    void operator()(int threadId)
+    {
+        try
+        {
+            for(MultiArrayIndex i = next_++; i < count_; i = next_++)
+                f_(threadId, i);
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(error_lock_);
+            if(!error_)
+                error_ = std::current_exception();
+            next_ = count_;  // let the other threads stop early
+        }
+    }
+
+  private:
+    FUNCTOR & f_;
+    MultiArrayIndex count_;
+    std::atomic<MultiArrayIndex> & next_;
+    std::exception_ptr & error_;
+    std::mutex & error_lock_;
+};
+
+#endif // VIGRA_HAS_STD_THREADS
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                   parallel_foreach                   */
+/*                                                      */
+/********************************************************/
+
+    /** \brief Apply a functor to all indices <tt>0 ... count-1</tt> in parallel.
+
+        The functor is called as <tt>f(threadId, index)</tt>, where
+        <tt>0 <= threadId < options.getActualNumThreads()</tt> identifies the
+        worker thread executing the call. Algorithms can use the thread ID
+        to access per-thread scratch memory without locking. Indices are
+        handed out dynamically, so tasks of varying cost are balanced
+        automatically. The calling thread participates in the work (as thread 0),
+        and the function returns after all indices have been processed.
+        If the functor throws, remaining indices are skipped and the first
+        exception is re-thrown in the calling thread.
+
+        The functor is shared by all threads, so its <tt>operator()</tt> must be
+        thread-safe. When <tt>options.getNumThreads() <= 1</tt> or VIGRA was compiled
+        without thread support, the indices are processed sequentially in the
+        calling thread.
+
+        There is no persistent thread pool: each call starts up to 
+        <tt>options.getActualNumThreads()-1</tt> new threads and joins them before 
+        returning. Thread creation costs some tens of microseconds, so the work
+        per call should be considerably larger than that. If a thread cannot be
+        started, the threads already running are stopped and joined, and the
+        <tt>std::system_error</tt> is propagated to the caller.
+
+        <b>\#include</b> \<vigra/threadpool.hxx\><br>
+        Namespace: vigra
+
+        \code
+        struct SquareFunctor
+        {
+            MultiArrayView<1, double> data;
+
+            void operator()(int threadId, MultiArrayIndex i)
+            {
+                data(i) *= data(i);
+            }
+        };
+
+        SquareFunctor f = { array };
+        parallel_foreach(ParallelOptions().numThreads(4), array.size(), f);
+        \endcode
+    */
+template <class FUNCTOR>
+void
+parallel_foreach(ParallelOptions const & options, MultiArrayIndex count, FUNCTOR & f)
+{
+    int nThreads = (int)std::min<MultiArrayIndex>(options.getActualNumThreads(), count);
+#ifdef VIGRA_HAS_STD_THREADS
+    if(nThreads > 1)
+    {
+        std::atomic<MultiArrayIndex> next(0);
+        std::exception_ptr error;
+        std::mutex error_lock;
+        detail::ParallelForeachWorker<FUNCTOR> worker(f, count, next, error, error_lock);
+
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads - 1);
+        try
+        {
+            for(int k=1; k<nThreads; ++k)
+                threads.push_back(std::thread(worker, k));
+        }
+        catch(...)
+        {
+            // a thread could not be started: stop and join the running ones,
+            // because destroying a joinable std::thread calls std::terminate()
+            next = count;
+            for(unsigned int k=0; k<threads.size(); ++k)
+                threads[k].join();
+            throw;
+        }
+        worker(0);
+        for(unsigned int k=0; k<threads.size(); ++k)
+            threads[k].join();
+        if(error)
+            std::rethrow_exception(error);
+        return;
+    }
+#endif
+    for(MultiArrayIndex i=0; i<count; ++i)
+        f(0, i);
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_THREADPOOL_HXX
@@ -255,7 +255,72 @@ struct ConvolutionTest
             shouldEqualSequence(out, out+outsize-ksize, r);
         }
     }
-    
+
+    template <class T>
+    void vectorizedConvolveLineTestImpl(double tolerance)
+    {
+        static const int size = 37;
+        typedef vigra::StandardConstValueAccessor<T> SrcAccessor;
+        typedef vigra::StandardValueAccessor<double> DestAccessor;
+
+        T data[size];
+        for(int k=0; k<size; ++k)
+            data[k] = T((k*37 + 11) % 101 + 0.5);
+
+        vigra::Kernel1D<double> kernels[2];
+        kernels[0].initGaussian(2.0);
+        kernels[1].initExplicitly(-1, 3) = 0.1, 0.3, -0.2, 0.5, 0.25;
+
+        vigra::BorderTreatmentMode modes[] = { vigra::BORDER_TREATMENT_WRAP, vigra::BORDER_TREATMENT_REFLECT,
+                                               vigra::BORDER_TREATMENT_REPEAT, vigra::BORDER_TREATMENT_ZEROPAD };
+        int ranges[][2] = { {0, 0}, {3, 30}, {0, 1}, {size-1, size} };
+
+        for(int kernel=0; kernel<2; ++kernel)
+        {
+            vigra::Kernel1D<double> const & k = kernels[kernel];
+            for(int mode=0; mode<4; ++mode)
+            {
+                for(int range=0; range<4; ++range)
+                {
+                    int start = ranges[range][0], stop = ranges[range][1],
+                        w = stop == 0 ? size : stop - start;
+                    double res[size], ref[size];
+
+                    vigra::convolveLine(data, data+size, SrcAccessor(), res, DestAccessor(),
+                                        k.center(), k.accessor(), k.left(), k.right(), modes[mode],
+                                        start, stop);
+                    switch(modes[mode])
+                    {
+                      case vigra::BORDER_TREATMENT_WRAP:
+                        vigra::internalConvolveLineWrap(data, data+size, SrcAccessor(), ref, DestAccessor(),
+                                        k.center(), k.accessor(), k.left(), k.right(), start, stop);
+                        break;
+                      case vigra::BORDER_TREATMENT_REFLECT:
+                        vigra::internalConvolveLineReflect(data, data+size, SrcAccessor(), ref, DestAccessor(),
+                                        k.center(), k.accessor(), k.left(), k.right(), start, stop);
+                        break;
+                      case vigra::BORDER_TREATMENT_REPEAT:
+                        vigra::internalConvolveLineRepeat(data, data+size, SrcAccessor(), ref, DestAccessor(),
+                                        k.center(), k.accessor(), k.left(), k.right(), start, stop);
+                        break;
+                      default:
+                        vigra::internalConvolveLineZeropad(data, data+size, SrcAccessor(), ref, DestAccessor(),
+                                        k.center(), k.accessor(), k.left(), k.right(), start, stop);
+                    }
+                    for(int x=0; x<w; ++x)
+                        should(std::abs(res[x] - ref[x]) < tolerance);
+                }
+            }
+        }
+    }
+
+    void vectorizedConvolveLineTest()
+    {
+        vectorizedConvolveLineTestImpl<float>(1e-4);
+        vectorizedConvolveLineTestImpl<double>(1e-12);
+        vectorizedConvolveLineTestImpl<vigra::UInt8>(1e-12);
+    }
+
     void initExplicitlyTest()
     {
         vigra::Kernel1D<double> k;
@@ -2439,6 +2504,7 @@ struct ConvolutionTestSuite
     : vigra::test_suite("ConvolutionTestSuite")
     {
         add( testCase( &ConvolutionTest::borderCopyTest));
+        add( testCase( &ConvolutionTest::vectorizedConvolveLineTest));
 
 #if 1
         add( testCase( &ConvolutionTest::initExplicitlyTest));
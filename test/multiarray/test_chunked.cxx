@@ -0,0 +1,340 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2013 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <iostream>
+#include "vigra/unittest.hxx"
+#include "vigra/multi_array_chunked.hxx"
+#ifdef HasHDF5
+# include "vigra/multi_array_chunked_hdf5.hxx"
+#endif
+
+using namespace vigra;
+
+template <class Array>
+struct ChunkedArrayFactory
+{
+    static Array * create(typename Array::shape_type const & shape,
+                          typename Array::shape_type const & chunk_shape,
+                          ChunkedArrayOptions const & options)
+    {
+        return new Array(shape, chunk_shape, options);
+    }
+};
+
+#ifdef HasHDF5
+
+template <class T>
+struct ChunkedArrayFactory<ChunkedArrayHDF5<3, T> >
+{
+    typedef ChunkedArrayHDF5<3, T> Array;
+
+    static Array * create(typename Array::shape_type const & shape,
+                          typename Array::shape_type const & chunk_shape,
+                          ChunkedArrayOptions const & options)
+    {
+        // every array gets its own dataset in a file that outlives all arrays
+        static HDF5File file("chunked_generic_test.h5", HDF5File::New);
+        static int count = 0;
+        return new Array(file, "data" + asString(count++), HDF5File::New,
+                         shape, chunk_shape, options);
+    }
+};
+
+#endif
+
+template <class Array>
+class ChunkedMultiArrayTest
+{
+public:
+
+    typedef typename Array::shape_type Shape;
+    typedef typename Array::value_type T;
+    typedef MultiArray<3, T> PlainArray;
+
+    Shape shape, chunk_shape;
+    PlainArray ref;
+
+    ChunkedMultiArrayTest ()
+    : shape(20, 21, 22)
+    , chunk_shape(8)
+    , ref(shape)
+    {
+        linearSequence(ref.begin(), ref.end());
+    }
+
+    Array * create(ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    {
+        return ChunkedArrayFactory<Array>::create(shape, chunk_shape, options);
+    }
+
+    void test_construction ()
+    {
+        VIGRA_UNIQUE_PTR<Array> a(create(ChunkedArrayOptions().fillValue(3)));
+
+        shouldEqual(a->shape(), shape);
+        shouldEqual(a->chunkShape(), chunk_shape);
+        shouldEqual(a->chunkArrayShape(), Shape(3));
+        shouldEqual(a->chunkShape(Shape(2)), Shape(4, 5, 6));
+        shouldEqual(a->size(), prod(shape));
+        shouldEqual(a->cacheSize(), 0u);
+        shouldEqual(a->getItem(Shape(19, 20, 21)), 3);
+
+        try
+        {
+            VIGRA_UNIQUE_PTR<Array> b(ChunkedArrayFactory<Array>::create(shape, Shape(8, 6, 8),
+                                                                         ChunkedArrayOptions()));
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation & c)
+        {
+            std::string expected("\nPrecondition violation!\nChunkedArray(): chunk_shape elements must be powers of 2.");
+            std::string message(c.what());
+            should(0 == expected.compare(message.substr(0,expected.size())));
+        }
+    }
+
+    void test_items ()
+    {
+        VIGRA_UNIQUE_PTR<Array> a(create());
+
+        MultiCoordinateIterator<3> i(shape), end(i.getEndIterator());
+        for(; i != end; ++i)
+            a->setItem(*i, ref[*i]);
+        for(i = MultiCoordinateIterator<3>(shape); i != end; ++i)
+            shouldEqual(a->getItem(*i), ref[*i]);
+
+        try
+        {
+            a->getItem(shape);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &)
+        {}
+    }
+
+    void test_subarray ()
+    {
+        VIGRA_UNIQUE_PTR<Array> a(create());
+        a->commitSubarray(Shape(0), ref);
+
+        Shape start(3, 5, 7), stop(17, 19, 20);
+        PlainArray sub(stop - start);
+        a->checkoutSubarray(start, sub);
+        should(sub == ref.subarray(start, stop));
+        should(a->subarray(start, stop) == ref.subarray(start, stop));
+
+        // modify a region and write it back
+        sub += T(1);
+        a->commitSubarray(start, sub);
+        PlainArray all(shape);
+        a->checkoutSubarray(Shape(0), all);
+        should(all.subarray(start, stop) == sub);
+        should(all.subarray(Shape(0), Shape(3, 21, 22)) == ref.subarray(Shape(0), Shape(3, 21, 22)));
+
+        // strided target views
+        PlainArray transposed(Shape(13, 14, 14));
+        a->checkoutSubarray(start, transposed.transpose());
+        should(transposed.transpose() == sub);
+    }
+
+    void test_chunk_iterator ()
+    {
+        VIGRA_UNIQUE_PTR<Array> a(create());
+        a->commitSubarray(Shape(0), ref);
+
+        Shape start(3, 5, 7), stop(17, 19, 20);
+        typename Array::chunk_iterator i = a->chunk_begin(start, stop),
+                                       end = a->chunk_end(start, stop);
+        int count = 0;
+        for(; i != end; ++i, ++count)
+        {
+            should(*i == ref.subarray(i.chunkStart(), i.chunkStop()));
+            *i = T(count);
+        }
+        shouldEqual(count, 27);
+
+        count = 0;
+        for(i = a->chunk_begin(start, stop); i != end; ++i, ++count)
+        {
+            shouldEqual(a->getItem(i.chunkStart()), T(count));
+            shouldEqual(a->getItem(i.chunkStop()-Shape(1)), T(count));
+        }
+        shouldEqual(a->getItem(start-Shape(1)), ref[start-Shape(1)]);
+    }
+
+    void test_cache ()
+    {
+        VIGRA_UNIQUE_PTR<Array> a(create(ChunkedArrayOptions().cacheMax(4)));
+        a->commitSubarray(Shape(0), ref);
+        should(a->cacheSize() <= 4u);
+
+        // read everything twice to force reloading of swapped-out chunks
+        for(int k=0; k<2; ++k)
+        {
+            PlainArray all(shape);
+            a->checkoutSubarray(Shape(0), all);
+            should(all == ref);
+            should(a->cacheSize() <= 4u);
+        }
+
+        // iterators lock their chunk in memory, even if the cache is too small
+        a->setCacheMaxSize(1);
+        shouldEqual(a->cacheSize(), 1u);
+        typename Array::chunk_iterator i = a->chunk_begin(Shape(0), shape),
+                                       j = a->chunk_begin(Shape(0), shape);
+        ++j;
+        should(*i == ref.subarray(i.chunkStart(), i.chunkStop()));
+        should(*j == ref.subarray(j.chunkStart(), j.chunkStop()));
+        shouldEqual(a->cacheSize(), 2u);
+    }
+
+    void test_release ()
+    {
+        VIGRA_UNIQUE_PTR<Array> a(create(ChunkedArrayOptions().fillValue(1)));
+        a->commitSubarray(Shape(0), ref);
+
+        // keep the data
+        a->releaseChunks(Shape(0), shape);
+        shouldEqual(a->cacheSize(), 0u);
+        should(a->subarray(Shape(0), shape) == ref);
+
+        // destroy the data of the first chunk only
+        a->releaseChunks(Shape(0), Shape(12), true);
+        PlainArray all(a->subarray(Shape(0), shape));
+        should(all.subarray(Shape(0), Shape(8)) == PlainArray(Shape(8), T(1)));
+        should(all.subarray(Shape(8, 0, 0), shape) == ref.subarray(Shape(8, 0, 0), shape));
+    }
+};
+
+#ifdef HasHDF5
+
+class ChunkedMultiArrayHDF5Test
+{
+public:
+    typedef ChunkedArrayHDF5<3, float> Array;
+    typedef Array::shape_type Shape;
+
+    void test_hdf5 ()
+    {
+        Shape shape(20, 21, 22);
+        MultiArray<3, float> ref(shape);
+        linearSequence(ref.begin(), ref.end());
+
+        HDF5File file("chunked_test.h5", HDF5File::New);
+        {
+            Array a(file, "data", HDF5File::New, shape, Shape(8), ChunkedArrayOptions().cacheMax(3));
+            shouldEqual(a.getItem(Shape(1)), 0.0f);
+            a.commitSubarray(Shape(0), ref);
+            should(a.subarray(Shape(0), shape) == ref);
+        }
+        {
+            Array a(file, "data");
+            should(a.isReadOnly());
+            shouldEqual(a.shape(), shape);
+            should(a.subarray(Shape(0), shape) == ref);
+        }
+        MultiArray<3, float> data;
+        file.readAndResize("data", data);
+        should(data == ref);
+
+        // read-only arrays reject writes
+        {
+            Array a(file, "data");
+            try
+            {
+                a.setItem(Shape(1), 42.0f);
+                failTest("no exception thrown");
+            }
+            catch(PreconditionViolation & c)
+            {
+                std::string expected("\nPrecondition violation!\nChunkedArray::getChunk(): cannot write to a read-only array.");
+                std::string message(c.what());
+                should(0 == expected.compare(message.substr(0,expected.size())));
+            }
+            shouldEqual(a.getItem(Shape(1)), ref[Shape(1)]);
+        }
+
+        // existing datasets are opened with their own chunk shape
+        file.createDataset<3, float>("chunks", shape, 0.0f, Shape(4, 8, 16));
+        file.createDataset<3, float>("odd_chunks", shape, 0.0f, Shape(5, 8, 16));
+        {
+            Array a(file, "chunks");
+            shouldEqual(a.chunkShape(), Shape(4, 8, 16));
+            Array b(file, "odd_chunks", HDF5File::Open, Shape(), Shape(8));
+            shouldEqual(b.chunkShape(), Shape(8));
+            Array c(file, "odd_chunks");
+            shouldEqual(c.chunkShape(), Shape(8, 8, 16));
+        }
+    }
+};
+
+#endif
+
+template <class Array>
+void addChunkedTests(vigra::test_suite & suite)
+{
+    suite.add( testCase( &ChunkedMultiArrayTest<Array>::test_construction ) );
+    suite.add( testCase( &ChunkedMultiArrayTest<Array>::test_items ) );
+    suite.add( testCase( &ChunkedMultiArrayTest<Array>::test_subarray ) );
+    suite.add( testCase( &ChunkedMultiArrayTest<Array>::test_chunk_iterator ) );
+    suite.add( testCase( &ChunkedMultiArrayTest<Array>::test_cache ) );
+    suite.add( testCase( &ChunkedMultiArrayTest<Array>::test_release ) );
+}
+
+struct ChunkedMultiArrayTestSuite
+: public vigra::test_suite
+{
+    ChunkedMultiArrayTestSuite()
+    : vigra::test_suite("ChunkedMultiArrayTestSuite")
+    {
+        addChunkedTests<ChunkedArrayLazy<3, float> >(*this);
+        addChunkedTests<ChunkedArrayLazy<3, int> >(*this);
+        addChunkedTests<ChunkedArrayTmpFile<3, float> >(*this);
+        addChunkedTests<ChunkedArrayTmpFile<3, double> >(*this);
+#ifdef HasHDF5
+        addChunkedTests<ChunkedArrayHDF5<3, float> >(*this);
+        add( testCase( &ChunkedMultiArrayHDF5Test::test_hdf5 ) );
+#endif
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    ChunkedMultiArrayTestSuite test;
+    int failed = test.run(vigra::testsToBeExecuted(argc, argv));
+    std::cout << test.report() << std::endl;
+
+    return (failed != 0);
+}
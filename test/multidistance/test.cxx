@@ -1071,6 +1071,167 @@ struct MultiDistanceTest
         shouldEqualSequence(res1.data(), res1.data()+res1.elementCount(), res2.data());
     }
 
+    void testDistanceParallel()
+    {
+        typedef MultiArrayShape<3>::type Shape;
+        MultiArrayView<3, double> vol(Shape(12,10,35), volume_data);
+        TinyVector<double, 3> pixelPitch(1.0, 1.5, 1.0);
+
+        MultiArray<3, double> res1(vol.shape()), res2(vol.shape());
+        MultiArray<3, UInt16> res3(vol.shape()), res4(vol.shape());
+
+        separableMultiDistSquared(vol, res1, true, pixelPitch);
+        separableMultiDistSquared(vol, res2, true, pixelPitch, ParallelOptions(4));
+        shouldEqualSequence(res1.begin(), res1.end(), res2.begin());
+
+        // work directly on the destination array
+        separableMultiDistSquared(vol, res3, false, TinyVector<int, 3>(1));
+        separableMultiDistSquared(vol, res4, false, TinyVector<int, 3>(1), ParallelOptions(3));
+        shouldEqualSequence(res3.begin(), res3.end(), res4.begin());
+
+        separableMultiDistance(vol.transpose(), res2.transpose(), false, pixelPitch, ParallelOptions(2));
+        separableMultiDistance(vol.transpose(), res1.transpose(), false, pixelPitch);
+        shouldEqualSequence(res1.begin(), res1.end(), res2.begin());
+    }
+
+    void testVectorDistance()
+    {
+        typedef MultiArrayShape<3>::type Shape;
+        MultiArrayView<3, double> vol(Shape(12,10,35), volume_data);
+        TinyVector<double, 3> pixelPitch(1.2, 1.0, 2.4);
+
+        MultiArray<3, TinyVector<int, 3> > vectors(vol.shape());
+        MultiArray<3, double> dist(vol.shape());
+
+        for(int background = 0; background < 2; ++background)
+        {
+            separableVectorDistance(vol, vectors, background == 1, pixelPitch);
+            separableMultiDistSquared(vol, dist, background == 1, pixelPitch);
+
+            for(MultiCoordinateIterator<3> p(vol.shape()), end = p.getEndIterator(); p != end; ++p)
+            {
+                // the vectors point to a feature at the correct distance
+                Shape nearest = *p + vectors[*p];
+                should(vol.isInside(nearest));
+                if(background == 1)
+                    should(vol[nearest] != 0.0);
+                else
+                    should(vol[nearest] == 0.0);
+                shouldEqualTolerance(squaredNorm(pixelPitch*vectors[*p]), dist[*p], 1e-10);
+            }
+        }
+
+        // Voronoi assignment of three seeds
+        MultiArray<2, int> seeds(Shape2(20, 15)), voronoi(seeds.shape());
+        MultiArray<2, TinyVector<int, 2> > nearest(seeds.shape());
+        seeds(2, 3) = 1;
+        seeds(17, 4) = 2;
+        seeds(9, 13) = 3;
+        separableVectorDistance(seeds, nearest, true);
+        for(MultiCoordinateIterator<2> p(seeds.shape()), end = p.getEndIterator(); p != end; ++p)
+        {
+            voronoi[*p] = seeds[*p + nearest[*p]];
+            double d1 = squaredNorm(*p - Shape2(2, 3)),
+                   d2 = squaredNorm(*p - Shape2(17, 4)),
+                   d3 = squaredNorm(*p - Shape2(9, 13));
+            if(d1 < d2 && d1 < d3)
+                shouldEqual(voronoi[*p], 1);
+            if(d2 < d1 && d2 < d3)
+                shouldEqual(voronoi[*p], 2);
+            if(d3 < d1 && d3 < d2)
+                shouldEqual(voronoi[*p], 3);
+        }
+    }
+
+    void testDistanceL1AndLInf()
+    {
+        typedef MultiArrayShape<3>::type Shape;
+        MultiArrayView<3, double> vol(Shape(12,10,35), volume_data);
+        MultiArray<3, int> l1(vol.shape()), linf(vol.shape());
+
+        for(int background = 0; background < 2; ++background)
+        {
+            separableMultiDistanceL1(vol, l1, background == 1);
+            separableMultiDistanceLInf(vol, linf, background == 1);
+
+            for(MultiCoordinateIterator<3> p(vol.shape()), end = p.getEndIterator(); p != end; ++p)
+            {
+                int d1 = NumericTraits<int>::max(), dinf = NumericTraits<int>::max();
+                for(MultiCoordinateIterator<3> q(vol.shape()); q != end; ++q)
+                {
+                    if((vol[*q] != 0.0) != (background == 1))
+                        continue;
+                    Shape diff = abs(*p - *q);
+                    d1 = std::min(d1, (int)sum(diff));
+                    dinf = std::min(dinf, (int)max(diff));
+                }
+                shouldEqual(l1[*p], d1);
+                shouldEqual(linf[*p], dinf);
+            }
+        }
+    }
+
+    // distance between the center of p and the cell of q
+    template <class Shape, class Pitch>
+    static double cellDistance(Shape const & p, Shape const & q, Pitch const & pixelPitch)
+    {
+        double d = 0.0;
+        for(int k=0; k<Shape::static_size; ++k)
+            d += sq(pixelPitch[k]*std::max(0.0, std::abs(double(p[k] - q[k])) - 0.5));
+        return std::sqrt(d);
+    }
+
+    void testSignedDistance()
+    {
+        typedef MultiArrayShape<3>::type Shape;
+        MultiArrayView<3, double> vol(Shape(12,10,35), volume_data);
+
+        TinyVector<double, 3> pitches[] = { TinyVector<double, 3>(1.0), 
+                                            TinyVector<double, 3>(1.0, 1.0, 3.5),
+                                            TinyVector<double, 3>(1.2, 1.0, 2.4) };
+        for(int i=0; i<3; ++i)
+        {
+            // compare with the brute-force distance to the nearest cell of the other class
+            MultiArray<3, float> res(vol.shape());
+            signedMultiDistance(vol, res, pitches[i]);
+
+            for(MultiCoordinateIterator<3> p(vol.shape()), end = p.getEndIterator(); p != end; ++p)
+            {
+                bool inside = vol[*p] != 0.0;
+                double d = NumericTraits<double>::max();
+                for(MultiCoordinateIterator<3> q(vol.shape()); q != end; ++q)
+                    if((vol[*q] != 0.0) != inside)
+                        d = std::min(d, cellDistance(*p, *q, pitches[i]));
+                shouldEqualTolerance(res[*p], inside ? -d : d, 1e-5);
+            }
+        }
+        {
+            // the interface is crossed along z with pitch 3.5
+            MultiArray<3, UInt8> mask(Shape(4, 4, 6));
+            mask.subarray(Shape(0, 0, 0), Shape(4, 4, 3)) = 1;
+            MultiArray<3, double> res(mask.shape());
+            signedMultiDistance(mask, res, TinyVector<double, 3>(1.0, 1.0, 3.5));
+            shouldEqual(res(1, 2, 2), -1.75);
+            shouldEqual(res(1, 2, 3), 1.75);
+            shouldEqual(res(0, 0, 5), 8.75);
+        }
+        {
+            // the interface of a half space lies between the voxels
+            MultiArray<2, UInt8> mask(Shape2(8, 6));
+            mask.subarray(Shape2(0, 0), Shape2(8, 3)) = 1;
+            MultiArray<2, int> res(mask.shape());
+            MultiArray<2, double> dres(mask.shape());
+            signedMultiDistance(mask, dres);
+            for(int y=0; y<6; ++y)
+                for(int x=0; x<8; ++x)
+                    shouldEqual(dres(x, y), y - 2.5);
+            // integer destination with pixel pitch 2
+            signedMultiDistance(mask, res, Shape2(2, 2));
+            shouldEqual(res(0, 0), -5);
+            shouldEqual(res(0, 5), 5);
+        }
+    }
+
     void testDistanceVolumesAnisoptopic()
     {    
         double epsilon = 1e-14;
@@ -1157,7 +1318,11 @@ struct SimpleAnalysisTestSuite
     {
         add( testCase( &MultiDistanceTest::testDistanceVolumes));
         add( testCase( &MultiDistanceTest::testDistanceAxesPermutation));
+        add( testCase( &MultiDistanceTest::testDistanceParallel));
         add( testCase( &MultiDistanceTest::testDistanceVolumesAnisoptopic));
+        add( testCase( &MultiDistanceTest::testVectorDistance));
+        add( testCase( &MultiDistanceTest::testDistanceL1AndLInf));
+        add( testCase( &MultiDistanceTest::testSignedDistance));
         add( testCase( &MultiDistanceTest::distanceTransform2DCompare));
         add( testCase( &MultiDistanceTest::distanceTest1D));
     }
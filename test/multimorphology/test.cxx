@@ -37,8 +37,13 @@
 #include "vigra/unittest.hxx"
 #include "vigra/stdimage.hxx"
 #include "vigra/multi_morphology.hxx"
+#include "vigra/multi_rank_filter.hxx"
+#include "vigra/multi_reconstruction.hxx"
+#include "vigra/multi_component_tree.hxx"
+#include "vigra/multi_labeling.hxx"
 #include "vigra/linear_algebra.hxx"
 #include "vigra/matrix.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -290,6 +295,445 @@ struct MultiMorphologyTest
         multiGrayscaleDilation(srcMultiArrayRange(tmp), destMultiArray(res),2);
     }
     
+    template <class Array, class Shape, class Best>
+    typename Array::value_type
+    bruteForceMorphology(Array const & a, Shape const & p,
+                         Shape const & lower, Shape const & upper, Best best)
+    {
+        typename Array::value_type res = a[p];
+        for(MultiCoordinateIterator<3> q(upper - lower + Shape(1)), end = q.getEndIterator(); q != end; ++q)
+        {
+            Shape r(p + lower + *q);
+            if(a.isInside(r))
+                res = best(res, a[r]);
+        }
+        return res;
+    }
+
+    void boxMorphologyTest3D()
+    {
+        typedef MultiArray<3, UInt8> Volume;
+        typedef Volume::difference_type Shape;
+        Shape shape(23, 18, 15), radius(3, 0, 5);
+
+        Volume in(shape);
+        for(int k=0; k<in.size(); ++k)
+            in[k] = (UInt8)randomMT19937().uniformInt(256);
+
+        Volume er(shape), di(shape), op(shape), cl(shape), ref(shape);
+        multiGrayscaleBoxErosion(in, er, radius);
+        multiGrayscaleBoxDilation(in, di, radius);
+        multiGrayscaleBoxOpening(in, op, radius);
+        multiGrayscaleBoxClosing(in, cl, radius);
+
+        for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+        {
+            shouldEqual(er[*p], bruteForceMorphology(in, *p, -radius, radius, detail::MorphologyMinimum()));
+            shouldEqual(di[*p], bruteForceMorphology(in, *p, -radius, radius, detail::MorphologyMaximum()));
+        }
+        for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+        {
+            shouldEqual(op[*p], bruteForceMorphology(er, *p, -radius, radius, detail::MorphologyMaximum()));
+            shouldEqual(cl[*p], bruteForceMorphology(di, *p, -radius, radius, detail::MorphologyMinimum()));
+        }
+
+        // in-place operation on a transposed view with float result
+        MultiArray<3, float> fin(in), fres(shape);
+        multiGrayscaleBoxErosion(in.transpose(), fres.transpose(), radius);
+        multiGrayscaleBoxErosion(fin.transpose(), fin.transpose(), radius);
+        shouldEqualSequence(fres.begin(), fres.end(), fin.begin());
+        for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+            shouldEqual(fres[*p], (float)bruteForceMorphology(in, *p, -Shape(5,0,3), Shape(5,0,3),
+                                                               detail::MorphologyMinimum()));
+
+        // scalar radius equals the window size in all dimensions
+        multiGrayscaleBoxDilation(in, di, 2);
+        for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+            shouldEqual(di[*p], bruteForceMorphology(in, *p, Shape(-2), Shape(2), detail::MorphologyMaximum()));
+    }
+
+    void lineMorphologyTest3D()
+    {
+        typedef MultiArray<3, float> Volume;
+        typedef Volume::difference_type Shape;
+        Shape shape(23, 18, 15);
+
+        Volume in(shape), res(shape);
+        for(int k=0; k<in.size(); ++k)
+            in[k] = (float)randomMT19937().uniform();
+
+        Shape directions[] = { Shape(0, 1, 0), Shape(1, 1, 0), Shape(1, -1, 1), Shape(2, 0, -1) };
+        for(int d=0; d<4; ++d)
+        {
+            int radius = 4;
+            multiGrayscaleLineErosion(in, res, directions[d], radius);
+            for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+            {
+                float ref = in[*p];
+                for(int k=-radius; k<=radius; ++k)
+                    if(in.isInside(*p + k*directions[d]))
+                        ref = std::min(ref, in[*p + k*directions[d]]);
+                shouldEqual(res[*p], ref);
+            }
+
+            multiGrayscaleLineDilation(in, res, directions[d], radius);
+            for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+            {
+                float ref = in[*p];
+                for(int k=-radius; k<=radius; ++k)
+                    if(in.isInside(*p + k*directions[d]))
+                        ref = std::max(ref, in[*p + k*directions[d]]);
+                shouldEqual(res[*p], ref);
+            }
+        }
+
+        try
+        {
+            multiGrayscaleLineErosion(in, res, Shape(), 3);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &)
+        {}
+    }
+
+    void bitMorphologyTest3D()
+    {
+        typedef MultiArray<3, UInt8> Volume;
+        typedef Volume::difference_type Shape;
+        Shape shape(150, 13, 9);
+
+        Volume in(shape), res(shape), ref(shape);
+        for(int k=0; k<in.size(); ++k)
+            in[k] = randomMT19937().uniform() < 0.7 ? 1 : 0;
+
+        MultiBitArray<3> bits(in), out(shape);
+        shouldEqual(bits.words().shape(), Shape(3, 13, 9));
+        bits.unpack(res);
+        shouldEqualSequence(res.begin(), res.end(), in.begin());
+        shouldEqual(bits.count(), (MultiArrayIndex)std::count(in.begin(), in.end(), 1));
+
+        Shape radii[] = { Shape(2, 1, 3), Shape(0, 2, 0), Shape(70, 0, 1), Shape(200, 20, 20) };
+        for(int r=0; r<4; ++r)
+        {
+            multiBinaryBoxErosion(bits, out, radii[r]);
+            out.unpack(res);
+            multiGrayscaleBoxErosion(in, ref, radii[r]);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiBinaryBoxDilation(bits, out, radii[r]);
+            out.unpack(res);
+            multiGrayscaleBoxDilation(in, ref, radii[r]);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiBinaryBoxOpening(bits, out, radii[r]);
+            out.unpack(res);
+            multiGrayscaleBoxOpening(in, ref, radii[r]);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiBinaryBoxClosing(bits, out, radii[r]);
+            out.unpack(res);
+            multiGrayscaleBoxClosing(in, ref, radii[r]);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+        }
+
+        // in-place operation
+        out = bits;
+        multiBinaryBoxErosion(out, out, 3);
+        out.unpack(res);
+        multiGrayscaleBoxErosion(in, ref, 3);
+        shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+        ArrayVector<Shape> hits, misses;
+        hits.push_back(Shape(0, 0, 0));
+        hits.push_back(Shape(65, -1, 0));
+        misses.push_back(Shape(-1, 0, 1));
+        misses.push_back(Shape(3, 2, -2));
+        multiBinaryHitOrMiss(bits, out, hits, misses);
+        for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+        {
+            bool expected = true;
+            for(unsigned int k=0; k<hits.size(); ++k)
+                expected = expected && in.isInside(*p + hits[k]) && in[*p + hits[k]] == 1;
+            for(unsigned int k=0; k<misses.size(); ++k)
+                expected = expected && !(in.isInside(*p + misses[k]) && in[*p + misses[k]] == 1);
+            shouldEqual(out[*p], expected);
+        }
+        multiBinaryHitOrMiss(bits, bits, hits, misses);
+        should(bits == out);
+    }
+
+    template <class Array, class Shape>
+    typename Array::value_type
+    bruteForceRank(Array const & a, Shape const & p, Shape const & radius, double rank)
+    {
+        std::vector<typename Array::value_type> values;
+        for(MultiCoordinateIterator<Shape::static_size> q(2*radius + Shape(1)), end = q.getEndIterator(); q != end; ++q)
+        {
+            Shape r(p - radius + *q);
+            if(a.isInside(r))
+                values.push_back(a[r]);
+        }
+        std::sort(values.begin(), values.end());
+        int target = std::max(1, (int)std::ceil(rank*values.size()));
+        return values[target - 1];
+    }
+
+    void rankFilterTest()
+    {
+        {
+            typedef MultiArray<2, UInt8> Image;
+            typedef Image::difference_type Shape;
+            Shape shape(37, 29), radius(4, 2);
+
+            Image in(shape), res(shape);
+            for(int k=0; k<in.size(); ++k)
+                in[k] = (UInt8)randomMT19937().uniformInt(256);
+
+            double ranks[] = { 0.0, 0.2, 0.5, 1.0 };
+            for(int r=0; r<4; ++r)
+            {
+                multiRankOrderFilter(in, res, radius, ranks[r]);
+                for(MultiCoordinateIterator<2> p(shape), end = p.getEndIterator(); p != end; ++p)
+                    shouldEqual(res[*p], bruteForceRank(in, *p, radius, ranks[r]));
+            }
+
+            // in-place operation
+            res = in;
+            multiMedianFilter(res, res, 3);
+            for(MultiCoordinateIterator<2> p(shape), end = p.getEndIterator(); p != end; ++p)
+                shouldEqual(res[*p], bruteForceRank(in, *p, Shape(3), 0.5));
+        }
+        {
+            typedef MultiArray<3, UInt16> Volume;
+            typedef Volume::difference_type Shape;
+            // wider than one strip of 16-bit columns
+            Shape shape(150, 12, 7), radius(10, 3, 2);
+
+            Volume in(shape);
+            MultiArray<3, float> res(shape);
+            for(int k=0; k<in.size(); ++k)
+                in[k] = (UInt16)randomMT19937().uniformInt(1000*(k % 7) + 1);
+
+            multiMedianFilter(in, res, radius);
+            for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+                shouldEqual(res[*p], (float)bruteForceRank(in, *p, radius, 0.5));
+
+            multiRankOrderFilter(in.transpose(), res.transpose(), radius, 0.9);
+            for(MultiCoordinateIterator<3> p(shape), end = p.getEndIterator(); p != end; ++p)
+                shouldEqual(res[*p], (float)bruteForceRank(in, *p, Shape(2, 3, 10), 0.9));
+        }
+        {
+            typedef MultiArray<2, UInt8> Image;
+            typedef Image::difference_type Shape;
+            Shape shape(23, 17), radius(3, 2);
+
+            Image in(shape);
+            for(int k=0; k<in.size(); ++k)
+                in[k] = (UInt8)randomMT19937().uniformInt(256);
+
+            // source and destination overlap partially, and the destination is a
+            // reversed view (negative strides) covering rows 9...25 of the buffer
+            Image data(Shape(shape[0], 2*shape[1]));
+            MultiArrayView<2, UInt8> src = data.subarray(Shape(), shape);
+            src = in;
+            MultiArrayView<2, UInt8, StridedArrayTag>
+                reversed(shape, -data.stride(), &data(shape[0] - 1, 25));
+            multiMedianFilter(src, reversed, radius);
+            for(MultiCoordinateIterator<2> p(shape), end = p.getEndIterator(); p != end; ++p)
+                shouldEqual(reversed[*p], bruteForceRank(in, *p, radius, 0.5));
+        }
+        {
+            MultiArray<1, UInt8> in(Shape1(20)), res(Shape1(20));
+            for(int k=0; k<in.size(); ++k)
+                in[k] = (UInt8)(k*37 % 11);
+            multiMedianFilter(in, res, 2);
+            for(int k=0; k<in.size(); ++k)
+                shouldEqual(res[k], bruteForceRank(in, Shape1(k), Shape1(2), 0.5));
+        }
+    }
+
+    template <unsigned int N, class T, class Compare>
+    void
+    bruteForceReconstruction(MultiArray<N, T> const & marker, MultiArray<N, T> const & mask,
+                             MultiArray<N, T> & res, NeighborhoodType neighborhood,
+                             Compare compare)
+    {
+        typedef GridGraph<N, undirected_tag> Graph;
+        Graph g(mask.shape(), neighborhood);
+        res = marker;
+        for(typename Graph::NodeIt p(g); p != lemon::INVALID; ++p)
+            if(compare(mask[*p], res[*p]))
+                res[*p] = mask[*p];
+        // iterate geodesic dilations until stability
+        bool changed = true;
+        while(changed)
+        {
+            changed = false;
+            MultiArray<N, T> old(res);
+            for(typename Graph::NodeIt p(g); p != lemon::INVALID; ++p)
+            {
+                T v = old[*p];
+                for(typename Graph::OutArcIt a(g, p); a != lemon::INVALID; ++a)
+                    if(compare(v, old[g.target(*a)]))
+                        v = old[g.target(*a)];
+                if(compare(mask[*p], v))
+                    v = mask[*p];
+                if(v != res[*p])
+                {
+                    res[*p] = v;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    void reconstructionTest()
+    {
+        {
+            typedef MultiArray<2, int> Image;
+            Shape2 shape(23, 17);
+            Image mask(shape), marker(shape), res(shape), ref(shape);
+            for(int k=0; k<mask.size(); ++k)
+            {
+                mask[k] = randomMT19937().uniformInt(100);
+                marker[k] = randomMT19937().uniformInt(10) == 0
+                                ? randomMT19937().uniformInt(100)
+                                : 0;
+            }
+
+            NeighborhoodType neighborhoods[] = { DirectNeighborhood, IndirectNeighborhood };
+            for(int n=0; n<2; ++n)
+            {
+                multiReconstructionByDilation(marker, mask, res, neighborhoods[n]);
+                bruteForceReconstruction(marker, mask, ref, neighborhoods[n], std::less<int>());
+                should(res == ref);
+
+                multiReconstructionByErosion(marker, mask, res, neighborhoods[n]);
+                bruteForceReconstruction(marker, mask, ref, neighborhoods[n], std::greater<int>());
+                should(res == ref);
+            }
+
+            // h-maxima, in-place
+            marker = mask;
+            marker -= 20;
+            res = marker;
+            multiReconstructionByDilation(res, mask, res);
+            bruteForceReconstruction(marker, mask, ref, DirectNeighborhood, std::less<int>());
+            should(res == ref);
+        }
+        {
+            // fill the holes of a 3D binary volume
+            typedef MultiArray<3, UInt8> Volume;
+            Shape3 shape(9, 8, 7);
+            Volume in(shape), marker(shape, 1), res(shape), ref(shape);
+            in.subarray(Shape3(1,1,1), Shape3(8,7,6)) = 1;
+            in.subarray(Shape3(2,2,2), Shape3(7,6,5)) = 0;
+            in(4,4,3) = 1;
+            in.subarray(Shape3(0,0,0), Shape3(9,1,7)) = 1;
+            marker.bindOuter(0) = in.bindOuter(0);
+            marker.bindOuter(6) = in.bindOuter(6);
+            marker.bind<0>(0) = in.bind<0>(0);
+            marker.bind<0>(8) = in.bind<0>(8);
+            marker.bind<1>(0) = in.bind<1>(0);
+            marker.bind<1>(7) = in.bind<1>(7);
+
+            multiReconstructionByErosion(marker, in, res);
+            ref = in;
+            ref.subarray(Shape3(2,2,2), Shape3(7,6,5)) = 1;
+            should(res == ref);
+        }
+    }
+
+    template <unsigned int N, class T>
+    void
+    bruteForceAreaOpening(MultiArray<N, T> const & in, MultiArray<N, T> & res,
+                          MultiArrayIndex minArea, NeighborhoodType neighborhood)
+    {
+        // threshold decomposition: the result is the highest level at which
+        // the element belongs to a large enough component
+        res.init(*argMin(in.begin(), in.end()));
+        MultiArray<N, UInt8> level(in.shape());
+        MultiArray<N, int> labels(in.shape());
+        for(int t = (int)res[0] + 1; t <= (int)*argMax(in.begin(), in.end()); ++t)
+        {
+            for(int k=0; k<in.size(); ++k)
+                level[k] = in[k] >= t ? 1 : 0;
+            int count = labelMultiArrayWithBackground(level, labels, neighborhood);
+            std::vector<MultiArrayIndex> areas(count+1);
+            for(int k=0; k<in.size(); ++k)
+                ++areas[labels[k]];
+            for(int k=0; k<in.size(); ++k)
+                if(labels[k] > 0 && areas[labels[k]] >= minArea)
+                    res[k] = (T)t;
+        }
+    }
+
+    void componentTreeTest()
+    {
+        {
+            typedef MultiArray<2, UInt8> Image;
+            Shape2 shape(31, 23);
+            Image in(shape), res(shape), ref(shape), inverted(shape);
+            for(int k=0; k<in.size(); ++k)
+                in[k] = (UInt8)randomMT19937().uniformInt(12);
+
+            NeighborhoodType neighborhoods[] = { DirectNeighborhood, IndirectNeighborhood };
+            MultiArrayIndex areas[] = { 1, 3, 10, 50 };
+            for(int n=0; n<2; ++n)
+            {
+                for(int a=0; a<4; ++a)
+                {
+                    multiAreaOpening(in, res, areas[a], neighborhoods[n]);
+                    bruteForceAreaOpening(in, ref, areas[a], neighborhoods[n]);
+                    should(res == ref);
+
+                    // closing is the dual of opening
+                    for(int k=0; k<in.size(); ++k)
+                        inverted[k] = 255 - in[k];
+                    multiAreaClosing(inverted, res, areas[a], neighborhoods[n]);
+                    for(int k=0; k<in.size(); ++k)
+                        shouldEqual(res[k], 255 - ref[k]);
+                }
+            }
+        }
+        {
+            // attributes of a known configuration
+            MultiArray<3, int> in(Shape3(10, 8, 6));
+            in.subarray(Shape3(1,2,1), Shape3(5,6,3)) = 4;
+            in.subarray(Shape3(2,3,1), Shape3(3,4,2)) = 9;
+            in.subarray(Shape3(7,1,1), Shape3(9,2,5)) = 2;
+
+            ComponentTree<3, int> tree(in);
+            shouldEqual(tree.size(), in.size());
+            shouldEqual(tree.level(tree.root()), 0);
+            shouldEqual(tree.area(tree.root()), in.size());
+            shouldEqual(tree.boundingBoxBegin(tree.root()), Shape3(0));
+            shouldEqual(tree.boundingBoxEnd(tree.root()), in.shape());
+            shouldEqual(tree.contrast(tree.root()), 9);
+
+            MultiArrayIndex plateau = tree.parent(2 + 3*10 + 1*80);
+            shouldEqual(tree.level(plateau), 4);
+            shouldEqual(tree.area(plateau), 32);
+            shouldEqual(tree.boundingBoxBegin(plateau), Shape3(1,2,1));
+            shouldEqual(tree.boundingBoxEnd(plateau), Shape3(5,6,3));
+            shouldEqual(tree.contrast(plateau), 5);
+            shouldEqual(tree.level(tree.parent(plateau)), 0);
+
+            MultiArrayIndex bar = tree.canonical(7 + 1*10 + 1*80);
+            shouldEqual(tree.level(bar), 2);
+            shouldEqual(tree.area(bar), 8);
+            shouldEqual(tree.boundingBoxEnd(bar) - tree.boundingBoxBegin(bar), Shape3(2,1,4));
+            shouldEqual(tree.contrast(bar), 0);
+            shouldEqual(tree.parent(bar), tree.root());
+
+            // min-tree of the same array
+            ComponentTree<3, int, std::less<int> > minTree(in);
+            shouldEqual(minTree.level(minTree.root()), 9);
+            shouldEqual(minTree.contrast(minTree.root()), 9);
+            shouldEqual(minTree.area(minTree.canonical(0)), in.size() - 32 - 8);
+        }
+    }
+
     IntImage img, img2, lin;
     IntVolume vol;
 };
@@ -309,6 +753,12 @@ struct MorphologyTestSuite
         add( testCase( &MultiMorphologyTest::grayDilationTest2D));
         add( testCase( &MultiMorphologyTest::grayErosionAndDilationTest2D));
         add( testCase( &MultiMorphologyTest::grayClosingTest2D));
+        add( testCase( &MultiMorphologyTest::boxMorphologyTest3D));
+        add( testCase( &MultiMorphologyTest::lineMorphologyTest3D));
+        add( testCase( &MultiMorphologyTest::bitMorphologyTest3D));
+        add( testCase( &MultiMorphologyTest::rankFilterTest));
+        add( testCase( &MultiMorphologyTest::reconstructionTest));
+        add( testCase( &MultiMorphologyTest::componentTreeTest));
     }
 };
 
@@ -0,0 +1,321 @@
+/************************************************************************/
+/*                                                                      */
+/*                 Copyright 2014 by Ullrich Koethe                     */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#include <iostream>
+#include <map>
+#include <vector>
+#include "vigra/unittest.hxx"
+#include "vigra/region_adjacency_graph.hxx"
+#include "vigra/hierarchical_clustering.hxx"
+#include "vigra/accumulator.hxx"
+#include "vigra/random.hxx"
+
+using namespace vigra;
+using namespace vigra::acc;
+
+struct RegionAdjacencyGraphTest
+{
+    typedef AccumulatorChain<double, Select<Count, Mean, Minimum, Maximum,
+                                            StandardQuantiles<AutoRangeHistogram<16> > > > EdgeFeatures;
+    typedef AccumulatorChain<double, Select<Count, Mean, Minimum, Maximum> > SimpleEdgeFeatures;
+
+    void testSmallGraph()
+    {
+        static const int in[] = { 1, 1, 2, 2,
+                                  1, 1, 2, 2,
+                                  3, 3, 4, 4,
+                                  3, 3, 4, 4 };
+        MultiArrayView<2, int> labels(Shape2(4, 4), const_cast<int*>(in));
+        MultiArray<2, double> data(labels.shape());
+        for(int k=0; k<data.size(); ++k)
+            data[k] = k;
+
+        RegionAdjacencyGraph<SimpleEdgeFeatures> rag(labels, data);
+        shouldEqual(rag.nodeCount(), 5);
+        shouldEqual(rag.edgeCount(), 4);
+        shouldEqual(rag.degree(0), 0);
+        shouldEqual(rag.degree(1), 2);
+        shouldEqual(rag.neighbor(1, 0), 2);
+        shouldEqual(rag.neighbor(1, 1), 3);
+        shouldEqual(rag.findEdge(2, 3), -1);
+        shouldEqual(rag.findEdge(0, 1), -1);
+
+        MultiArrayIndex e = rag.findEdge(2, 1);
+        should(e >= 0);
+        shouldEqual(rag.u(e), 1);
+        shouldEqual(rag.v(e), 2);
+        shouldEqual(rag.neighborEdge(1, 0), e);
+        // pairs (1,2) and (5,6)
+        shouldEqual(get<Count>(rag.edgeFeatures(e)), 2.0);
+        shouldEqualTolerance(get<Mean>(rag.edgeFeatures(e)), 3.5, 1e-14);
+        shouldEqual(get<Minimum>(rag.edgeFeatures(e)), 1.5);
+        shouldEqual(get<Maximum>(rag.edgeFeatures(e)), 5.5);
+
+        // the indirect neighborhood adds the diagonal edge 1-4 and 2-3
+        RegionAdjacencyGraph<SimpleEdgeFeatures> rag8(labels, data, IndirectNeighborhood);
+        shouldEqual(rag8.edgeCount(), 6);
+        e = rag8.findEdge(3, 2);
+        shouldEqual(get<Count>(rag8.edgeFeatures(e)), 1.0);
+        shouldEqual(get<Mean>(rag8.edgeFeatures(e)), 7.5);
+        shouldEqual(get<Count>(rag8.edgeFeatures(rag8.findEdge(1, 2))), 4.0);
+    }
+
+    void testRandomGraph()
+    {
+        MultiArray<3, UInt32> labels(Shape3(17, 13, 11));
+        MultiArray<3, float> data(labels.shape());
+        RandomMT19937 random(42);
+        for(int k=0; k<labels.size(); ++k)
+        {
+            labels[k] = random.uniformInt(30) + 2;
+            data[k] = (float)random.uniform();
+        }
+
+        // brute force edge samples
+        typedef std::map<std::pair<MultiArrayIndex, MultiArrayIndex>, std::vector<double> > Samples;
+        Samples samples;
+        GridGraph<3, undirected_tag> graph(labels.shape(), IndirectNeighborhood);
+        for(GridGraph<3, undirected_tag>::EdgeIt edge(graph); edge != lemon::INVALID; ++edge)
+        {
+            Shape3 p = graph.u(*edge), q = graph.v(*edge);
+            if(labels[p] == labels[q])
+                continue;
+            std::pair<MultiArrayIndex, MultiArrayIndex> key(std::min(labels[p], labels[q]),
+                                                            std::max(labels[p], labels[q]));
+            samples[key].push_back((float)(0.5*(data[p] + data[q])));
+        }
+
+        for(int threads=0; threads<5; threads+=4)
+        {
+            RegionAdjacencyGraph<EdgeFeatures> rag(labels, data, IndirectNeighborhood,
+                                                   ParallelOptions(threads));
+            shouldEqual(rag.nodeCount(), 32);
+            shouldEqual(rag.edgeCount(), (MultiArrayIndex)samples.size());
+            shouldEqual(rag.degree(0), 0);
+            shouldEqual(rag.degree(1), 0);
+
+            MultiArrayIndex e = 0, degrees = 0;
+            for(Samples::iterator i = samples.begin(); i != samples.end(); ++i, ++e)
+            {
+                shouldEqual(rag.u(e), i->first.first);
+                shouldEqual(rag.v(e), i->first.second);
+                shouldEqual(rag.findEdge(i->first.second, i->first.first), e);
+
+                std::vector<double> const & s = i->second;
+                double sum = 0.0;
+                for(std::size_t k=0; k<s.size(); ++k)
+                    sum += s[k];
+                EdgeFeatures const & f = rag.edgeFeatures(e);
+                shouldEqual(get<Count>(f), (double)s.size());
+                shouldEqualTolerance(get<Mean>(f), sum / s.size(), 1e-12);
+                shouldEqual(get<Minimum>(f), *std::min_element(s.begin(), s.end()));
+                shouldEqual(get<Maximum>(f), *std::max_element(s.begin(), s.end()));
+                should(get<StandardQuantiles<AutoRangeHistogram<16> > >(f)[3] >= get<Minimum>(f));
+                should(get<StandardQuantiles<AutoRangeHistogram<16> > >(f)[3] <= get<Maximum>(f));
+            }
+            for(MultiArrayIndex n=0; n<rag.nodeCount(); ++n)
+            {
+                degrees += rag.degree(n);
+                for(MultiArrayIndex k=1; k<rag.degree(n); ++k)
+                    should(rag.neighbor(n, k-1) < rag.neighbor(n, k));
+            }
+            shouldEqual(degrees, 2*rag.edgeCount());
+        }
+    }
+    void testConstantBoundary()
+    {
+        typedef AccumulatorChain<double, Select<Count, Mean,
+                                                StandardQuantiles<UserRangeHistogram<16> > > > QuantileFeatures;
+        static const int in[] = { 1, 1, 2, 2,
+                                  1, 1, 2, 2,
+                                  3, 3, 3, 3 };
+        MultiArrayView<2, int> labels(Shape2(4, 3), const_cast<int*>(in));
+        // the boundary 1-2 is constant, the boundaries to 3 vary
+        MultiArray<2, double> data(labels.shape(), 4.0);
+        data(0, 2) = 1.0;
+        data(3, 2) = 7.0;
+
+        QuantileFeatures prototype;
+        prototype.setHistogramOptions(HistogramOptions().setMinMax(0.0, 8.0));
+        RegionAdjacencyGraph<QuantileFeatures> rag(labels, data, DirectNeighborhood,
+                                                   ParallelOptions(), prototype);
+        shouldEqual(rag.edgeCount(), 3);
+
+        QuantileFeatures const & f = rag.edgeFeatures(rag.findEdge(1, 2));
+        shouldEqual(get<Count>(f), 2.0);
+        shouldEqual(get<Mean>(f), 4.0);
+        shouldEqualTolerance(get<StandardQuantiles<UserRangeHistogram<16> > >(f)[3], 4.0, 0.5);
+
+        // samples (4+1)/2 and (4+4)/2
+        QuantileFeatures const & g = rag.edgeFeatures(rag.findEdge(1, 3));
+        shouldEqual(get<Count>(g), 2.0);
+        shouldEqual(get<Mean>(g), 3.25);
+        should(get<StandardQuantiles<UserRangeHistogram<16> > >(g)[0] >= 2.0);
+        should(get<StandardQuantiles<UserRangeHistogram<16> > >(g)[6] <= 4.5);
+    }
+
+    struct MeanWeight
+    {
+        double operator()(SimpleEdgeFeatures const & f) const
+        {
+            return get<Mean>(f);
+        }
+    };
+
+    void testClustering()
+    {
+        MultiArray<2, UInt32> labels(Shape2(23, 19));
+        MultiArray<2, float> data(labels.shape());
+        RandomMT19937 random(17);
+        for(int k=0; k<labels.size(); ++k)
+        {
+            labels[k] = random.uniformInt(40) + 1;
+            data[k] = (float)random.uniform();
+        }
+
+        RegionAdjacencyGraph<SimpleEdgeFeatures> rag(labels, data);
+        typedef HierarchicalClustering<SimpleEdgeFeatures, MeanWeight> Clustering;
+        Clustering clustering(rag);
+        shouldEqual(clustering.clusterCount(), rag.nodeCount());
+        shouldEqual(clustering.activeEdgeCount(), rag.edgeCount());
+
+        // brute force: the weight between two clusters is the mean over
+        // all boundary samples between them
+        typedef std::pair<MultiArrayIndex, MultiArrayIndex> Key;
+        typedef std::map<Key, std::pair<double, double> > Boundaries; // (count, sum)
+        Boundaries boundaries;
+        for(MultiArrayIndex e=0; e<rag.edgeCount(); ++e)
+        {
+            SimpleEdgeFeatures const & f = rag.edgeFeatures(e);
+            boundaries[Key(rag.u(e), rag.v(e))] =
+                std::make_pair(get<Count>(f), get<Count>(f)*get<Mean>(f));
+        }
+        std::vector<MultiArrayIndex> cluster(rag.nodeCount());
+        for(MultiArrayIndex n=0; n<rag.nodeCount(); ++n)
+            cluster[n] = n;
+
+        double threshold = 0.5;
+        clustering.cluster(threshold);
+
+        std::size_t steps = 0;
+        for(;; ++steps)
+        {
+            Boundaries::iterator best = boundaries.end();
+            for(Boundaries::iterator i = boundaries.begin(); i != boundaries.end(); ++i)
+                if(best == boundaries.end() ||
+                   i->second.second / i->second.first < best->second.second / best->second.first)
+                    best = i;
+            if(best == boundaries.end() || best->second.second / best->second.first > threshold)
+                break;
+
+            should(steps < clustering.merges().size());
+            Clustering::MergeStep const & step = clustering.merges()[steps];
+            shouldEqual(std::min(step.u, step.v), best->first.first);
+            shouldEqual(std::max(step.u, step.v), best->first.second);
+            shouldEqualTolerance(step.weight, best->second.second / best->second.first, 1e-12);
+
+            // merge the larger representative into the smaller one
+            MultiArrayIndex root = best->first.first, other = best->first.second;
+            for(std::size_t n=0; n<cluster.size(); ++n)
+                if(cluster[n] == other)
+                    cluster[n] = root;
+            Boundaries merged;
+            for(Boundaries::iterator i = boundaries.begin(); i != boundaries.end(); ++i)
+            {
+                MultiArrayIndex a = cluster[i->first.first], b = cluster[i->first.second];
+                if(a == b)
+                    continue;
+                std::pair<double, double> & m = merged[Key(std::min(a, b), std::max(a, b))];
+                m.first  += i->second.first;
+                m.second += i->second.second;
+            }
+            boundaries.swap(merged);
+        }
+        should(steps > 0);
+        shouldEqual(steps, clustering.merges().size());
+        shouldEqual(clustering.clusterCount(), rag.nodeCount() - (MultiArrayIndex)steps);
+        shouldEqual(clustering.activeEdgeCount(), (MultiArrayIndex)boundaries.size());
+
+        for(MultiArrayIndex e=0; e<rag.edgeCount(); ++e)
+        {
+            MultiArrayIndex a = clustering.find(rag.u(e)), b = clustering.find(rag.v(e));
+            if(a == b)
+            {
+                should(!clustering.isActive(e));
+                continue;
+            }
+            if(!clustering.isActive(e))
+                continue;
+            Boundaries::iterator i = boundaries.find(Key(std::min(a, b), std::max(a, b)));
+            should(i != boundaries.end());
+            shouldEqualTolerance(clustering.edgeWeight(e), i->second.second / i->second.first, 1e-12);
+            shouldEqual(get<Count>(clustering.edgeFeatures(e)), i->second.first);
+        }
+
+        MultiArray<2, UInt32> clustered(labels);
+        clustering.relabel(clustered);
+        for(int k=0; k<labels.size(); ++k)
+            shouldEqual(clustered[k], (UInt32)cluster[labels[k]]);
+
+        // further merging stops at the requested number of clusters
+        clustering.cluster(NumericTraits<double>::max(), 5);
+        shouldEqual(clustering.clusterCount(), 5);
+        shouldEqual(clustering.merges().size(), (std::size_t)rag.nodeCount() - 5);
+    }
+};
+
+struct RegionAdjacencyGraphTestSuite
+: public vigra::test_suite
+{
+    RegionAdjacencyGraphTestSuite()
+    : vigra::test_suite("RegionAdjacencyGraphTestSuite")
+    {
+        add( testCase( &RegionAdjacencyGraphTest::testSmallGraph));
+        add( testCase( &RegionAdjacencyGraphTest::testRandomGraph));
+        add( testCase( &RegionAdjacencyGraphTest::testConstantBoundary));
+        add( testCase( &RegionAdjacencyGraphTest::testClustering));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    RegionAdjacencyGraphTestSuite test;
+
+    int failed = test.run(vigra::testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+    return (failed != 0);
+}
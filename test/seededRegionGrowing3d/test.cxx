@@ -39,6 +39,7 @@
 #include "vigra/unittest.hxx"
 
 #include "vigra/seededregiongrowing3d.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -287,6 +288,37 @@ struct SeededRegionGrowing3DTest
         shouldEqualSequence(res.begin(), res.end(), vol3.begin());
     }
     
+    void bucketQueueTest()
+    {
+        // integral costs are sorted into buckets, which must give the
+        // same result as the heap used for real-valued costs
+        MultiArray<3, UInt16> data(Shape3(13, 11, 9));
+        RandomMT19937 random(42);
+        for(int k=0; k<data.size(); ++k)
+            data[k] = (UInt16)random.uniformInt(20);
+        MultiArray<3, double> ddata(data);
+
+        IntVolume seeds(data.shape());
+        seeds(1, 1, 1) = 1;
+        seeds(11, 2, 7) = 2;
+        seeds(6, 9, 4) = 3;
+        seeds(2, 8, 8) = 4;
+
+        for(int k=0; k<2; ++k)
+        {
+            SRGType srgType = k == 0 ? CompleteGrow : KeepContours;
+            IntVolume res(data.shape()), res2(data.shape());
+
+            vigra::ArrayOfRegionStatistics<SeedRgDirectValueFunctor<UInt16> > cost(4);
+            seededRegionGrowing3D(data, seeds, res, cost, srgType);
+
+            vigra::ArrayOfRegionStatistics<DirectCostFunctor> dcost(4);
+            seededRegionGrowing3D(ddata, seeds, res2, dcost, srgType);
+
+            should(res == res2);
+        }
+    }
+
     IntVolume    vol1;
     DoubleVolume vol2;
     IntVolume    vol3;
@@ -305,6 +337,7 @@ struct SeededRegionGrowing3DTestSuite
         add( testCase( &SeededRegionGrowing3DTest::voronoiTest));
         add( testCase( &SeededRegionGrowing3DTest::voronoiTestWithBorder));
         add( testCase( &SeededRegionGrowing3DTest::simpleTest));
+        add( testCase( &SeededRegionGrowing3DTest::bucketQueueTest));
     }
 };
 
@@ -118,6 +118,21 @@ struct SlicTest
 
         should(labels == labels_ref);
     }
+
+    void test_slic_parallel()
+    {
+        IArray labels_ref(lennaImage.shape());
+        importImage(ImageImportInfo("slic.xv"), destImage(labels_ref));
+
+        int seedDistance = 8;
+        for(int threads=0; threads<=8; ++threads)
+        {
+            IArray labels(lennaImage.shape());
+            slicSuperpixels(lennaImage, labels, 20.0, seedDistance, 
+                            SlicOptions().minSize(0).iterations(40).numThreads(threads));
+            should(labels == labels_ref);
+        }
+    }
 };
 
 
@@ -129,6 +144,7 @@ struct Slic2dTestSuite
     {
         add( testCase( &SlicTest<2>::test_seeding));
         add( testCase( &SlicTest<2>::test_slic));
+        add( testCase( &SlicTest<2>::test_slic_parallel));
     }
 };
 
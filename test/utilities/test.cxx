@@ -371,6 +371,45 @@ struct BucketQueueTest
         shouldEqual(0u, bqueue.size());
         shouldEqual(true, bqueue.empty());        
     }
+
+    void testChangeable()
+    {
+        ChangeablePriorityQueue<double> queue(data.size()+2);
+        ChangeablePriorityQueue<double, true> aqueue(data.size()+2);
+        for(unsigned int k=0; k<data.size(); ++k)
+        {
+            queue.push(k, data[k]);
+            aqueue.push(k, data[k]);
+        }
+        shouldEqual(data.size(), queue.size());
+        shouldEqual(2, queue.top());
+        shouldEqual(12.2, queue.topPriority());
+        shouldEqual(0, aqueue.top());
+
+        // decrease, increase, and delete
+        queue.changePriority(2, 0.5);
+        aqueue.changePriority(2, 0.5);
+        queue.push(1, 20.0);
+        aqueue.push(0, 5.0);
+        queue.remove(5);
+        aqueue.remove(5);
+        queue.remove(5);
+        should(!queue.contains(5));
+        should(queue.contains(4));
+        shouldEqual(data.size()-1, queue.size());
+
+        static const int desc[] = { 1, 4, 3, 0, 2 };
+        static const int asc[]  = { 2, 3, 4, 1, 0 };
+        for(unsigned int k=0; k<data.size()-1; ++k)
+        {
+            shouldEqual(desc[k], queue.top());
+            shouldEqual(asc[k], aqueue.top());
+            queue.pop();
+            aqueue.pop();
+        }
+        should(queue.empty());
+        should(aqueue.empty());
+    }
 };
 
 struct SizedIntTest
@@ -487,6 +526,7 @@ struct UtilitiesTestSuite
         add( testCase( &BucketQueueTest::testAscending));
         add( testCase( &BucketQueueTest::testDescendingMapped));
         add( testCase( &BucketQueueTest::testAscendingMapped));
+        add( testCase( &BucketQueueTest::testChangeable));
         add( testCase( &SizedIntTest::testSizedInt));
         add( testCase( &MetaprogrammingTest::testInt));
         add( testCase( &MetaprogrammingTest::testLogic));
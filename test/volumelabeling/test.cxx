@@ -40,6 +40,8 @@
 
 #include "vigra/labelvolume.hxx"
 #include "vigra/multi_labeling.hxx"
+#include "vigra/random.hxx"
+#include <map>
 
 using namespace vigra;
 
@@ -447,6 +449,68 @@ struct VolumeLabelingTest
         shouldEqualSequence(res.begin(), res.end(), out6);
     }
 
+    // two labelings are equal up to renumbering
+    template <class Array>
+    static bool samePartition(Array const & a, Array const & b)
+    {
+        std::map<int, int> ab, ba;
+        for(int k=0; k<a.size(); ++k)
+        {
+            if(ab.insert(std::make_pair(a[k], b[k])).first->second != b[k] ||
+               ba.insert(std::make_pair(b[k], a[k])).first->second != a[k])
+                return false;
+        }
+        return true;
+    }
+
+    void labelingBlockwiseTest()
+    {
+        MultiArray<3, int> data(Shape3(23, 17, 11));
+        RandomMT19937 random(42);
+        for(int k=0; k<data.size(); ++k)
+            data[k] = random.uniformInt(3);
+
+        MultiArray<3, int> res(data.shape()), res2(data.shape());
+        for(int n=0; n<2; ++n)
+        {
+            NeighborhoodType neighborhood = n == 0 ? DirectNeighborhood : IndirectNeighborhood;
+            BlockwiseLabelOptions<3> options;
+            options.neighborhood(neighborhood).blockShape(Shape3(5, 4, 3)).numThreads(4);
+
+            int count = labelMultiArray(data, res, neighborhood);
+            shouldEqual(labelMultiArrayBlockwise(data, res2, options), count);
+            should(samePartition(res, res2));
+            shouldEqual(*argMax(res2.begin(), res2.end()), count);
+
+            count = labelMultiArrayWithBackground(data, res, neighborhood, 1);
+            res2 = -1;
+            shouldEqual(labelMultiArrayWithBackgroundBlockwise(data, res2, options, 1), count);
+            should(samePartition(res, res2));
+            for(int k=0; k<data.size(); ++k)
+                shouldEqual(res2[k] == 0, data[k] == 1);
+
+            // a single block and unsplit axes reproduce the serial numbering
+            options.blockShape(Shape3(0, 17, -1)).numThreads(ParallelOptions::Serial);
+            shouldEqual(labelMultiArrayWithBackgroundBlockwise(data, res2, options, 1), count);
+            should(res == res2);
+
+            // blocks of width 1 (diagonal links across the high face of the first block)
+            options.blockShape(Shape3(1, 2, 1)).numThreads(4);
+            count = labelMultiArray(data, res, neighborhood);
+            shouldEqual(labelMultiArrayBlockwise(data, res2, options), count);
+            should(samePartition(res, res2));
+        }
+
+        // anti-diagonal line in blocks of width 1
+        MultiArray<2, int> diagonal(Shape2(4, 4)), diagonal_labels(diagonal.shape());
+        for(int k=0; k<4; ++k)
+            diagonal(3-k, k) = 1;
+        BlockwiseLabelOptions<2> options2;
+        options2.neighborhood(IndirectNeighborhood).blockShape(Shape2(1, 4));
+        shouldEqual(labelMultiArrayWithBackground(diagonal, diagonal_labels, IndirectNeighborhood, 0), 1);
+        shouldEqual(labelMultiArrayWithBackgroundBlockwise(diagonal, diagonal_labels, options2, 0), 1);
+    }
+
     IntVolume vol1, vol2, vol3;
     DoubleVolume vol4, vol5, vol6;
 };
@@ -469,6 +533,7 @@ struct VolumeLabelingTestSuite
         add( testCase( &VolumeLabelingTest::labelingTwentySixTest3));
         add( testCase( &VolumeLabelingTest::labelingTwentySixWithBackgroundTest1));
         add( testCase( &VolumeLabelingTest::labelingAllTest));
+        add( testCase( &VolumeLabelingTest::labelingBlockwiseTest));
     }
 };
 
@@ -41,6 +41,7 @@
 #include "vigra/watersheds3d.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/multi_watersheds.hxx"
+#include "vigra/random.hxx"
 #include "list"
 
 #include <stdlib.h>
@@ -473,6 +474,66 @@ struct Watersheds3dTest
         shouldEqual(8, max_region_label);
         should(labelVolume == labelVolume2);
     }
+    void testWatershedsBlockwise()
+    {
+        MultiArray<3, float> data(Shape3(21, 18, 13));
+        RandomMT19937 random(42);
+        for(int k=0; k<data.size(); ++k)
+            data[k] = (float)random.uniform();
+
+        MultiArray<3, int> seeds(data.shape());
+        int count = generateWatershedSeeds(data, seeds, DirectNeighborhood, SeedOptions().minima());
+        should(count > 10);
+
+        WatershedOptions options[] = { WatershedOptions(),
+                                       WatershedOptions().stopAtThreshold(0.7),
+                                       WatershedOptions().biasLabel(3, 0.5) };
+        for(int n=0; n<2; ++n)
+        {
+            NeighborhoodType neighborhood = n == 0 ? DirectNeighborhood : IndirectNeighborhood;
+            for(int k=0; k<3; ++k)
+            {
+                MultiArray<3, int> res(seeds), res2(seeds);
+                int max_region_label = watershedsMultiArray(data, res, neighborhood, options[k]);
+                shouldEqual(watershedsMultiArrayBlockwise(data, res2,
+                                BlockwiseLabelOptions<3>().neighborhood(neighborhood)
+                                                          .blockShape(Shape3(5, 4, 6))
+                                                          .numThreads(4),
+                                options[k]),
+                            max_region_label);
+                should(res == res2);
+            }
+        }
+
+        // automatic seed computation
+        MultiArray<3, int> res(data.shape()), res2(data.shape());
+        watershedsMultiArray(data, res, IndirectNeighborhood,
+                             WatershedOptions().seedOptions(SeedOptions().minima()));
+        watershedsMultiArrayBlockwise(data, res2,
+                                      BlockwiseLabelOptions<3>().neighborhood(IndirectNeighborhood)
+                                                                .blockShape(Shape3(8)),
+                                      WatershedOptions().seedOptions(SeedOptions().minima()));
+        should(res == res2);
+
+        // points that can only be reached at the maximum cost must be labeled as well
+        MultiArray<3, UInt8> ridge(Shape3(7, 1, 1));
+        UInt8 ridge_data[] = { 0, 10, 255, 255, 255, 10, 0 };
+        std::copy(ridge_data, ridge_data + 7, ridge.begin());
+        int ridge_labels[] = { 1, 1, 1, 1, 2, 2, 2 };
+        MultiArray<3, int> ridge_ref(ridge.shape(), ridge_labels);
+        MultiArray<3, int> ridge_res(ridge.shape()), ridge_res2(ridge.shape());
+        ridge_res(0, 0, 0) = ridge_res2(0, 0, 0) = 1;
+        ridge_res(6, 0, 0) = ridge_res2(6, 0, 0) = 2;
+        MultiArray<3, int> ridge_res3(ridge_res2);
+        watershedsMultiArray(ridge, ridge_res, DirectNeighborhood);
+        watershedsMultiArrayBlockwise(ridge, ridge_res2);
+        should(ridge_res == ridge_ref);
+        should(ridge_res2 == ridge_ref);
+        // the tie at the ridge may be broken differently across a block face
+        watershedsMultiArrayBlockwise(ridge, ridge_res3,
+                                      BlockwiseLabelOptions<3>().blockShape(Shape3(2, 1, 1)));
+        should(ridge_res3.all());
+    }
 };
 
 
@@ -488,6 +549,7 @@ struct Watershed3DTestSuite
         add( testCase( &Watersheds3dTest::testWatersheds3dSix2));
         add( testCase( &Watersheds3dTest::testWatersheds3dGradient1));
         add( testCase( &Watersheds3dTest::testWatersheds3dGradient2));
+        add( testCase( &Watersheds3dTest::testWatershedsBlockwise));
     }
 };
 